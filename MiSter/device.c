@@ -0,0 +1,128 @@
+/*
+ * device.c
+ *
+ * Copyright (c) 2020 RetroSpy Technologies
+ */
+
+ /*
+  * This program is free software; you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation; either version 2 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program; if not, write to the Free Software
+  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  * 02110-1301 USA.
+  */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "device.h"
+
+char *axis_names[ABS_MAX + 1] = {
+"X", "Y", "Z", "Rx", "Ry", "Rz", "Throttle", "Rudder",
+"Wheel", "Gas", "Brake", "?", "?", "?", "?", "?",
+"Hat0X", "Hat0Y", "Hat1X", "Hat1Y", "Hat2X", "Hat2Y", "Hat3X", "Hat3Y",
+"?", "?", "?", "?", "?", "?", "?",
+};
+
+char *button_names[KEY_MAX - BTN_MISC + 1] = {
+"Btn0", "Btn1", "Btn2", "Btn3", "Btn4", "Btn5", "Btn6", "Btn7", "Btn8", "Btn9",
+"?", "?", "?", "?", "?", "?","LeftBtn", "RightBtn", "MiddleBtn", "SideBtn", 
+"ExtraBtn", "ForwardBtn", "BackBtn", "TaskBtn", "?", "?", "?", "?", "?", "?", 
+"?", "?", "Trigger", "ThumbBtn", "ThumbBtn2", "TopBtn", "TopBtn2", "PinkieBtn",
+"BaseBtn", "BaseBtn2", "BaseBtn3", "BaseBtn4", "BaseBtn5", "BaseBtn6", 
+"BtnDead", "BtnA", "BtnB", "BtnC", "BtnX", "BtnY", "BtnZ", "BtnTL", "BtnTR", 
+"BtnTL2", "BtnTR2", "BtnSelect", "BtnStart", "BtnMode", "BtnThumbL", 
+"BtnThumbR", "?", "?", "?", "?", "?", "?", "?", "?", "?", "?", "?", "?", "?", 
+"?", "?", "?", "?", "WheelBtn", "Gear up",
+};
+
+uint64_t monotonic_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int device_open(struct device *dev, const char *path)
+{
+	const char *base = strrchr(path, '/');
+
+	memset(dev, 0, sizeof(*dev));
+	strcpy(dev->name, "Unknown");
+	dev->kind = strncmp(base != NULL ? base + 1 : path, "event", 5) == 0 ? DEVICE_EVDEV : DEVICE_JOYSTICK;
+
+	/* The descriptor stays open for the life of the device, reopening it
+	   would replay the driver's init events on every frame. */
+	if ((dev->fd = open(path, O_RDONLY | O_NONBLOCK)) < 0)
+		return -1;
+
+	if ((dev->kind == DEVICE_EVDEV ? evdev_open(dev) : joystick_open(dev)) < 0) {
+		int err = errno;
+		device_close(dev);
+		errno = err;
+		return -1;
+	}
+	return 0;
+}
+
+int device_read(struct device *dev)
+{
+	return dev->kind == DEVICE_EVDEV ? evdev_read(dev) : joystick_read(dev);
+}
+
+void device_describe(const struct device *dev, FILE *out)
+{
+	int i;
+
+	fprintf(out, "Driver version is %d.%d.%d.\n",
+		dev->version >> 16, (dev->version >> 8) & 0xff, dev->version & 0xff);
+
+	if (!dev->btnmapok) {
+		/* btnmap out of range for names. Don't print any. */
+		fputs("jstest is not fully compatible with your kernel. Unable to retrieve button map!\n", out);
+		fprintf(out, "Joystick (%s) has %d axes ", dev->name, dev->axes);
+		fprintf(out, "and %d buttons.\n", dev->buttons);
+	}
+	else {
+		fprintf(out, "Joystick (%s) has %d axes (", dev->name, dev->axes);
+		for (i = 0; i < dev->axes; i++)
+			fprintf(out, "%s%s", i > 0 ? ", " : "", axis_names[dev->axmap[i]]);
+		fputs(")\n", out);
+
+		fprintf(out, "and %d buttons (", dev->buttons);
+		for (i = 0; i < dev->buttons; i++) {
+			fprintf(out, "%s%s", i > 0 ? ", " : "", button_names[dev->btnmap[i] - BTN_MISC]);
+		}
+		fputs(").\n", out);
+	}
+}
+
+void device_close(struct device *dev)
+{
+	if (dev->fd >= 0)
+		close(dev->fd);
+	dev->fd = -1;
+	free(dev->axis);
+	free(dev->button);
+	free(dev->absinfo);
+	free(dev->pending_axis);
+	free(dev->pending_button);
+	dev->axis = NULL;
+	dev->button = NULL;
+	dev->absinfo = NULL;
+	dev->pending_axis = NULL;
+	dev->pending_button = NULL;
+}
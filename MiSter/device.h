@@ -0,0 +1,97 @@
+/*
+ * device.h
+ *
+ * Copyright (c) 2020 RetroSpy Technologies
+ */
+
+ /*
+  * This program is free software; you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation; either version 2 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program; if not, write to the Free Software
+  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  * 02110-1301 USA.
+  */
+
+#ifndef __DEVICE_H__
+#define __DEVICE_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <linux/input.h>
+
+#include "axbtnmap.h"
+
+#define NAME_LENGTH 128
+
+enum device_kind {
+	DEVICE_JOYSTICK,	/* /dev/input/jsX, the legacy joystick API */
+	DEVICE_EVDEV,		/* /dev/input/eventX */
+};
+
+/* Events pulled from the driver per read() */
+#define EVENT_BATCH 64
+
+/* A controller and the state the bridge reports for it. Axes and buttons are
+   numbered the way the joystick driver numbers them on either backend, and
+   axes are scaled to -32767..32767. */
+struct device {
+	int fd;
+	enum device_kind kind;
+	char name[NAME_LENGTH];
+	int version;		/* Driver version */
+	unsigned char axes;
+	unsigned char buttons;
+	int *axis;
+	char *button;
+	uint64_t timestamp_us;	/* CLOCK_MONOTONIC time of the current state */
+	int changed;		/* State moved since the last frame */
+
+	/* Maps back to the kernel codes, used for the description */
+	uint8_t axmap[AXMAP_SIZE];
+	uint16_t btnmap[BTNMAP_SIZE];
+	int btnmapok;
+
+	/* evdev only: codes to indexes, the report being assembled, and
+	   events read but not yet applied */
+	int16_t abs_index[ABS_CNT];
+	int16_t key_index[KEY_CNT];
+	struct input_absinfo *absinfo;
+	int *pending_axis;
+	char *pending_button;
+	int dropped;
+	struct input_event queue[EVENT_BATCH];
+	int queued;
+	int next;
+};
+
+uint64_t monotonic_us(void);
+
+/* Opens the device at path, picking the backend from its name. Returns 0 on
+   success, -1 with errno set otherwise. */
+int device_open(struct device *dev, const char *path);
+
+/* Returns 1 when a new state is ready in axis/button/timestamp_us, 0 when
+   nothing more is queued, -1 once the device is gone. Call it until it
+   stops returning 1. */
+int device_read(struct device *dev);
+
+void device_describe(const struct device *dev, FILE *out);
+
+void device_close(struct device *dev);
+
+/* Backends */
+int joystick_open(struct device *dev);
+int joystick_read(struct device *dev);
+int evdev_open(struct device *dev);
+int evdev_read(struct device *dev);
+
+#endif
@@ -0,0 +1,212 @@
+/*
+ * evdev.c
+ *
+ * Copyright (c) 2020 RetroSpy Technologies
+ */
+
+ /*
+  * This program is free software; you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation; either version 2 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program; if not, write to the Free Software
+  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  * 02110-1301 USA.
+  */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include "device.h"
+
+#define BITS_PER_LONG (sizeof(long) * 8)
+#define NBITS(x) (((x) + BITS_PER_LONG - 1) / BITS_PER_LONG)
+#define TEST_BIT(bit, array) (((array)[(bit) / BITS_PER_LONG] >> ((bit) % BITS_PER_LONG)) & 1)
+
+/* Kernel headers older than 4.16 only have the timeval */
+#ifndef input_event_sec
+#define input_event_sec time.tv_sec
+#define input_event_usec time.tv_usec
+#endif
+
+/* Same scaling as the joystick driver, the axis range maps to -32767..32767 */
+static int scale_axis(const struct input_absinfo *info, int value)
+{
+	int64_t range = (int64_t)info->maximum - info->minimum;
+
+	if (range <= 0)
+		return 0;
+	value = (int)(((int64_t)value - info->minimum) * 65534 / range - 32767);
+	return value < -32767 ? -32767 : value > 32767 ? 32767 : value;
+}
+
+/* Reads the complete state back from the kernel, at open and whenever the
+   kernel had to drop events. */
+static int sync_state(struct device *dev)
+{
+	unsigned long keys[NBITS(KEY_CNT)];
+	int i;
+
+	memset(keys, 0, sizeof(keys));
+	if (ioctl(dev->fd, EVIOCGKEY(sizeof(keys)), keys) < 0)
+		return -1;
+	for (i = 0; i < dev->buttons; i++)
+		dev->pending_button[i] = TEST_BIT(dev->btnmap[i], keys);
+
+	for (i = 0; i < dev->axes; i++) {
+		if (ioctl(dev->fd, EVIOCGABS(dev->axmap[i]), &dev->absinfo[i]) < 0)
+			return -1;
+		dev->pending_axis[i] = scale_axis(&dev->absinfo[i], dev->absinfo[i].value);
+	}
+
+	memcpy(dev->axis, dev->pending_axis, dev->axes * sizeof(int));
+	memcpy(dev->button, dev->pending_button, dev->buttons);
+	dev->timestamp_us = monotonic_us();
+	dev->changed = 1;
+	return 0;
+}
+
+static void add_button(struct device *dev, int code)
+{
+	if (dev->buttons < 255) {
+		dev->key_index[code] = dev->buttons;
+		dev->btnmap[dev->buttons++] = code;
+	}
+}
+
+int evdev_open(struct device *dev)
+{
+	unsigned long absbits[NBITS(ABS_CNT)];
+	unsigned long keybits[NBITS(KEY_CNT)];
+	int clock = CLOCK_MONOTONIC;
+	int code;
+
+	memset(absbits, 0, sizeof(absbits));
+	memset(keybits, 0, sizeof(keybits));
+	ioctl(dev->fd, EVIOCGVERSION, &dev->version);
+	ioctl(dev->fd, EVIOCGNAME(NAME_LENGTH), dev->name);
+	if (ioctl(dev->fd, EVIOCGBIT(EV_ABS, sizeof(absbits)), absbits) < 0 ||
+		ioctl(dev->fd, EVIOCGBIT(EV_KEY, sizeof(keybits)), keybits) < 0)
+		return -1;
+
+	/* Event times on the same clock as everything else in the bridge */
+	ioctl(dev->fd, EVIOCSCLOCKID, &clock);
+
+	/* Number axes and buttons the way the joystick driver does: axes in
+	   code order, then joystick buttons before the misc ones. */
+	for (code = 0; code < ABS_CNT; code++)
+		dev->abs_index[code] = -1;
+	for (code = 0; code < KEY_CNT; code++)
+		dev->key_index[code] = -1;
+
+	for (code = 0; code < ABS_CNT && dev->axes < 255; code++) {
+		if (TEST_BIT(code, absbits)) {
+			dev->abs_index[code] = dev->axes;
+			dev->axmap[dev->axes++] = code;
+		}
+	}
+	for (code = BTN_JOYSTICK; code < KEY_CNT; code++) {
+		if (TEST_BIT(code, keybits))
+			add_button(dev, code);
+	}
+	for (code = BTN_MISC; code < BTN_JOYSTICK; code++) {
+		if (TEST_BIT(code, keybits))
+			add_button(dev, code);
+	}
+	dev->btnmapok = 1;
+	for (code = 0; code < dev->buttons; code++) {
+		if (dev->btnmap[code] > KEY_MAX_LARGE) {
+			dev->btnmapok = 0;
+			break;
+		}
+	}
+
+	dev->axis = calloc(dev->axes + 1, sizeof(int));
+	dev->button = calloc(dev->buttons + 1, sizeof(char));
+	dev->pending_axis = calloc(dev->axes + 1, sizeof(int));
+	dev->pending_button = calloc(dev->buttons + 1, sizeof(char));
+	dev->absinfo = calloc(dev->axes + 1, sizeof(struct input_absinfo));
+	if (dev->axis == NULL || dev->button == NULL || dev->pending_axis == NULL ||
+		dev->pending_button == NULL || dev->absinfo == NULL)
+		return -1;
+
+	return sync_state(dev);
+}
+
+/* Applies events to the pending state and publishes it at each SYN_REPORT,
+   so a frame never holds half of a report. */
+int evdev_read(struct device *dev)
+{
+	for (;;) {
+		if (dev->next >= dev->queued) {
+			ssize_t len = read(dev->fd, dev->queue, sizeof(dev->queue));
+
+			if (len == 0 || (len < 0 && errno != EAGAIN && errno != EINTR))
+				return -1;
+			if (len < 0) {
+				/* Only the state from open is left to report */
+				if (dev->changed) {
+					dev->changed = 0;
+					return 1;
+				}
+				return 0;
+			}
+			dev->queued = len / sizeof(struct input_event);
+			dev->next = 0;
+		}
+
+		while (dev->next < dev->queued) {
+			const struct input_event *e = &dev->queue[dev->next++];
+
+			switch (e->type) {
+			case EV_KEY:
+				if (!dev->dropped && e->code < KEY_CNT && dev->key_index[e->code] >= 0)
+					dev->pending_button[dev->key_index[e->code]] = e->value != 0;
+				break;
+			case EV_ABS:
+				if (!dev->dropped && e->code < ABS_CNT && dev->abs_index[e->code] >= 0) {
+					int index = dev->abs_index[e->code];
+					dev->pending_axis[index] = scale_axis(&dev->absinfo[index], e->value);
+				}
+				break;
+			case EV_SYN:
+				if (e->code == SYN_DROPPED) {
+					/* Ignore everything up to the next report, then ask
+					   the kernel for the real state */
+					dev->dropped = 1;
+				}
+				else if (e->code == SYN_REPORT) {
+					if (dev->dropped) {
+						dev->dropped = 0;
+						if (sync_state(dev) < 0)
+							return -1;
+					}
+					else if (memcmp(dev->axis, dev->pending_axis, dev->axes * sizeof(int)) != 0 ||
+						memcmp(dev->button, dev->pending_button, dev->buttons) != 0) {
+						memcpy(dev->axis, dev->pending_axis, dev->axes * sizeof(int));
+						memcpy(dev->button, dev->pending_button, dev->buttons);
+					}
+					else {
+						/* Nothing the frame carries moved */
+						break;
+					}
+					dev->timestamp_us = (uint64_t)e->input_event_sec * 1000000 + e->input_event_usec;
+					dev->changed = 0;
+					return 1;
+				}
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,131 @@
+/*
+ * frame.c
+ *
+ * Copyright (c) 2020 RetroSpy Technologies
+ */
+
+ /*
+  * This program is free software; you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation; either version 2 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program; if not, write to the Free Software
+  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  * 02110-1301 USA.
+  */
+
+#include <string.h>
+
+#include "frame.h"
+
+static char *put_bits(char *out, unsigned int value, int count)
+{
+	int j;
+
+	for (j = 0; j < count; ++j)
+		*out++ = (value & (1u << j)) != 0 ? '1' : '0';
+	return out;
+}
+
+size_t frame_encode_text(const struct frame *f, char *buf)
+{
+	char *out = buf;
+	int i;
+
+	out = put_bits(out, f->axes, 8);
+	out = put_bits(out, f->buttons, 8);
+
+	for (i = 0; i < f->buttons; ++i)
+		*out++ = f->button[i] != 0 ? '1' : '0';
+
+	for (i = 0; i < f->axes; i++)
+		out = put_bits(out, (unsigned int)f->axis[i], 32);
+
+	*out++ = '\n';
+	return out - buf;
+}
+
+static uint8_t *put_le(uint8_t *out, uint64_t value, int bytes)
+{
+	int j;
+
+	for (j = 0; j < bytes; ++j)
+		*out++ = (uint8_t)(value >> (8 * j));
+	return out;
+}
+
+size_t frame_encode_binary(const struct frame *f, uint8_t *buf)
+{
+	const size_t button_bytes = (f->buttons + 7) / 8;
+	const size_t length = FRAME_HEADER_SIZE + button_bytes + 2 * f->axes;
+	uint8_t *out = buf;
+	int i;
+
+	*out++ = FRAME_MAGIC0;
+	*out++ = FRAME_MAGIC1;
+	*out++ = FRAME_VERSION;
+	*out++ = f->device;
+	*out++ = f->axes;
+	*out++ = f->buttons;
+	out = put_le(out, length, 2);
+	out = put_le(out, f->timestamp_us, 8);
+
+	memset(out, 0, button_bytes);
+	for (i = 0; i < f->buttons; ++i) {
+		if (f->button[i] != 0)
+			out[i >> 3] |= 1 << (i & 7);
+	}
+	out += button_bytes;
+
+	for (i = 0; i < f->axes; i++)
+		out = put_le(out, (uint16_t)(int16_t)f->axis[i], 2);
+
+	return out - buf;
+}
+
+static uint64_t get_le(const uint8_t *in, int bytes)
+{
+	uint64_t value = 0;
+	int j;
+
+	for (j = bytes - 1; j >= 0; --j)
+		value = (value << 8) | in[j];
+	return value;
+}
+
+int frame_decode_binary(const uint8_t *buf, size_t len, struct frame *f, int *axis, char *button)
+{
+	size_t button_bytes;
+	const uint8_t *in;
+	int i;
+
+	if (len < FRAME_HEADER_SIZE || buf[0] != FRAME_MAGIC0 || buf[1] != FRAME_MAGIC1 || buf[2] != FRAME_VERSION)
+		return -1;
+
+	f->device = buf[3];
+	f->axes = buf[4];
+	f->buttons = buf[5];
+	button_bytes = (f->buttons + 7) / 8;
+	if (get_le(buf + 6, 2) != FRAME_HEADER_SIZE + button_bytes + 2 * f->axes || get_le(buf + 6, 2) > len)
+		return -1;
+	f->timestamp_us = get_le(buf + 8, 8);
+
+	in = buf + FRAME_HEADER_SIZE;
+	for (i = 0; i < f->buttons; ++i)
+		button[i] = (in[i >> 3] >> (i & 7)) & 1;
+	in += button_bytes;
+
+	for (i = 0; i < f->axes; i++)
+		axis[i] = (int16_t)get_le(in + 2 * i, 2);
+
+	f->axis = axis;
+	f->button = button;
+	return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * frame.h
+ *
+ * Copyright (c) 2020 RetroSpy Technologies
+ */
+
+ /*
+  * This program is free software; you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation; either version 2 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program; if not, write to the Free Software
+  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  * 02110-1301 USA.
+  */
+
+#ifndef __FRAME_H__
+#define __FRAME_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* One snapshot of a controller, as handed to the encoders. */
+struct frame {
+	uint8_t device;		/* Index of the controller */
+	uint8_t axes;
+	uint8_t buttons;
+	uint64_t timestamp_us;	/* When the state was read */
+	const int *axis;
+	const char *button;
+};
+
+/* Binary frames, all fields little endian:
+
+	offset  size
+	0       2     magic "RS"
+	2       1     FRAME_VERSION
+	3       1     device index
+	4       1     axis count
+	5       1     button count
+	6       2     frame length in bytes, header included
+	8       8     timestamp in microseconds
+	16      n     buttons, one bit each, LSB first, (count + 7) / 8 bytes
+	16 + n  2 * a axes, int16 each
+
+   A pad with 6 axes and 12 buttons is 30 bytes a frame, the text format
+   takes 221. */
+#define FRAME_MAGIC0 'R'
+#define FRAME_MAGIC1 'S'
+#define FRAME_VERSION 1
+#define FRAME_HEADER_SIZE 16
+
+/* Largest frame either encoder can produce. */
+#define FRAME_BINARY_MAX (FRAME_HEADER_SIZE + 256 / 8 + 255 * 2)
+#define FRAME_TEXT_MAX (8 + 8 + 255 + 255 * 32 + 1)
+#define FRAME_MAX FRAME_TEXT_MAX
+
+/* The original text format: axis and button counts as 8 bit strings, then a
+   '0'/'1' per button and a 32 bit string per axis, all LSB first. */
+size_t frame_encode_text(const struct frame *f, char *buf);
+
+size_t frame_encode_binary(const struct frame *f, uint8_t *buf);
+
+/* Reads a binary frame back. axis and button must hold 255 entries, f
+   points into them. Returns -1 when buf is not a complete frame. */
+int frame_decode_binary(const uint8_t *buf, size_t len, struct frame *f, int *axis, char *button);
+
+#endif
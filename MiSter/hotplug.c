@@ -0,0 +1,418 @@
+/*
+ * hotplug.c
+ *
+ * Copyright (c) 2020 RetroSpy Technologies
+ */
+
+ /*
+  * This program is free software; you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation; either version 2 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program; if not, write to the Free Software
+  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  * 02110-1301 USA.
+  */
+
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+
+#include "hotplug.h"
+
+/* epoll data for the inotify descriptor and the other handlers, devices
+   use their slot index */
+#define HOTPLUG_INOTIFY_TAG UINT32_MAX
+#define HOTPLUG_HANDLER_TAG 0x10000
+
+static int add_watch(struct hotplug *hp, const char *dir)
+{
+	int i, wd;
+
+	for (i = 0; i < hp->watch_count; i++) {
+		if (strcmp(hp->watches[i].dir, dir) == 0)
+			return 0;
+	}
+	if (hp->watch_count >= HOTPLUG_MAX_WATCHES)
+		return -1;
+
+	/* IN_ATTRIB matters: udev fixes the permissions after the node
+	   appears, so the first open can fail with EACCES */
+	wd = inotify_add_watch(hp->infd, dir, IN_CREATE | IN_ATTRIB | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM);
+	if (wd < 0)
+		return -1;
+
+	hp->watches[hp->watch_count].wd = wd;
+	snprintf(hp->watches[hp->watch_count].dir, HOTPLUG_PATH_LENGTH, "%s", dir);
+	hp->watch_count++;
+	return 0;
+}
+
+/* Anything that is not a controller: keyboards, mice, power buttons */
+static int is_controller(const struct device *dev)
+{
+	int i;
+
+	if (dev->axes > 0)
+		return 1;
+	for (i = 0; i < dev->buttons; i++) {
+		if (dev->btnmap[i] >= BTN_JOYSTICK && dev->btnmap[i] < BTN_DIGI)
+			return 1;
+	}
+	return 0;
+}
+
+static void read_slot(struct hotplug *hp, int index);
+
+static void close_slot(struct hotplug *hp, int index)
+{
+	struct hotplug_slot *slot = &hp->slots[index];
+
+	if (!slot->open)
+		return;
+	epoll_ctl(hp->epfd, EPOLL_CTL_DEL, slot->dev.fd, NULL);
+	device_close(&slot->dev);
+	slot->open = 0;
+	fprintf(hp->info, "Device %d (%s) disconnected.\n", index, slot->path);
+	fflush(hp->info);
+}
+
+/* The node is gone for good. A slot found by prefix becomes free for other
+   devices, after the empty ones. */
+static void release_slot(struct hotplug *hp, int index)
+{
+	close_slot(hp, index);
+	if (!hp->slots[index].listed)
+		hp->slots[index].kept = 0;
+}
+
+static void open_slot(struct hotplug *hp, int index)
+{
+	struct hotplug_slot *slot = &hp->slots[index];
+	struct epoll_event ev;
+
+	if (slot->open)
+		return;
+	if (device_open(&slot->dev, slot->path) < 0) {
+		/* Not ready yet, or not ours to read. IN_ATTRIB retries and
+		   claims a slot again if it is still free by then. */
+		if (!slot->kept)
+			slot->path[0] = '\0';
+		return;
+	}
+
+	if (hp->prefix != NULL && !is_controller(&slot->dev)) {
+		device_close(&slot->dev);
+		slot->path[0] = '\0';
+		return;
+	}
+
+	ev.events = EPOLLIN;
+	ev.data.u32 = index;
+	if (epoll_ctl(hp->epfd, EPOLL_CTL_ADD, slot->dev.fd, &ev) < 0) {
+		device_close(&slot->dev);
+		if (!slot->kept)
+			slot->path[0] = '\0';
+		return;
+	}
+	slot->open = 1;
+	slot->kept = 1;
+
+	fprintf(hp->info, "Device %d (%s):\n", index, slot->path);
+	device_describe(&slot->dev, hp->info);
+	fflush(hp->info);
+
+	/* The state at plug in is the device's first frame */
+	read_slot(hp, index);
+}
+
+static int find_slot(struct hotplug *hp, const char *path)
+{
+	int i;
+
+	for (i = 0; i < HOTPLUG_MAX_DEVICES; i++) {
+		if (strcmp(hp->slots[i].path, path) == 0)
+			return i;
+	}
+	return -1;
+}
+
+static int claim_slot(struct hotplug *hp, const char *path)
+{
+	int i = find_slot(hp, path);
+
+	if (i >= 0)
+		return i;
+	for (i = 0; i < HOTPLUG_MAX_DEVICES; i++) {
+		if (hp->slots[i].path[0] == '\0')
+			break;
+	}
+	if (i == HOTPLUG_MAX_DEVICES) {
+		for (i = 0; i < HOTPLUG_MAX_DEVICES; i++) {
+			if (!hp->slots[i].open && !hp->slots[i].kept)
+				break;
+		}
+		if (i == HOTPLUG_MAX_DEVICES)
+			return -1;
+	}
+	snprintf(hp->slots[i].path, HOTPLUG_PATH_LENGTH, "%s", path);
+	hp->slots[i].kept = 0;
+	hp->slots[i].listed = 0;
+	return i;
+}
+
+int hotplug_init(struct hotplug *hp, const char *prefix, FILE *info, hotplug_frame_fn frame, void *context)
+{
+	struct epoll_event ev;
+	int i;
+
+	memset(hp, 0, sizeof(*hp));
+	hp->prefix = prefix;
+	hp->info = info;
+	hp->frame = frame;
+	hp->context = context;
+	for (i = 0; i < HOTPLUG_MAX_DEVICES; i++)
+		hp->slots[i].dev.fd = -1;
+	for (i = 0; i < HOTPLUG_MAX_HANDLERS; i++)
+		hp->handlers[i].fd = -1;
+
+	hp->epfd = epoll_create1(EPOLL_CLOEXEC);
+	hp->infd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (hp->epfd < 0 || hp->infd < 0)
+		return -1;
+
+	ev.events = EPOLLIN;
+	ev.data.u32 = HOTPLUG_INOTIFY_TAG;
+	if (epoll_ctl(hp->epfd, EPOLL_CTL_ADD, hp->infd, &ev) < 0)
+		return -1;
+
+	if (prefix != NULL)
+		return add_watch(hp, HOTPLUG_INPUT_DIR);
+	return 0;
+}
+
+int hotplug_add(struct hotplug *hp, const char *path)
+{
+	char dir[HOTPLUG_PATH_LENGTH];
+	const char *slash = strrchr(path, '/');
+	int index;
+
+	if (slash == NULL)
+		snprintf(dir, sizeof(dir), ".");
+	else
+		snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+	if (add_watch(hp, dir) < 0)
+		return -1;
+
+	if ((index = claim_slot(hp, path)) < 0)
+		return -1;
+	hp->slots[index].kept = 1;
+	hp->slots[index].listed = 1;
+	open_slot(hp, index);
+	if (!hp->slots[index].open) {
+		fprintf(hp->info, "Waiting for %s.\n", path);
+		fflush(hp->info);
+	}
+	return 0;
+}
+
+void hotplug_scan(struct hotplug *hp)
+{
+	char path[HOTPLUG_PATH_LENGTH];
+	struct dirent *entry;
+	DIR *dir;
+	int index;
+
+	if (hp->prefix == NULL || (dir = opendir(HOTPLUG_INPUT_DIR)) == NULL)
+		return;
+
+	while ((entry = readdir(dir)) != NULL) {
+		if (strncmp(entry->d_name, hp->prefix, strlen(hp->prefix)) != 0)
+			continue;
+		if (snprintf(path, sizeof(path), HOTPLUG_INPUT_DIR "/%.200s", entry->d_name) >= (int)sizeof(path))
+			continue;
+		if ((index = claim_slot(hp, path)) >= 0)
+			open_slot(hp, index);
+	}
+	closedir(dir);
+}
+
+static void handle_inotify(struct hotplug *hp)
+{
+	char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	char path[HOTPLUG_PATH_LENGTH];
+	ssize_t len;
+
+	while ((len = read(hp->infd, buf, sizeof(buf))) > 0) {
+		char *p = buf;
+
+		while (p < buf + len) {
+			const struct inotify_event *e = (const struct inotify_event *)p;
+			const char *dir = NULL;
+			int i, index;
+
+			p += sizeof(struct inotify_event) + e->len;
+			for (i = 0; i < hp->watch_count; i++) {
+				if (hp->watches[i].wd == e->wd)
+					dir = hp->watches[i].dir;
+			}
+			if (dir == NULL || e->len == 0)
+				continue;
+			if (snprintf(path, sizeof(path), "%.127s/%.127s", dir, e->name) >= (int)sizeof(path))
+				continue;
+
+			if (e->mask & (IN_DELETE | IN_MOVED_FROM)) {
+				if ((index = find_slot(hp, path)) >= 0)
+					release_slot(hp, index);
+				continue;
+			}
+
+			index = find_slot(hp, path);
+			if (index < 0 && hp->prefix != NULL && strcmp(dir, HOTPLUG_INPUT_DIR) == 0 &&
+				strncmp(e->name, hp->prefix, strlen(hp->prefix)) == 0)
+				index = claim_slot(hp, path);
+			if (index >= 0)
+				open_slot(hp, index);
+		}
+	}
+}
+
+static void read_slot(struct hotplug *hp, int index)
+{
+	struct hotplug_slot *slot = &hp->slots[index];
+	int ret;
+
+	while ((ret = device_read(&slot->dev)) > 0) {
+		if (hp->frame != NULL && hp->frame(index, &slot->dev, hp->context) < 0)
+			hp->failed = 1;
+	}
+	if (ret < 0 && errno == ENODEV)
+		release_slot(hp, index);	/* Unplugged */
+	else if (ret < 0)
+		close_slot(hp, index);
+}
+
+int hotplug_wait(struct hotplug *hp, int timeout)
+{
+	struct epoll_event events[HOTPLUG_MAX_DEVICES + HOTPLUG_MAX_HANDLERS + 1];
+	int i, n;
+
+	n = epoll_wait(hp->epfd, events, sizeof(events) / sizeof(events[0]), timeout);
+	if (n < 0)
+		return errno == EINTR ? 0 : -1;
+
+	for (i = 0; i < n; i++) {
+		const uint32_t tag = events[i].data.u32;
+
+		if (tag == HOTPLUG_INOTIFY_TAG) {
+			handle_inotify(hp);
+		}
+		else if (tag >= HOTPLUG_HANDLER_TAG && tag < HOTPLUG_HANDLER_TAG + HOTPLUG_MAX_HANDLERS) {
+			/* A handler may unwatch itself or others from here */
+			struct hotplug_handler *h = &hp->handlers[tag - HOTPLUG_HANDLER_TAG];
+			if (h->fd >= 0)
+				h->ready(h->fd, events[i].events, h->context);
+		}
+		else if (tag < HOTPLUG_MAX_DEVICES && hp->slots[tag].open) {
+			/* Read before looking at the error bits, the last
+			   reports can still be queued */
+			read_slot(hp, tag);
+			if ((events[i].events & (EPOLLERR | EPOLLHUP)) && hp->slots[tag].open)
+				release_slot(hp, tag);
+		}
+	}
+	return hp->failed ? -1 : 0;
+}
+
+int hotplug_watch_fd(struct hotplug *hp, int fd, uint32_t events, hotplug_ready_fn ready, void *context)
+{
+	struct epoll_event ev;
+	int i;
+
+	for (i = 0; i < HOTPLUG_MAX_HANDLERS; i++) {
+		if (hp->handlers[i].fd < 0)
+			break;
+	}
+	if (i == HOTPLUG_MAX_HANDLERS) {
+		errno = ENFILE;
+		return -1;
+	}
+
+	ev.events = events;
+	ev.data.u32 = HOTPLUG_HANDLER_TAG + i;
+	if (epoll_ctl(hp->epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+		return -1;
+
+	hp->handlers[i].fd = fd;
+	hp->handlers[i].ready = ready;
+	hp->handlers[i].context = context;
+	return 0;
+}
+
+int hotplug_modify_fd(struct hotplug *hp, int fd, uint32_t events)
+{
+	struct epoll_event ev;
+	int i;
+
+	for (i = 0; i < HOTPLUG_MAX_HANDLERS; i++) {
+		if (hp->handlers[i].fd == fd) {
+			ev.events = events;
+			ev.data.u32 = HOTPLUG_HANDLER_TAG + i;
+			return epoll_ctl(hp->epfd, EPOLL_CTL_MOD, fd, &ev);
+		}
+	}
+	errno = ENOENT;
+	return -1;
+}
+
+void hotplug_unwatch_fd(struct hotplug *hp, int fd)
+{
+	int i;
+
+	for (i = 0; i < HOTPLUG_MAX_HANDLERS; i++) {
+		if (hp->handlers[i].fd == fd) {
+			epoll_ctl(hp->epfd, EPOLL_CTL_DEL, fd, NULL);
+			hp->handlers[i].fd = -1;
+		}
+	}
+}
+
+int hotplug_each(struct hotplug *hp, hotplug_frame_fn frame, void *context)
+{
+	int i;
+
+	for (i = 0; i < HOTPLUG_MAX_DEVICES; i++) {
+		if (hp->slots[i].open && frame(i, &hp->slots[i].dev, context) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+void hotplug_close(struct hotplug *hp)
+{
+	int i;
+
+	for (i = 0; i < HOTPLUG_MAX_DEVICES; i++) {
+		if (hp->slots[i].open) {
+			epoll_ctl(hp->epfd, EPOLL_CTL_DEL, hp->slots[i].dev.fd, NULL);
+			device_close(&hp->slots[i].dev);
+			hp->slots[i].open = 0;
+		}
+	}
+	if (hp->infd >= 0)
+		close(hp->infd);
+	if (hp->epfd >= 0)
+		close(hp->epfd);
+}
@@ -0,0 +1,113 @@
+/*
+ * hotplug.h
+ *
+ * Copyright (c) 2020 RetroSpy Technologies
+ */
+
+ /*
+  * This program is free software; you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation; either version 2 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program; if not, write to the Free Software
+  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  * 02110-1301 USA.
+  */
+
+#ifndef __HOTPLUG_H__
+#define __HOTPLUG_H__
+
+#include <stdio.h>
+
+#include "device.h"
+
+#define HOTPLUG_MAX_DEVICES 8
+#define HOTPLUG_MAX_WATCHES 4
+#define HOTPLUG_MAX_HANDLERS 16
+#define HOTPLUG_PATH_LENGTH 256
+#define HOTPLUG_INPUT_DIR "/dev/input"
+
+/* A controller keeps its slot, and with it its index in the frames, across
+   unplug and replug as long as it comes back under the same path. A node
+   found by prefix only keeps one once it has opened as a controller, and
+   gives it up when the node is removed. The path stays behind so the
+   controller gets the same slot back if nothing else needed it meanwhile. */
+struct hotplug_slot {
+	char path[HOTPLUG_PATH_LENGTH];	/* Empty when the slot is free */
+	int open;
+	int kept;	/* Held while closed: listed, or opened and still present */
+	int listed;	/* Listed with hotplug_add, never given up */
+	struct device dev;
+};
+
+/* Called for every new state, index is the slot. Returning < 0 stops
+   hotplug_wait(). */
+typedef int (*hotplug_frame_fn)(int index, const struct device *dev, void *context);
+
+struct hotplug_watch {
+	int wd;
+	char dir[HOTPLUG_PATH_LENGTH];
+};
+
+/* Other descriptors can share the loop, e.g. the server's sockets. */
+typedef void (*hotplug_ready_fn)(int fd, uint32_t events, void *context);
+
+struct hotplug_handler {
+	int fd;			/* -1 when the entry is free */
+	hotplug_ready_fn ready;
+	void *context;
+};
+
+/* Every controller the bridge serves, multiplexed in one epoll set. Either
+   a fixed list of paths, or everything in /dev/input whose name starts with
+   a prefix ("js" or "event"). */
+struct hotplug {
+	int epfd;
+	int infd;
+	const char *prefix;	/* NULL when only the listed paths are served */
+	FILE *info;
+	hotplug_frame_fn frame;
+	void *context;
+	int failed;		/* The callback asked to stop */
+	struct hotplug_slot slots[HOTPLUG_MAX_DEVICES];
+	struct hotplug_watch watches[HOTPLUG_MAX_WATCHES];
+	int watch_count;
+	struct hotplug_handler handlers[HOTPLUG_MAX_HANDLERS];
+};
+
+/* frame gets every report as it arrives, including the state at plug in.
+   It may be NULL when states are only sampled with hotplug_each(). */
+int hotplug_init(struct hotplug *hp, const char *prefix, FILE *info, hotplug_frame_fn frame, void *context);
+
+/* Serves a specific path, now and whenever it reappears. */
+int hotplug_add(struct hotplug *hp, const char *path);
+
+/* Opens whatever matching devices already exist. */
+void hotplug_scan(struct hotplug *hp);
+
+/* Waits up to timeout ms (-1 forever) and handles what arrives: plugs,
+   unplugs and controller reports. Returns < 0 on failure or when the
+   callback asked to stop. */
+int hotplug_wait(struct hotplug *hp, int timeout);
+
+/* Calls ready whenever fd reports one of the epoll events. */
+int hotplug_watch_fd(struct hotplug *hp, int fd, uint32_t events, hotplug_ready_fn ready, void *context);
+
+/* Changes the events fd is watched for, e.g. to add EPOLLOUT. */
+int hotplug_modify_fd(struct hotplug *hp, int fd, uint32_t events);
+
+void hotplug_unwatch_fd(struct hotplug *hp, int fd);
+
+/* Hands every open device's current state to the callback. */
+int hotplug_each(struct hotplug *hp, hotplug_frame_fn frame, void *context);
+
+void hotplug_close(struct hotplug *hp);
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * joystick.c
+ *
+ * Copyright (c) 2020 RetroSpy Technologies
+ *
+ * Based on jstest.c Version 1.2
+ */
+
+ /*
+  * This program is free software; you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation; either version 2 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program; if not, write to the Free Software
+  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  * 02110-1301 USA.
+  */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include <linux/joystick.h>
+
+#include "device.h"
+
+int joystick_open(struct device *dev)
+{
+	int i;
+
+	dev->version = 0x000800;
+	dev->axes = 2;
+	dev->buttons = 2;
+
+	ioctl(dev->fd, JSIOCGVERSION, &dev->version);
+	ioctl(dev->fd, JSIOCGAXES, &dev->axes);
+	ioctl(dev->fd, JSIOCGBUTTONS, &dev->buttons);
+	ioctl(dev->fd, JSIOCGNAME(NAME_LENGTH), dev->name);
+
+	getaxmap(dev->fd, dev->axmap);
+	getbtnmap(dev->fd, dev->btnmap);
+
+	/* Determine whether the button map is usable. */
+	dev->btnmapok = 1;
+	for (i = 0; i < dev->buttons; i++) {
+		if (dev->btnmap[i] < BTN_MISC || dev->btnmap[i] > KEY_MAX) {
+			dev->btnmapok = 0;
+			break;
+		}
+	}
+
+	dev->axis = calloc(dev->axes, sizeof(int));
+	dev->button = calloc(dev->buttons, sizeof(char));
+	if (dev->axis == NULL || dev->button == NULL)
+		return -1;
+
+	dev->changed = 1;	/* The driver's init events become the first frame */
+	return 0;
+}
+
+/* Drains everything the driver has queued into the state. The legacy API has
+   no report boundaries, so one burst becomes one state. */
+int joystick_read(struct device *dev)
+{
+	struct js_event events[EVENT_BATCH];
+	ssize_t len;
+	size_t i;
+
+	while ((len = read(dev->fd, events, sizeof(events))) > 0) {
+		for (i = 0; i < len / sizeof(struct js_event); i++) {
+			struct js_event *e = &events[i];
+
+			switch (e->type & ~JS_EVENT_INIT) {
+			case JS_EVENT_BUTTON:
+				if (e->number < dev->buttons && dev->button[e->number] != (e->value != 0)) {
+					dev->button[e->number] = e->value != 0;
+					dev->changed = 1;
+				}
+				break;
+			case JS_EVENT_AXIS:
+				if (e->number < dev->axes && dev->axis[e->number] != e->value) {
+					dev->axis[e->number] = e->value;
+					dev->changed = 1;
+				}
+				break;
+			}
+		}
+	}
+
+	if (len == 0 || (len < 0 && errno != EAGAIN && errno != EINTR))
+		return -1;
+
+	if (dev->changed) {
+		/* js_event.time is only milliseconds, the read time is closer */
+		dev->timestamp_us = monotonic_us();
+		dev->changed = 0;
+		return 1;
+	}
+	return 0;
+}
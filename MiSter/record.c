@@ -0,0 +1,185 @@
+/*
+ * record.c
+ *
+ * Copyright (c) 2020 RetroSpy Technologies
+ */
+
+ /*
+  * This program is free software; you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation; either version 2 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program; if not, write to the Free Software
+  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  * 02110-1301 USA.
+  */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "frame.h"
+#include "record.h"
+
+/* Length of the frame at offset, or 0 where the writer wrapped early */
+static size_t frame_at(const struct recording *rec, uint64_t offset)
+{
+	const uint8_t *p = rec->ring + offset;
+	size_t len;
+
+	if (rec->header->capacity - offset < FRAME_HEADER_SIZE ||
+		p[0] != FRAME_MAGIC0 || p[1] != FRAME_MAGIC1)
+		return 0;
+	len = p[6] | (p[7] << 8);
+	return len <= rec->header->capacity - offset ? len : 0;
+}
+
+static int map_file(struct recording *rec, int writable)
+{
+	struct stat st;
+
+	if (fstat(rec->fd, &st) < 0)
+		return -1;
+	rec->map_size = st.st_size;
+	rec->map = mmap(NULL, rec->map_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, rec->fd, 0);
+	if (rec->map == MAP_FAILED) {
+		rec->map = NULL;
+		return -1;
+	}
+	rec->header = (struct record_header *)rec->map;
+	rec->ring = rec->map + RECORD_HEADER_SIZE;
+	return 0;
+}
+
+int record_create(struct recording *rec, const char *path, size_t capacity)
+{
+	int err;
+
+	memset(rec, 0, sizeof(*rec));
+	rec->fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (rec->fd < 0)
+		return -1;
+
+	/* Allocate the blocks now, a full SD card should fail here and not
+	   with SIGBUS in the middle of a session */
+	if ((err = posix_fallocate(rec->fd, 0, RECORD_HEADER_SIZE + capacity)) != 0) {
+		errno = err;
+		goto fail;
+	}
+	if (map_file(rec, 1) < 0)
+		goto fail;
+
+	memcpy(rec->header->magic, RECORD_MAGIC, sizeof(rec->header->magic));
+	rec->header->capacity = capacity;
+	rec->header->head = 0;
+	rec->header->tail = 0;
+	rec->header->frames = 0;
+	return 0;
+
+fail:
+	err = errno;
+	close(rec->fd);
+	rec->fd = -1;
+	errno = err;
+	return -1;
+}
+
+void record_append(struct recording *rec, const uint8_t *frame, size_t len, uint64_t now_us)
+{
+	struct record_header *hdr = rec->header;
+	uint64_t head = hdr->head;
+
+	if (len > hdr->capacity)
+		return;
+
+	if (hdr->capacity - head < len) {
+		/* Frames before the end are dropped with the wrap */
+		while (hdr->frames > 0 && hdr->tail >= head) {
+			hdr->tail += frame_at(rec, hdr->tail);
+			hdr->frames--;
+			if (frame_at(rec, hdr->tail) == 0)
+				hdr->tail = 0;
+		}
+		/* Mark the end as empty so readers wrap here too */
+		if (hdr->capacity - head >= 2)
+			memset(rec->ring + head, 0, 2);
+		head = 0;
+	}
+
+	/* Make room by dropping the oldest frames the new one overlaps */
+	while (hdr->frames > 0 && hdr->tail >= head && hdr->tail < head + len) {
+		size_t old = frame_at(rec, hdr->tail);
+		hdr->tail += old;
+		hdr->frames--;
+		if (old == 0 || frame_at(rec, hdr->tail) == 0)
+			hdr->tail = 0;
+	}
+
+	memcpy(rec->ring + head, frame, len);
+	if (hdr->frames == 0)
+		hdr->tail = head;
+	hdr->head = head + len;
+	hdr->frames++;
+
+	if (now_us - rec->last_sync_us >= RECORD_SYNC_US) {
+		msync(rec->map, rec->map_size, MS_ASYNC);
+		rec->last_sync_us = now_us;
+	}
+}
+
+int record_open(struct recording *rec, const char *path)
+{
+	memset(rec, 0, sizeof(*rec));
+	rec->fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (rec->fd < 0)
+		return -1;
+	if (map_file(rec, 0) < 0 || rec->map_size < RECORD_HEADER_SIZE ||
+		memcmp(rec->header->magic, RECORD_MAGIC, sizeof(rec->header->magic)) != 0 ||
+		rec->header->capacity > rec->map_size - RECORD_HEADER_SIZE) {
+		record_close(rec);
+		errno = EINVAL;
+		return -1;
+	}
+	return 0;
+}
+
+int record_next(const struct recording *rec, uint64_t *offset, uint64_t *remaining, const uint8_t **frame, size_t *len)
+{
+	size_t n;
+
+	if (*remaining == 0)
+		return 0;
+	if ((n = frame_at(rec, *offset)) == 0) {
+		*offset = 0;
+		if ((n = frame_at(rec, 0)) == 0)
+			return 0;
+	}
+
+	*frame = rec->ring + *offset;
+	*len = n;
+	*offset += n;
+	(*remaining)--;
+	return 1;
+}
+
+void record_close(struct recording *rec)
+{
+	if (rec->map != NULL) {
+		msync(rec->map, rec->map_size, MS_SYNC);
+		munmap(rec->map, rec->map_size);
+		rec->map = NULL;
+	}
+	if (rec->fd >= 0)
+		close(rec->fd);
+	rec->fd = -1;
+}
@@ -0,0 +1,75 @@
+/*
+ * record.h
+ *
+ * Copyright (c) 2020 RetroSpy Technologies
+ */
+
+ /*
+  * This program is free software; you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation; either version 2 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program; if not, write to the Free Software
+  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  * 02110-1301 USA.
+  */
+
+#ifndef __RECORD_H__
+#define __RECORD_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* A recording is a preallocated file mapped into memory: a header followed
+   by a ring of binary frames (see frame.h), each carrying its own length and
+   timestamp. Frames never straddle the end of the ring; when one does not
+   fit, the writer wraps to the start and overwrites the oldest frames. */
+#define RECORD_MAGIC "RSREC01"
+#define RECORD_HEADER_SIZE 64
+#define RECORD_DEFAULT_CAPACITY (16 * 1024 * 1024)
+
+/* Dirty pages are pushed to the file at most this often while recording */
+#define RECORD_SYNC_US 1000000
+
+struct record_header {
+	char magic[8];
+	uint64_t capacity;	/* Bytes in the ring */
+	uint64_t head;		/* Ring offset of the next frame to write */
+	uint64_t tail;		/* Ring offset of the oldest frame */
+	uint64_t frames;	/* Frames in the ring */
+	uint8_t reserved[RECORD_HEADER_SIZE - 40];
+};
+
+struct recording {
+	int fd;
+	uint8_t *map;
+	size_t map_size;
+	struct record_header *header;
+	uint8_t *ring;
+	uint64_t last_sync_us;
+};
+
+/* Creates path with room for capacity bytes of frames and maps it. */
+int record_create(struct recording *rec, const char *path, size_t capacity);
+
+/* Copies one binary frame into the ring. No system calls, apart from the
+   msync every RECORD_SYNC_US. */
+void record_append(struct recording *rec, const uint8_t *frame, size_t len, uint64_t now_us);
+
+/* Maps an existing recording read only. */
+int record_open(struct recording *rec, const char *path);
+
+/* Walks the frames oldest first. Start with *offset = rec->header->tail
+   and *remaining = rec->header->frames. Returns 0 after the last frame. */
+int record_next(const struct recording *rec, uint64_t *offset, uint64_t *remaining, const uint8_t **frame, size_t *len);
+
+void record_close(struct recording *rec);
+
+#endif
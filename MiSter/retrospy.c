@@ -1,9 +1,9 @@
 /*
- * retrospy.c Version 1.0
+ * retrospy.c Version 1.3
  *
  * Copyright (c) 2020 RetroSpy Technologies
  *
- * Based on jstest.c Version 1.2
+ * Based on jstest.c Version 1.3
  */
 
  /*
@@ -23,167 +23,292 @@
   * 02110-1301 USA.
   */
 
-#include <sys/ioctl.h>
-#include <sys/time.h>
-#include <sys/types.h>
 #include <stdlib.h>
-#include <fcntl.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
-#include <stdlib.h>
 #include <stdint.h>
 
-#include <linux/input.h>
-#include <linux/joystick.h>
-
-#include "axbtnmap.h"
+#include "device.h"
+#include "frame.h"
+#include "hotplug.h"
+#include "record.h"
+#include "server.h"
 
-char *axis_names[ABS_MAX + 1] = {
-"X", "Y", "Z", "Rx", "Ry", "Rz", "Throttle", "Rudder",
-"Wheel", "Gas", "Brake", "?", "?", "?", "?", "?",
-"Hat0X", "Hat0Y", "Hat1X", "Hat1Y", "Hat2X", "Hat2Y", "Hat3X", "Hat3Y",
-"?", "?", "?", "?", "?", "?", "?",
+struct output {
+	int binary;
+	int tagged;	/* Text lines start with the device index */
+	struct server *tcp;	/* Frames go to viewers instead of stdout */
+	struct server *udp;
+	struct recording *rec;	/* Every frame is also appended here */
 };
 
-char *button_names[KEY_MAX - BTN_MISC + 1] = {
-"Btn0", "Btn1", "Btn2", "Btn3", "Btn4", "Btn5", "Btn6", "Btn7", "Btn8", "Btn9",
-"?", "?", "?", "?", "?", "?","LeftBtn", "RightBtn", "MiddleBtn", "SideBtn", 
-"ExtraBtn", "ForwardBtn", "BackBtn", "TaskBtn", "?", "?", "?", "?", "?", "?", 
-"?", "?", "Trigger", "ThumbBtn", "ThumbBtn2", "TopBtn", "TopBtn2", "PinkieBtn",
-"BaseBtn", "BaseBtn2", "BaseBtn3", "BaseBtn4", "BaseBtn5", "BaseBtn6", 
-"BtnDead", "BtnA", "BtnB", "BtnC", "BtnX", "BtnY", "BtnZ", "BtnTL", "BtnTR", 
-"BtnTL2", "BtnTR2", "BtnSelect", "BtnStart", "BtnMode", "BtnThumbL", 
-"BtnThumbR", "?", "?", "?", "?", "?", "?", "?", "?", "?", "?", "?", "?", "?", 
-"?", "?", "?", "?", "WheelBtn", "Gear up",
-};
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-b] [-e] [-r rate] [-l port] [-u port] [-w file [-s MiB]] [device...]\n", prog);
+	fprintf(stderr, "       %s [-b] [-l port] [-u port] [-f] -p file\n", prog);
+	fprintf(stderr, "  device   /dev/input/jsX, or /dev/input/eventX for kernel timestamps and whole reports.\n");
+	fprintf(stderr, "           Without one every joystick in " HOTPLUG_INPUT_DIR " is served as it is plugged in.\n");
+	fprintf(stderr, "  -b       binary frames (see frame.h) instead of text, messages go to stderr\n");
+	fprintf(stderr, "  -e       serve event devices rather than js devices when none are listed\n");
+	fprintf(stderr, "  -r rate  emit frames at a fixed rate in Hz instead of on every change\n");
+	fprintf(stderr, "  -l port  serve frames to TCP viewers on port instead of stdout\n");
+	fprintf(stderr, "  -u port  serve frames over UDP to every address that sends a datagram to port\n");
+	fprintf(stderr, "  -w file  record every frame into a ring file of -s MiB (default %d)\n", RECORD_DEFAULT_CAPACITY >> 20);
+	fprintf(stderr, "  -p file  replay a recording at its original speed, or as fast as possible with -f\n");
+	fprintf(stderr, "Text frames carry an \"index:\" prefix when more than one device can be served.\n");
+}
 
-#define NAME_LENGTH 128
+static int write_all(int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
 
-int main(int argc, char **argv)
+	while (len > 0) {
+		ssize_t n = write(fd, p, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/* Encodes the frame into one buffer so it leaves in a single write() */
+static int emit_frame(const struct frame *f, const struct output *out)
 {
-	int fd, i;
-	unsigned char axes = 2;
-	unsigned char buttons = 2;
-	int version = 0x000800;
-	char name[NAME_LENGTH] = "Unknown";
-	uint16_t btnmap[BTNMAP_SIZE];
-	uint8_t axmap[AXMAP_SIZE];
-	int btnmapok = 1;
-
-	if ((fd = open(argv[argc - 1], O_RDONLY)) < 0) {
-		perror("jstest");
-		return 1;
+	static char buf[FRAME_MAX + 8];
+	static uint8_t binary[FRAME_BINARY_MAX];
+	size_t len = 0;
+
+	if (out->binary) {
+		len = frame_encode_binary(f, (uint8_t *)buf);
+	}
+	else {
+		if (out->tagged)
+			len = sprintf(buf, "%d:", f->device);
+		len += frame_encode_text(f, buf + len);
 	}
 
-	ioctl(fd, JSIOCGVERSION, &version);
-	ioctl(fd, JSIOCGAXES, &axes);
-	ioctl(fd, JSIOCGBUTTONS, &buttons);
-	ioctl(fd, JSIOCGNAME(NAME_LENGTH), name);
+	if (out->rec != NULL) {
+		if (out->binary)
+			record_append(out->rec, (const uint8_t *)buf, len, monotonic_us());
+		else
+			record_append(out->rec, binary, frame_encode_binary(f, binary), monotonic_us());
+	}
 
-	getaxmap(fd, axmap);
-	getbtnmap(fd, btnmap);
+	if (out->tcp != NULL || out->udp != NULL) {
+		if (out->tcp != NULL)
+			server_send(out->tcp, buf, len);
+		if (out->udp != NULL)
+			server_send(out->udp, buf, len);
+		return 0;
+	}
+	return write_all(STDOUT_FILENO, buf, len);
+}
 
-	printf("Driver version is %d.%d.%d.\n",
-		version >> 16, (version >> 8) & 0xff, version & 0xff);
+static int write_frame(int index, const struct device *dev, void *context)
+{
+	struct frame f;
 
-	/* Determine whether the button map is usable. */
-	for (i = 0; btnmapok && i < buttons; i++) {
-		if (btnmap[i] < BTN_MISC || btnmap[i] > KEY_MAX) {
-			btnmapok = 0;
-			break;
+	f.device = index;
+	f.axes = dev->axes;
+	f.buttons = dev->buttons;
+	f.timestamp_us = dev->timestamp_us;
+	f.axis = dev->axis;
+	f.button = dev->button;
+
+	return emit_frame(&f, context);
+}
+
+/* Plays a recording through the normal outputs. The hotplug loop keeps
+   running in the gaps so viewers can still connect. */
+static int replay(struct hotplug *hp, const char *path, int fast, const struct output *out)
+{
+	static int axis[255];
+	static char button[255];
+	struct recording rec;
+	uint64_t offset, remaining, first_us = 0, start_us = 0;
+	const uint8_t *data;
+	size_t len;
+	struct frame f;
+
+	if (record_open(&rec, path) < 0)
+		return -1;
+
+	offset = rec.header->tail;
+	remaining = rec.header->frames;
+	while (record_next(&rec, &offset, &remaining, &data, &len)) {
+		if (frame_decode_binary(data, len, &f, axis, button) < 0)
+			continue;
+
+		if (!fast) {
+			if (start_us == 0) {
+				first_us = f.timestamp_us;
+				start_us = monotonic_us();
+			}
+			for (;;) {
+				int64_t wait = (int64_t)(start_us + (f.timestamp_us - first_us)) - (int64_t)monotonic_us();
+				if (wait <= 0)
+					break;
+				if (hotplug_wait(hp, (int)((wait + 999) / 1000)) < 0)
+					goto fail;
+			}
 		}
+		if (emit_frame(&f, out) < 0)
+			goto fail;
 	}
-	if (!btnmapok) {
-		/* btnmap out of range for names. Don't print any. */
-		puts("jstest is not fully compatible with your kernel. Unable to retrieve button map!");
-		printf("Joystick (%s) has %d axes ", name, axes);
-		printf("and %d buttons.\n", buttons);
-	}
-	else {
-		printf("Joystick (%s) has %d axes (", name, axes);
-		for (i = 0; i < axes; i++)
-			printf("%s%s", i > 0 ? ", " : "", axis_names[axmap[i]]);
-		puts(")");
-
-		printf("and %d buttons (", buttons);
-		for (i = 0; i < buttons; i++) {
-			printf("%s%s", i > 0 ? ", " : "", button_names[btnmap[i] - BTN_MISC]);
+
+	record_close(&rec);
+	return 0;
+
+fail:
+	record_close(&rec);
+	return -1;
+}
+
+int main(int argc, char **argv)
+{
+	int opt, i;
+	int rate = 0;
+	int events = 0;
+	int tcp_port = 0;
+	int udp_port = 0;
+	int fast = 0;
+	const char *record_path = NULL;
+	const char *replay_path = NULL;
+	size_t record_size = RECORD_DEFAULT_CAPACITY;
+	FILE *info;
+	struct output out = { 0, 0, NULL, NULL, NULL };
+	struct hotplug hp;
+	struct server tcp, udp;
+	struct recording rec;
+
+	while ((opt = getopt(argc, argv, "befl:p:r:s:u:w:")) != -1) {
+		switch (opt) {
+		case 'b':
+			out.binary = 1;
+			break;
+		case 'e':
+			events = 1;
+			break;
+		case 'f':
+			fast = 1;
+			break;
+		case 'l':
+			tcp_port = atoi(optarg);
+			break;
+		case 'p':
+			replay_path = optarg;
+			break;
+		case 'r':
+			rate = atoi(optarg);
+			break;
+		case 's':
+			record_size = (size_t)atoi(optarg) << 20;
+			break;
+		case 'w':
+			record_path = optarg;
+			break;
+		case 'u':
+			udp_port = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
 		}
-		puts(").");
 	}
 
-	close(fd);
+	/* Binary frames own stdout, so the device descriptions move aside */
+	info = out.binary ? stderr : stdout;
+	out.tagged = optind == argc || argc - optind > 1;
 
-	int *axis;
-	char *button;
-	int k = 0;
-	struct js_event js;
+	int64_t period = rate > 0 ? 1000000 / rate : 0;
+	int64_t deadline = monotonic_us() + period;
 
-	axis = calloc(axes, sizeof(int));
-	button = calloc(buttons, sizeof(char));
+	/* At a fixed rate reports only update the state, the timer samples it */
+	if (hotplug_init(&hp, optind == argc && replay_path == NULL ? (events ? "event" : "js") : NULL, info,
+		period == 0 ? write_frame : NULL, &out) < 0) {
+		perror("jstest");
+		return 1;
+	}
 
-	while (1) {
-		if ((fd = open(argv[argc - 1], O_RDONLY)) < 0) {
-			perror("jstest");
+	if (tcp_port > 0) {
+		if (server_open(&tcp, &hp, info, tcp_port, 0) < 0) {
+			perror("jstest: TCP server");
 			return 1;
 		}
-		k = 0;
-
-		while (k < axes + buttons)
-		{
-			if (read(fd, &js, sizeof(struct js_event)) 
-				!= sizeof(struct js_event)) 
-			{
-				perror("\njstest: error reading");
-				return 1;
-			}
+		out.tcp = &tcp;
+	}
+	if (udp_port > 0) {
+		if (server_open(&udp, &hp, info, udp_port, 1) < 0) {
+			perror("jstest: UDP server");
+			return 1;
+		}
+		out.udp = &udp;
+	}
 
-			switch (js.type & ~JS_EVENT_INIT) {
-			case JS_EVENT_BUTTON:
-				button[js.number] = js.value;
-				break;
-			case JS_EVENT_AXIS:
-				axis[js.number] = js.value;
-				break;
-			}
-			k++;
+	if (record_path != NULL) {
+		if (record_create(&rec, record_path, record_size) < 0) {
+			perror("jstest: recording");
+			return 1;
 		}
+		out.rec = &rec;
+	}
 
-		close(fd);
+	if (replay_path != NULL) {
+		/* Recordings carry the device index, keep it on text lines */
+		out.tagged = 1;
+		i = replay(&hp, replay_path, fast, &out) < 0;
+		if (i)
+			perror("jstest: replay");
+		goto done;
+	}
 
-		for (int j = 0; j < 8; ++j)
-			printf("%d", (axes & (1 << j)) != 0);
+	for (i = optind; i < argc; i++) {
+		if (hotplug_add(&hp, argv[i]) < 0) {
+			perror("jstest");
+			return 1;
+		}
+	}
+	hotplug_scan(&hp);
 
-		for (int j = 0; j < 8; ++j)
-			printf("%d", (buttons & (1 << j)) != 0);
+	while (1) {
+		int timeout = -1;
 
-		for (i = 0; i < buttons; ++i)
-		{
-			printf(button[i] != 0 ? "1" : "0");
+		if (period > 0) {
+			int64_t wait = deadline - (int64_t)monotonic_us();
+			timeout = wait > 0 ? (int)((wait + 999) / 1000) : 0;
 		}
 
-		for (i = 0; i < axes; i++)
-		{
-			for (int j = 0; j < sizeof(int) * 8; ++j)
-				printf("%d", (axis[i] & (1 << j)) != 0);
+		if (hotplug_wait(&hp, timeout) < 0) {
+			perror("\njstest");
+			break;
 		}
 
-		//Probably could reduce the bandwidth by outputing the axes values 
-		//directly, but can do it later.
-
-		/*
-		printf("%d|%d|", axes, buttons);
-		for (i = 0; i < buttons; ++i)
-		{
-			printf(button[i] != 0 ? "1" : "0|");
+		if (period > 0 && (int64_t)monotonic_us() >= deadline) {
+			/* Fixed rate, the state is sampled whether it moved or not */
+			if (hotplug_each(&hp, write_frame, &out) < 0) {
+				perror("\njstest");
+				break;
+			}
+			deadline += period;
+			if (deadline < (int64_t)monotonic_us())
+				deadline = monotonic_us() + period;
 		}
-		printf("|");
-		for (i = 0; i < axes; i++)
-		{
-			printf("%d|", axis[i]);
-		}*/
-		printf("\n");
 	}
-}
\ No newline at end of file
+
+	i = 1;
+done:
+	if (out.rec != NULL)
+		record_close(out.rec);
+	if (out.tcp != NULL)
+		server_close(out.tcp);
+	if (out.udp != NULL)
+		server_close(out.udp);
+	hotplug_close(&hp);
+	return i;
+}
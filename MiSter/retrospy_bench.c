@@ -0,0 +1,525 @@
+/*
+ * retrospy_bench.c
+ *
+ * Copyright (c) 2020 RetroSpy Technologies
+ */
+
+ /*
+  * This program is free software; you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation; either version 2 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program; if not, write to the Free Software
+  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  * 02110-1301 USA.
+  */
+
+
+/* Latency and throughput benchmark for the bridge.
+
+   Creates a virtual gamepad through /dev/uinput, starts retrospy in binary
+   mode on its event node and injects reports at a fixed rate. Every report
+   carries a sequence number in ABS_X, so each frame coming out of the bridge
+   can be matched with the moment it was injected.
+
+   Runs on any Linux host with uinput, no MiSTer needed:
+
+	gcc -O2 -o retrospy_bench retrospy_bench.c frame.c
+	sudo ./retrospy_bench -x ./retrospy -r 1000 -n 10000
+
+   Arguments after -- are passed on to the bridge, e.g. -- -r 500. */
+
+#define _GNU_SOURCE	/* ppoll */
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <linux/input.h>
+#include <linux/uinput.h>
+
+#include "frame.h"
+
+#ifndef UI_GET_SYSNAME
+#define UI_GET_SYSNAME(len) _IOC(_IOC_READ, UINPUT_IOCTL_BASE, 44, len)
+#endif
+
+#define BENCH_BUTTONS 8
+#define BENCH_MARKER_RANGE 65535	/* ABS_X spans -32767..32767 */
+#define BENCH_MAX_ARGS 32
+#define BENCH_MAX_BURST 64
+
+static const int bench_buttons[BENCH_BUTTONS] = {
+	BTN_SOUTH, BTN_EAST, BTN_NORTH, BTN_WEST, BTN_TL, BTN_TR, BTN_SELECT, BTN_START
+};
+
+struct bench {
+	long count;		/* Reports to inject */
+	long rate;		/* Reports per second */
+	int burst;		/* Reports written back to back */
+	uint64_t *injected_us;	/* Per sequence number, 0 until injected */
+	uint64_t *output_us;	/* When its frame was read from the bridge, 0 if never */
+	uint64_t *kernel_us;	/* Timestamp the frame carried */
+	long next;		/* Next sequence number to inject */
+	long last_seen;		/* Highest sequence number read back */
+	long frames;		/* Frames read, the initial state excluded */
+	long stale;		/* Frames that did not carry a newer report */
+};
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-x bridge] [-r rate] [-n count] [-B burst] [-t p99-us] [-- bridge options]\n", prog);
+	fprintf(stderr, "  -x bridge  retrospy binary to run (default ./retrospy)\n");
+	fprintf(stderr, "  -r rate    reports per second to inject (default 1000)\n");
+	fprintf(stderr, "  -n count   reports to inject (default 10000)\n");
+	fprintf(stderr, "  -B burst   reports written back to back per wakeup (default 1)\n");
+	fprintf(stderr, "  -t p99-us  exit with 2 when the 99th percentile latency is above this\n");
+	fprintf(stderr, "Build with: gcc -O2 -o retrospy_bench retrospy_bench.c frame.c\n");
+}
+
+static int set_event(struct input_event *ev, int type, int code, int value)
+{
+	memset(ev, 0, sizeof(*ev));
+	ev->type = type;
+	ev->code = code;
+	ev->value = value;
+	return 1;
+}
+
+static int create_pad(void)
+{
+	struct uinput_user_dev setup;
+	int fd, i;
+
+	fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+	if (fd < 0) {
+		perror("retrospy_bench: /dev/uinput");
+		return -1;
+	}
+
+	ioctl(fd, UI_SET_EVBIT, EV_KEY);
+	for (i = 0; i < BENCH_BUTTONS; ++i)
+		ioctl(fd, UI_SET_KEYBIT, bench_buttons[i]);
+	ioctl(fd, UI_SET_EVBIT, EV_ABS);
+	ioctl(fd, UI_SET_ABSBIT, ABS_X);
+	ioctl(fd, UI_SET_ABSBIT, ABS_Y);
+
+	/* The legacy setup struct works on every kernel with uinput */
+	memset(&setup, 0, sizeof(setup));
+	snprintf(setup.name, UINPUT_MAX_NAME_SIZE, "RetroSpy bench pad");
+	setup.id.bustype = BUS_VIRTUAL;
+	setup.id.vendor = 0x1209;
+	setup.id.product = 0x5250;
+	setup.id.version = 1;
+	/* A symmetric range the bridge scales 1:1, so ABS_X comes out as written */
+	setup.absmin[ABS_X] = setup.absmin[ABS_Y] = -32767;
+	setup.absmax[ABS_X] = setup.absmax[ABS_Y] = 32767;
+
+	if (write(fd, &setup, sizeof(setup)) != sizeof(setup) || ioctl(fd, UI_DEV_CREATE) < 0) {
+		perror("retrospy_bench: creating the virtual pad");
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/* Finds /dev/input/eventN for the pad and waits for udev to make it readable. */
+static int find_event_node(int fd, char *path, size_t size)
+{
+	char sysname[64], dir[128];
+	struct dirent *entry;
+	DIR *d;
+	int tries;
+
+	if (ioctl(fd, UI_GET_SYSNAME(sizeof(sysname)), sysname) < 0) {
+		perror("retrospy_bench: UI_GET_SYSNAME");
+		return -1;
+	}
+	snprintf(dir, sizeof(dir), "/sys/devices/virtual/input/%.60s", sysname);
+
+	for (tries = 0; tries < 200; ++tries) {
+		d = opendir(dir);
+		if (d != NULL) {
+			while ((entry = readdir(d)) != NULL) {
+				if (strncmp(entry->d_name, "event", 5) == 0) {
+					snprintf(path, size, "/dev/input/%.32s", entry->d_name);
+					break;
+				}
+			}
+			closedir(d);
+			if (entry != NULL && access(path, R_OK) == 0)
+				return 0;
+		}
+		usleep(10000);
+	}
+	fprintf(stderr, "retrospy_bench: no readable event node under %s\n", dir);
+	return -1;
+}
+
+static pid_t start_bridge(const char *bridge, const char *node, char **extra, int extras, int *out)
+{
+	char *args[BENCH_MAX_ARGS + 4];
+	int fds[2], n = 0, i;
+	pid_t pid;
+
+	args[n++] = (char *)bridge;
+	args[n++] = "-b";
+	for (i = 0; i < extras && i < BENCH_MAX_ARGS; ++i)
+		args[n++] = extra[i];
+	args[n++] = (char *)node;
+	args[n] = NULL;
+
+	if (pipe(fds) < 0) {
+		perror("retrospy_bench: pipe");
+		return -1;
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		perror("retrospy_bench: fork");
+		return -1;
+	}
+	if (pid == 0) {
+		dup2(fds[1], STDOUT_FILENO);
+		close(fds[0]);
+		close(fds[1]);
+		execvp(bridge, args);
+		perror(bridge);
+		_exit(127);
+	}
+
+	close(fds[1]);
+	fcntl(fds[0], F_SETFL, O_NONBLOCK);
+	*out = fds[0];
+	return pid;
+}
+
+/* CPU time the bridge has used so far, in nanoseconds */
+static uint64_t bridge_cpu_ns(pid_t pid)
+{
+	char path[64], buf[512], *p;
+	unsigned long long ns, utime, stime;
+	FILE *f;
+	int i;
+
+	snprintf(path, sizeof(path), "/proc/%d/schedstat", (int)pid);
+	f = fopen(path, "r");
+	if (f != NULL) {
+		if (fscanf(f, "%llu", &ns) != 1)
+			ns = 0;
+		fclose(f);
+		if (ns != 0)
+			return ns;
+	}
+
+	/* Without schedstat fall back to utime + stime in clock ticks */
+	snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+	f = fopen(path, "r");
+	if (f == NULL)
+		return 0;
+	p = fgets(buf, sizeof(buf), f);
+	fclose(f);
+	if (p == NULL || (p = strrchr(buf, ')')) == NULL)
+		return 0;
+	/* utime and stime are the 12th and 13th fields after the name */
+	for (i = 0; i < 11 && p != NULL; ++i)
+		p = strchr(p + 1, ' ');
+	if (p == NULL || sscanf(p, " %llu %llu", &utime, &stime) != 2)
+		return 0;
+	return (utime + stime) * (1000000000ULL / sysconf(_SC_CLK_TCK));
+}
+
+/* Writes one burst of reports, each one its own SYN_REPORT */
+static int inject(struct bench *b, int fd)
+{
+	struct input_event ev[BENCH_MAX_BURST * 3];
+	int n = 0, reports = 0;
+	long seq;
+
+	while (reports < b->burst && b->next < b->count) {
+		seq = b->next++;
+		n += set_event(&ev[n], EV_ABS, ABS_X, (int)(seq % BENCH_MARKER_RANGE) - 32767);
+		n += set_event(&ev[n], EV_KEY, bench_buttons[seq % BENCH_BUTTONS], (int)((seq / BENCH_BUTTONS) & 1));
+		n += set_event(&ev[n], EV_SYN, SYN_REPORT, 0);
+		++reports;
+	}
+
+	b->injected_us[b->next - reports] = now_us();
+	for (seq = b->next - reports + 1; seq < b->next; ++seq)
+		b->injected_us[seq] = b->injected_us[b->next - reports];
+
+	if (write(fd, ev, n * sizeof(ev[0])) != (ssize_t)(n * sizeof(ev[0]))) {
+		perror("retrospy_bench: writing to uinput");
+		return -1;
+	}
+	return 0;
+}
+
+/* Matches a frame with the report it carries. The marker wraps, so it is
+   taken relative to the last report seen. */
+static void consume(struct bench *b, const struct frame *f, uint64_t t)
+{
+	long marker, seq;
+
+	if (f->axes < 1)
+		return;
+
+	marker = f->axis[0] + 32767;
+	seq = b->last_seen + ((marker - (b->last_seen + BENCH_MARKER_RANGE) % BENCH_MARKER_RANGE) + BENCH_MARKER_RANGE) % BENCH_MARKER_RANGE;
+
+	++b->frames;
+	if (seq <= b->last_seen || seq >= b->next) {
+		++b->stale;
+		return;
+	}
+	b->last_seen = seq;
+	b->output_us[seq] = t;
+	b->kernel_us[seq] = f->timestamp_us;
+}
+
+/* Reads whatever the bridge has written and matches every complete frame */
+static int drain(struct bench *b, int fd, uint8_t *buf, size_t *len, size_t size, int *ready)
+{
+	static int axis[255];
+	static char button[255];
+	struct frame f;
+	size_t off, flen;
+	ssize_t n;
+	uint64_t t;
+
+	for (;;) {
+		n = read(fd, buf + *len, size - *len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN)
+				return 0;
+			perror("retrospy_bench: reading the bridge");
+			return -1;
+		}
+		if (n == 0) {
+			fprintf(stderr, "retrospy_bench: the bridge exited\n");
+			return -1;
+		}
+		t = now_us();
+		*len += n;
+
+		for (off = 0; *len - off >= FRAME_HEADER_SIZE; off += flen) {
+			flen = buf[off + 6] | (buf[off + 7] << 8);
+			if (buf[off] != FRAME_MAGIC0 || buf[off + 1] != FRAME_MAGIC1 || flen < FRAME_HEADER_SIZE) {
+				fprintf(stderr, "retrospy_bench: bad frame from the bridge\n");
+				return -1;
+			}
+			if (*len - off < flen)
+				break;
+			if (frame_decode_binary(buf + off, flen, &f, axis, button) < 0)
+				return -1;
+			/* The first frame is the state on open, it tells us the
+			   bridge is ready */
+			if (!*ready)
+				*ready = 1;
+			else
+				consume(b, &f, t);
+		}
+		memmove(buf, buf + off, *len - off);
+		*len -= off;
+	}
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return x < y ? -1 : x > y;
+}
+
+static uint64_t percentile(const uint64_t *sorted, long n, double p)
+{
+	long i = (long)(p * (n - 1) + 0.5);
+	return n > 0 ? sorted[i] : 0;
+}
+
+static void print_latency(const char *name, uint64_t *values, long n)
+{
+	qsort(values, n, sizeof(values[0]), compare_u64);
+	printf("%-18s p50 %6llu  p90 %6llu  p99 %6llu  p99.9 %6llu  max %6llu us\n", name,
+		(unsigned long long)percentile(values, n, 0.50),
+		(unsigned long long)percentile(values, n, 0.90),
+		(unsigned long long)percentile(values, n, 0.99),
+		(unsigned long long)percentile(values, n, 0.999),
+		(unsigned long long)(n > 0 ? values[n - 1] : 0));
+}
+
+int main(int argc, char **argv)
+{
+	struct bench b;
+	const char *bridge = "./retrospy";
+	char node[64];
+	static uint8_t buf[1 << 16];
+	size_t len = 0;
+	uint64_t *end_to_end, *bridge_only, start_us, elapsed_us, deadline, interval_us, cpu_start, cpu_ns, t;
+	long delivered = 0, merged = 0, lost, seq, threshold = -1;
+	int pad, out, opt, ready = 0, status = 1, p99_failed = 0;
+	struct pollfd pfd;
+	struct timespec timeout;
+	pid_t pid;
+
+	memset(&b, 0, sizeof(b));
+	b.count = 10000;
+	b.rate = 1000;
+	b.burst = 1;
+	b.last_seen = -1;
+
+	while ((opt = getopt(argc, argv, "x:r:n:B:t:h")) != -1) {
+		switch (opt) {
+		case 'x':
+			bridge = optarg;
+			break;
+		case 'r':
+			b.rate = atol(optarg);
+			break;
+		case 'n':
+			b.count = atol(optarg);
+			break;
+		case 'B':
+			b.burst = atoi(optarg);
+			break;
+		case 't':
+			threshold = atol(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (b.rate <= 0 || b.count <= 0 || b.burst <= 0 || b.burst > BENCH_MAX_BURST) {
+		fprintf(stderr, "retrospy_bench: rate and count must be positive, burst 1 to %d\n", BENCH_MAX_BURST);
+		return 1;
+	}
+
+	b.injected_us = calloc(b.count, sizeof(uint64_t));
+	b.output_us = calloc(b.count, sizeof(uint64_t));
+	b.kernel_us = calloc(b.count, sizeof(uint64_t));
+	end_to_end = calloc(b.count, sizeof(uint64_t));
+	bridge_only = calloc(b.count, sizeof(uint64_t));
+	if (!b.injected_us || !b.output_us || !b.kernel_us || !end_to_end || !bridge_only) {
+		fprintf(stderr, "retrospy_bench: out of memory\n");
+		return 1;
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+
+	pad = create_pad();
+	if (pad < 0)
+		return 1;
+	if (find_event_node(pad, node, sizeof(node)) < 0)
+		goto done_pad;
+
+	pid = start_bridge(bridge, node, argv + optind, argc - optind, &out);
+	if (pid < 0)
+		goto done_pad;
+
+	pfd.fd = out;
+	pfd.events = POLLIN;
+
+	/* Wait for the initial state so startup is not measured */
+	deadline = now_us() + 5000000;
+	while (!ready && now_us() < deadline) {
+		if (poll(&pfd, 1, 100) > 0 && drain(&b, out, buf, &len, sizeof(buf), &ready) < 0)
+			goto done_bridge;
+	}
+	if (!ready) {
+		fprintf(stderr, "retrospy_bench: the bridge sent nothing for %s\n", node);
+		goto done_bridge;
+	}
+
+	interval_us = (uint64_t)b.burst * 1000000 / b.rate;
+	cpu_start = bridge_cpu_ns(pid);
+	start_us = now_us();
+	deadline = start_us;
+
+	/* Inject on schedule and read frames in between. After the last report
+	   give the bridge a second to catch up. */
+	for (;;) {
+		t = now_us();
+		if (b.next < b.count && t >= deadline) {
+			if (inject(&b, pad) < 0)
+				goto done_bridge;
+			deadline += interval_us;
+			continue;
+		}
+		if (b.next >= b.count) {
+			if (b.last_seen == b.count - 1 || t >= deadline + 1000000)
+				break;
+			t = deadline + 1000000 - t;
+		}
+		else {
+			t = deadline - t;
+		}
+		timeout.tv_sec = t / 1000000;
+		timeout.tv_nsec = (t % 1000000) * 1000;
+		if (ppoll(&pfd, 1, &timeout, NULL) > 0 && drain(&b, out, buf, &len, sizeof(buf), &ready) < 0)
+			goto done_bridge;
+	}
+	elapsed_us = now_us() - start_us;
+	cpu_ns = bridge_cpu_ns(pid) - cpu_start;
+
+	for (seq = 0; seq < b.count; ++seq) {
+		if (b.output_us[seq] == 0)
+			continue;
+		end_to_end[delivered] = b.output_us[seq] - b.injected_us[seq];
+		bridge_only[delivered] = b.output_us[seq] > b.kernel_us[seq] ? b.output_us[seq] - b.kernel_us[seq] : 0;
+		++delivered;
+	}
+	/* A report is merged when a later one made it out, lost when none did */
+	lost = b.count - 1 - b.last_seen;
+	merged = b.count - lost - delivered;
+
+	printf("device            %s\n", node);
+	printf("reports           %ld at %ld Hz, bursts of %d, %.3f s\n", b.count, b.rate, b.burst, elapsed_us / 1e6);
+	printf("frames            %ld (%ld without a newer report)\n", b.frames, b.stale);
+	printf("delivered         %ld, merged %ld, lost %ld\n", delivered, merged, lost);
+	print_latency("inject to output", end_to_end, delivered);
+	print_latency("kernel to output", bridge_only, delivered);
+	if (b.frames > 0)
+		printf("bridge cpu        %.1f us/frame, %.1f%% of one core\n", cpu_ns / 1000.0 / b.frames, cpu_ns / 10.0 / elapsed_us);
+
+	if (threshold >= 0 && delivered > 0 && percentile(end_to_end, delivered, 0.99) > (uint64_t)threshold)
+		p99_failed = 1;
+	status = p99_failed ? 2 : 0;
+
+done_bridge:
+	kill(pid, SIGTERM);
+	waitpid(pid, NULL, 0);
+	close(out);
+done_pad:
+	ioctl(pad, UI_DEV_DESTROY);
+	close(pad);
+	free(b.injected_us);
+	free(b.output_us);
+	free(b.kernel_us);
+	free(end_to_end);
+	free(bridge_only);
+	return status;
+}
@@ -0,0 +1,334 @@
+/*
+ * server.c
+ *
+ * Copyright (c) 2020 RetroSpy Technologies
+ */
+
+ /*
+  * This program is free software; you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation; either version 2 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program; if not, write to the Free Software
+  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  * 02110-1301 USA.
+  */
+
+#define _GNU_SOURCE	/* accept4 */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "server.h"
+
+#define RING_MASK (SERVER_QUEUE_BYTES - 1)
+
+static void drop_client(struct server *srv, struct server_client *c)
+{
+	fprintf(srv->info, "Viewer %d disconnected, %lu frames dropped.\n", (int)(c - srv->clients), c->dropped);
+	fflush(srv->info);
+	hotplug_unwatch_fd(srv->hp, c->fd);
+	close(c->fd);
+	free(c->ring);
+	c->fd = -1;
+	c->ring = NULL;
+}
+
+/* Sends as much of the queue as the socket takes right now. */
+static void flush_client(struct server *srv, struct server_client *c)
+{
+	while (c->count > 0) {
+		struct iovec iov[2];
+		struct msghdr msg;
+		size_t used = c->tail - c->head;
+		size_t start = c->head & RING_MASK;
+		ssize_t n;
+
+		iov[0].iov_base = c->ring + start;
+		iov[0].iov_len = used < SERVER_QUEUE_BYTES - start ? used : SERVER_QUEUE_BYTES - start;
+		iov[1].iov_base = c->ring;
+		iov[1].iov_len = used - iov[0].iov_len;
+
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+		msg.msg_iovlen = iov[1].iov_len > 0 ? 2 : 1;
+
+		n = sendmsg(c->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			drop_client(srv, c);
+			return;
+		}
+
+		c->head += n;
+		c->sent += n;
+		while (c->count > 0 && c->sent >= c->lengths[c->first]) {
+			c->sent -= c->lengths[c->first];
+			c->first = (c->first + 1) % SERVER_QUEUE_FRAMES;
+			c->count--;
+		}
+	}
+
+	/* Only ask to hear about writability while something is waiting */
+	if ((c->count > 0) != c->writing) {
+		c->writing = c->count > 0;
+		hotplug_modify_fd(srv->hp, c->fd, EPOLLIN | (c->writing ? EPOLLOUT : 0));
+	}
+}
+
+static void enqueue(struct server_client *c, const uint8_t *frame, size_t len)
+{
+	size_t start, first_part;
+
+	if (len > SERVER_QUEUE_BYTES || len > UINT16_MAX)
+		return;
+
+	while (c->count == SERVER_QUEUE_FRAMES || c->tail - c->head + len > SERVER_QUEUE_BYTES) {
+		/* A frame that is partly on the wire has to finish, so once it is
+		   the only one left the new frame is the one that goes */
+		if (c->count == 0 || (c->sent > 0 && c->count == 1)) {
+			c->dropped++;
+			return;
+		}
+		if (c->sent > 0) {
+			/* Drop the frame after the one in flight by sliding the
+			   partial frame forward over it */
+			unsigned int second = (c->first + 1) % SERVER_QUEUE_FRAMES;
+			size_t keep = c->lengths[c->first] - c->sent;
+			size_t skip = c->lengths[second];
+			size_t i;
+
+			for (i = keep; i > 0; i--)
+				c->ring[(c->head + skip + i - 1) & RING_MASK] = c->ring[(c->head + i - 1) & RING_MASK];
+			c->head += skip;
+			c->lengths[second] = c->lengths[c->first];
+			c->first = second;
+		}
+		else {
+			c->head += c->lengths[c->first];
+			c->first = (c->first + 1) % SERVER_QUEUE_FRAMES;
+		}
+		c->count--;
+		c->dropped++;
+	}
+
+	start = c->tail & RING_MASK;
+	first_part = len < SERVER_QUEUE_BYTES - start ? len : SERVER_QUEUE_BYTES - start;
+	memcpy(c->ring + start, frame, first_part);
+	memcpy(c->ring, frame + first_part, len - first_part);
+	c->tail += len;
+	c->lengths[(c->first + c->count) % SERVER_QUEUE_FRAMES] = len;
+	c->count++;
+}
+
+static void client_ready(int fd, uint32_t events, void *context)
+{
+	struct server_client *c = context;
+	struct server *srv = c->srv;
+	char discard[256];
+	ssize_t n;
+
+	(void)fd;
+
+	if (events & EPOLLIN) {
+		/* Viewers have nothing to say, anything read is dropped */
+		while ((n = recv(c->fd, discard, sizeof(discard), MSG_DONTWAIT)) > 0)
+			;
+		if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+			drop_client(srv, c);
+			return;
+		}
+	}
+	if (events & (EPOLLERR | EPOLLHUP)) {
+		drop_client(srv, c);
+		return;
+	}
+	if (events & EPOLLOUT)
+		flush_client(srv, c);
+}
+
+static void accept_ready(int fd, uint32_t events, void *context)
+{
+	struct server *srv = context;
+	int one = 1;
+	int client, i;
+
+	(void)events;
+	while ((client = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+		struct server_client *c = NULL;
+
+		for (i = 0; i < SERVER_MAX_CLIENTS; i++) {
+			if (srv->clients[i].fd < 0) {
+				c = &srv->clients[i];
+				break;
+			}
+		}
+		if (c == NULL) {
+			close(client);
+			continue;
+		}
+
+		/* Frames are small and latency is the point */
+		setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+		memset(c, 0, sizeof(*c));
+		c->srv = srv;
+		c->fd = client;
+		c->ring = malloc(SERVER_QUEUE_BYTES);
+		if (c->ring == NULL || hotplug_watch_fd(srv->hp, client, EPOLLIN, client_ready, c) < 0) {
+			free(c->ring);
+			c->ring = NULL;
+			c->fd = -1;
+			close(client);
+			continue;
+		}
+
+		fprintf(srv->info, "Viewer %d connected.\n", i);
+		fflush(srv->info);
+	}
+}
+
+static void udp_ready(int fd, uint32_t events, void *context)
+{
+	struct server *srv = context;
+	struct sockaddr_in addr;
+	socklen_t addrlen = sizeof(addr);
+	char discard[64];
+	int i, slot;
+
+	(void)events;
+	while (recvfrom(fd, discard, sizeof(discard), MSG_DONTWAIT, (struct sockaddr *)&addr, &addrlen) >= 0) {
+		const uint64_t now = monotonic_us();
+
+		/* Refresh the viewer, or take a free or expired entry */
+		slot = -1;
+		for (i = 0; i < SERVER_MAX_CLIENTS; i++) {
+			struct server_peer *p = &srv->peers[i];
+
+			if (p->last_seen_us != 0 && p->addr.sin_addr.s_addr == addr.sin_addr.s_addr &&
+				p->addr.sin_port == addr.sin_port) {
+				slot = i;
+				break;
+			}
+			if (slot < 0 && (p->last_seen_us == 0 || now - p->last_seen_us > SERVER_UDP_EXPIRY_US))
+				slot = i;
+		}
+		if (slot >= 0) {
+			srv->peers[slot].addr = addr;
+			srv->peers[slot].last_seen_us = now;
+		}
+		addrlen = sizeof(addr);
+	}
+}
+
+int server_open(struct server *srv, struct hotplug *hp, FILE *info, int port, int udp)
+{
+	struct sockaddr_in addr;
+	int one = 1;
+	int fd, i;
+
+	memset(srv, 0, sizeof(*srv));
+	srv->hp = hp;
+	srv->info = info;
+	srv->listen_fd = -1;
+	srv->udp_fd = -1;
+	for (i = 0; i < SERVER_MAX_CLIENTS; i++)
+		srv->clients[i].fd = -1;
+
+	fd = socket(AF_INET, (udp ? SOCK_DGRAM : SOCK_STREAM) | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+		(!udp && listen(fd, SERVER_MAX_CLIENTS) < 0) ||
+		hotplug_watch_fd(hp, fd, EPOLLIN, udp ? udp_ready : accept_ready, srv) < 0) {
+		int err = errno;
+		close(fd);
+		errno = err;
+		return -1;
+	}
+
+	if (udp)
+		srv->udp_fd = fd;
+	else
+		srv->listen_fd = fd;
+
+	fprintf(info, "Serving frames on %s port %d.\n", udp ? "UDP" : "TCP", port);
+	fflush(info);
+	return 0;
+}
+
+void server_send(struct server *srv, const void *frame, size_t len)
+{
+	const uint64_t now = monotonic_us();
+	int i;
+
+	for (i = 0; i < SERVER_MAX_CLIENTS; i++) {
+		struct server_client *c = &srv->clients[i];
+
+		if (c->fd >= 0) {
+			enqueue(c, frame, len);
+			/* Write straight away unless the socket is already backed up */
+			if (!c->writing)
+				flush_client(srv, c);
+		}
+	}
+
+	if (srv->udp_fd >= 0) {
+		for (i = 0; i < SERVER_MAX_CLIENTS; i++) {
+			struct server_peer *p = &srv->peers[i];
+
+			if (p->last_seen_us == 0)
+				continue;
+			if (now - p->last_seen_us > SERVER_UDP_EXPIRY_US) {
+				p->last_seen_us = 0;
+				continue;
+			}
+			/* A full socket buffer just loses this frame, the next one
+			   carries the whole state anyway */
+			sendto(srv->udp_fd, frame, len, MSG_DONTWAIT | MSG_NOSIGNAL,
+				(const struct sockaddr *)&p->addr, sizeof(p->addr));
+		}
+	}
+}
+
+void server_close(struct server *srv)
+{
+	int i;
+
+	for (i = 0; i < SERVER_MAX_CLIENTS; i++) {
+		if (srv->clients[i].fd >= 0)
+			drop_client(srv, &srv->clients[i]);
+	}
+	if (srv->listen_fd >= 0) {
+		hotplug_unwatch_fd(srv->hp, srv->listen_fd);
+		close(srv->listen_fd);
+	}
+	if (srv->udp_fd >= 0) {
+		hotplug_unwatch_fd(srv->hp, srv->udp_fd);
+		close(srv->udp_fd);
+	}
+}
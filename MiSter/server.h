@@ -0,0 +1,83 @@
+/*
+ * server.h
+ *
+ * Copyright (c) 2020 RetroSpy Technologies
+ */
+
+ /*
+  * This program is free software; you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation; either version 2 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program; if not, write to the Free Software
+  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  * 02110-1301 USA.
+  */
+
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <netinet/in.h>
+
+#include "hotplug.h"
+
+#define SERVER_MAX_CLIENTS 8
+
+/* Per client TCP queue. When a viewer falls behind the oldest frames are
+   dropped, so it always catches up to the current state. */
+#define SERVER_QUEUE_BYTES 16384	/* Power of two */
+#define SERVER_QUEUE_FRAMES 64
+
+/* UDP viewers subscribe by sending any datagram to the port, and have to
+   repeat it at least this often to keep receiving frames. */
+#define SERVER_UDP_EXPIRY_US 10000000
+
+struct server;
+
+struct server_client {
+	struct server *srv;
+	int fd;				/* -1 when the entry is free */
+	uint8_t *ring;
+	size_t head;			/* Free running byte offsets */
+	size_t tail;
+	uint16_t lengths[SERVER_QUEUE_FRAMES];
+	unsigned int first;		/* Oldest queued frame */
+	unsigned int count;
+	size_t sent;			/* Bytes of the oldest frame already sent */
+	unsigned long dropped;
+	int writing;			/* EPOLLOUT is armed */
+};
+
+struct server_peer {
+	struct sockaddr_in addr;
+	uint64_t last_seen_us;		/* 0 when the entry is free */
+};
+
+struct server {
+	struct hotplug *hp;
+	FILE *info;
+	int listen_fd;
+	int udp_fd;
+	struct server_client clients[SERVER_MAX_CLIENTS];
+	struct server_peer peers[SERVER_MAX_CLIENTS];
+};
+
+/* Listens for viewers on port, over TCP or UDP, with the sockets handled
+   in the hotplug loop. */
+int server_open(struct server *srv, struct hotplug *hp, FILE *info, int port, int udp);
+
+/* Queues one encoded frame for every viewer. Never blocks. */
+void server_send(struct server *srv, const void *frame, size_t len);
+
+void server_close(struct server *srv);
+
+#endif
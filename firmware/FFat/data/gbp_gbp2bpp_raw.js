@@ -42,7 +42,17 @@ function getTextFromFile(fileName, callBack) {
 
 function refresh()
 {
-    getTextFromFile("images.dat", function (text) {
+    // Each print is stored in its own file, listed in the index
+    getTextFromFile("prints/index.txt", function (index) {
+        var text = "";
+        index.split(/\r?\n/).forEach(function (line) {
+            var id = line.split(",")[0];
+            if (id !== "") {
+                getTextFromFile("prints/" + ("000" + id).slice(-4) + ".txt", function (print) {
+                    text += print;
+                });
+            }
+        });
         document.getElementById("data_text").value = text;
     });
 
@@ -0,0 +1,13 @@
+#!/bin/bash
+
+# Precompresses the scripts served by the GBP emulator.  The web server sends
+# the .gz in place of the plain file, so rerun this after editing a script and
+# upload the data folder again.
+
+set -e
+
+cd "$(dirname "$0")/data"
+
+for f in gbp_gbp2bpp_raw.js rawFunctions.js; do
+  gzip -9 -n -c "$f" > "$f.gz"
+done
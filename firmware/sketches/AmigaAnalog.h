@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class AmigaAnalogSpy : public ControllerSpy {
+class AmigaAnalogSpy final : public ControllerSpy {
 public:
 	void setup(bool isSecondArduino);
 	void loop();
@@ -25,6 +25,7 @@
 // THE SOFTWARE.
 
 #include "AmigaCd32.h"
+#include "OutputGovernor.h"
 
 #if defined(__arm__) && defined(CORE_TEENSY) && defined(ARDUINO_TEENSY35) || (defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO))
 
@@ -76,10 +77,10 @@ void AmigaCd32Spy::loop1()
 	while (sendRequest)
 	{
 	}
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	updateState();
 	sendRequest = true;
-	interrupts();
+	SPY_INTERRUPTS();
 }
 
 void AmigaCd32Spy::loop() 
@@ -95,9 +96,9 @@ void AmigaCd32Spy::loop()
 #ifdef DEBUG
 		debugSerial();
 #else
-		writeSerial();
+		if (outputGovernor.admit(sendData, sizeof(sendData)))
+			writeSerial();
 #endif
-		T_DELAY(5);
 	}
 }
 
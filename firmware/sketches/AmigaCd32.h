@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class AmigaCd32Spy : public ControllerSpy {
+class AmigaCd32Spy final : public ControllerSpy {
 public:
 	void setup();
 	void loop();
@@ -42,7 +42,7 @@ public:
 
 private:
 	bool	  sendRequest = false;
-	byte      rawData[16000];
+	byte      rawData[9];
 	byte	  sendData[9];
 };
 
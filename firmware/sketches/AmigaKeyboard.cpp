@@ -156,6 +156,8 @@ void AmigaKeyboardSpy::loop()
 		Serial.print("\n");
 #endif
 #endif
+		// Never returns to the main loop, so the pass ends here.
+		endSpyPass(true);
 	}
 
 }
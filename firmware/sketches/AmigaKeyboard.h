@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class AmigaKeyboardSpy : public ControllerSpy {
+class AmigaKeyboardSpy final : public ControllerSpy {
 public:
 	void setup();
 	void loop();
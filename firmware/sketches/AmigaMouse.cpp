@@ -142,9 +142,9 @@ void AmigaMouseSpy::setup(byte videoOutputType, uint8_t cableType)
 
 void AmigaMouseSpy::loop()
 {
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	byte data = ~READ_PORTD(0xFF);
-	interrupts();
+	SPY_INTERRUPTS();
 
 	byte xData = (data & 0b00101000);
 	byte yData = (data & 0b00010100);
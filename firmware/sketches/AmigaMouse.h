@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class AmigaMouseSpy : public ControllerSpy {
+class AmigaMouseSpy final : public ControllerSpy {
 public:
 	void setup(byte videoOutputType, uint8_t cableType = CABLE_SMS);
 	void loop();
@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class Atari5200Spy : public ControllerSpy {
+class Atari5200Spy final : public ControllerSpy {
 public:
 	void setup(bool isSecondArduino);
 	void loop();
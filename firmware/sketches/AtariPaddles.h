@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class AtariPaddlesSpy : public ControllerSpy {
+class AtariPaddlesSpy final : public ControllerSpy {
 public:
 	void setup();
 	void loop();
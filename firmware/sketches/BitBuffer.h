@@ -0,0 +1,199 @@
+//
+// BitBuffer.h
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef BitBuffer_h
+#define BitBuffer_h
+
+#include "common.h"
+#include <string.h>
+
+// Reads bit i out of a packed buffer, LSB first.
+static inline bool packedBit(const unsigned char packed[], uint16_t i)
+{
+	return (packed[i >> 3] & (1 << (i & 7))) != 0;
+}
+
+// Pattern strings for BitBuffer::matches, written in bus order ("0100x1"),
+// where 'x' marks a bit that may be either value.  They are folded into
+// constants at compile time.
+constexpr uint32_t bitPattern(const char* s, uint32_t acc = 0)
+{
+	return *s == 0 ? acc : bitPattern(s + 1, (acc << 1) | (*s == '1' ? 1 : 0));
+}
+
+constexpr uint32_t bitPatternMask(const char* s, uint32_t acc = 0)
+{
+	return *s == 0 ? acc : bitPatternMask(s + 1, (acc << 1) | (*s == 'x' ? 0 : 1));
+}
+
+constexpr uint8_t bitPatternLength(const char* s)
+{
+	return *s == 0 ? 0 : 1 + bitPatternLength(s + 1);
+}
+
+// The low count bits of value in the opposite order, for turning a bus order
+// pattern into the buffer's LSB first layout at compile time.
+constexpr uint32_t bitReverse(uint32_t value, uint8_t count, uint32_t acc = 0)
+{
+	return count == 0 ? acc : bitReverse(value >> 1, count - 1, (acc << 1) | (value & 1));
+}
+
+// Shifts by one, two and four, which AVR does in a cycle each on a byte.
+static inline uint8_t reverseByte(uint8_t b)
+{
+	b = (uint8_t)((b >> 4) | (b << 4));
+	b = (uint8_t)(((b & 0xCC) >> 2) | ((b & 0x33) << 2));
+	return (uint8_t)(((b & 0xAA) >> 1) | ((b & 0x55) << 1));
+}
+
+#define BITS_MATCH(buffer, first, pattern) \
+	(buffer).matches<bitPattern(pattern), bitPatternMask(pattern), bitPatternLength(pattern)>(first)
+
+// Captured bus bits, eight to a byte.  Bit i lives in byte i / 8 at
+// position i % 8 (LSB first), which is also the layout ShiftRegisterCapture
+// writes and sendPackedData reads, so the host sees the same one byte per
+// bit stream as before.
+template<uint16_t Bits>
+class BitBuffer {
+public:
+	static const uint16_t bitCount = Bits;
+	static const uint16_t byteCount = (Bits + 7) / 8;
+
+	void clear() { memset(bytes, 0, byteCount); }
+
+	bool get(uint16_t i) const { return packedBit(bytes, i); }
+	void set(uint16_t i) { bytes[i >> 3] |= (1 << (i & 7)); }
+	void reset(uint16_t i) { bytes[i >> 3] &= ~(1 << (i & 7)); }
+	void assign(uint16_t i, bool value)
+	{
+		if (value)
+			set(i);
+		else
+			reset(i);
+	}
+
+	// Whole bytes, for buses that are LSB first and byte aligned (PlayStation,
+	// ADB) where eight bits can be stored or compared at once.
+	unsigned char byteAt(uint8_t index) const { return bytes[index]; }
+	void setByte(uint8_t index, unsigned char value) { bytes[index] = value; }
+
+	// Up to 32 bits starting at bit first, the earliest bit ending up in the
+	// most significant position.  That is the order MSB first buses such as
+	// the Nintendo one-wire protocol transmit in.
+	uint32_t extractMsbFirst(uint16_t first, uint8_t count) const
+	{
+		if (count == 0)
+			return 0;
+		const uint32_t lsbFirst = extractLsbFirst(first, count);
+		const uint32_t reversed = ((uint32_t)reverseByte((uint8_t)lsbFirst) << 24)
+			| ((uint32_t)reverseByte((uint8_t)(lsbFirst >> 8)) << 16)
+			| ((uint32_t)reverseByte((uint8_t)(lsbFirst >> 16)) << 8)
+			| reverseByte((uint8_t)(lsbFirst >> 24));
+		return reversed >> (32 - count);
+	}
+
+	// Up to 32 bits starting at bit first, the earliest bit ending up in the
+	// least significant position.  The bytes the bits span, at most five,
+	// are loaded whole and shifted into place, so a byte aligned field costs
+	// no shifting at all.
+	uint32_t extractLsbFirst(uint16_t first, uint8_t count) const
+	{
+		if (count == 0)
+			return 0;
+		const unsigned char* p = bytes + (first >> 3);
+		const uint8_t shift = first & 7;
+		const uint8_t span = (shift + count + 7) >> 3;
+
+		uint32_t value = 0;
+		for (uint8_t i = span < 4 ? span : 4; i-- > 0; )
+			value = (value << 8) | p[i];
+		value >>= shift;
+		if (span > 4)
+			value |= (uint32_t)p[4] << (32 - shift);
+		if (count < 32)
+			value &= ((uint32_t)1 << count) - 1;
+		return value;
+	}
+
+	// Compares Count bits starting at first against a pattern, see BITS_MATCH.
+	// The pattern is reversed at compile time so the bits are compared as
+	// they lie in the buffer.
+	template<uint32_t Pattern, uint32_t Mask, uint8_t Count>
+	bool matches(uint16_t first) const
+	{
+		static_assert(Count <= 32, "Patterns are limited to 32 bits");
+		constexpr uint32_t pattern = bitReverse(Pattern, Count);
+		constexpr uint32_t mask = bitReverse(Mask, Count);
+		return (extractLsbFirst(first, Count) & mask) == pattern;
+	}
+
+	unsigned char* data() { return bytes; }
+	const unsigned char* data() const { return bytes; }
+
+private:
+	unsigned char bytes[byteCount];
+};
+
+// Sequential writer for the bit banged capture loops.  It overwrites each
+// bit it passes, so the buffer does not need to be cleared between frames,
+// and it costs a handful of cycles per bit which fits comfortably in the
+// time left over after sampling a one-wire bit.
+class BitCursor {
+public:
+	explicit BitCursor(unsigned char* bytes) : ptr(bytes), mask(1) {}
+
+	inline __attribute__((always_inline)) void put(bool bit)
+	{
+		if (bit)
+			*ptr |= mask;
+		else
+			*ptr &= ~mask;
+		mask <<= 1;
+		if (mask == 0)
+		{
+			mask = 1;
+			++ptr;
+		}
+	}
+
+private:
+	unsigned char* ptr;
+	unsigned char mask;
+};
+
+template<uint16_t Bits>
+inline void sendRawData(const BitBuffer<Bits>& buffer, unsigned char first, unsigned char count)
+{
+	sendPackedData(buffer.data(), first, count);
+}
+
+template<uint16_t Bits>
+inline void sendRawDataDebug(const BitBuffer<Bits>& buffer, unsigned char first, unsigned char count)
+{
+	sendPackedDataDebug(buffer.data(), first, count);
+}
+
+#endif
@@ -76,9 +76,9 @@ void BoosterGripSpy::loop() {
 		return;
 	}
 	currentState = 0;
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	updateState();
-	interrupts();
+	SPY_INTERRUPTS();
 #if !defined(DEBUG)
 	writeSerial();
 #else
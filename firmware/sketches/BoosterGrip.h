@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class BoosterGripSpy : public ControllerSpy {
+class BoosterGripSpy final : public ControllerSpy {
 public:
 	void setup(uint8_t cableType);
 	void setup();
@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class CDTVWiredSpy : public ControllerSpy {
+class CDTVWiredSpy final : public ControllerSpy {
 public:
 	void setup();
 	void loop();
@@ -37,6 +37,9 @@ public:
 	void debugSerial();
 	void updateState();
 	
+	// No startup banner in this mode.
+	void printFirmwareInfo() {}
+
 	virtual const char* startupMsg();
 
 private:
@@ -31,7 +31,7 @@
 
 #if defined(TP_IRREMOTE)
 
-class CDTVWirelessSpy : public ControllerSpy {
+class CDTVWirelessSpy final : public ControllerSpy {
 public:
 	
 	CDTVWirelessSpy()
@@ -51,7 +51,7 @@ private:
 
 #else
 
-class CDTVWirelessSpy : public ControllerSpy {
+class CDTVWirelessSpy final : public ControllerSpy {
 public:
 
 	void setup() {}
@@ -40,7 +40,7 @@
 
 #include <SoftwareSerial.h>
 
-class CDiSpy : public ControllerSpy {
+class CDiSpy final : public ControllerSpy {
 public:
 	CDiSpy(int wired_timeout, int wireless_timeout, int wireless_remote_timeout, int recvpin)
 		: vSerial(CDI_RECVSER, CDI_SENDSER, true)
@@ -110,7 +110,7 @@ private:
 };
 #else
 
-class CDiSpy : public ControllerSpy {
+class CDiSpy final : public ControllerSpy {
 public:
 	CDiSpy(int wired_timeout, int wireless_timeout) {}
 
@@ -34,7 +34,7 @@
 #if !defined(RASPBERRYPI_PICO) &&  !defined(ARDUINO_RASPBERRY_PI_PICO)
 #include <SoftwareSerial.h>
 #endif
-class CDiKeyboardSpy : public ControllerSpy {
+class CDiKeyboardSpy final : public ControllerSpy {
 public:
 #if defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 	CDiKeyboardSpy(int recvpin)
@@ -93,7 +93,7 @@ private:
 	int serial2RX;
 };
 #else
-class CDiKeyboardSpy : public ControllerSpy {
+class CDiKeyboardSpy final : public ControllerSpy {
 public:
 	CDiKeyboardSpy(){}
 	void setup() {}
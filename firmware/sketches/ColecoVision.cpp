@@ -79,7 +79,7 @@ static void bitchange_isr1()
 
 static void bitchange_isr2()
 {
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	byte currentEncoderValue = (quadbit[0] == false ? 0x00 : 0x01) | (quadbit[1] == false ? 0x00 : 0x02);
 	byte encoderValue = (!quadbit[0] == false ? 0x00 : 0x01) | (quadbit[1] == false ? 0x00 : 0x02);
 	
@@ -112,10 +112,10 @@ void ColecoVisionSpy::setup()
 	for (int i = 2; i <= 10; ++i)
 		pinMode(i, INPUT_PULLUP);
 	
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	quadbit[0] = (PINB & 0b00000001) != 0;
 	quadbit[1] = (PIND & 0b10000000) != 0;
-	interrupts();
+	SPY_INTERRUPTS();
 	
 	currentState = 0;
 
@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class ColecoVisionSpy : public ControllerSpy {
+class ColecoVisionSpy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
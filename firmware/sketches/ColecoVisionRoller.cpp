@@ -39,17 +39,17 @@ static volatile bool quadbit[2];
 static void pin5bithigh_isr()
 {
 	asm volatile(MICROSECOND_NOPS MICROSECOND_NOPS MICROSECOND_NOPS MICROSECOND_NOPS MICROSECOND_NOPS MICROSECOND_NOPS MICROSECOND_NOPS MICROSECOND_NOPS);
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	rawData[0] = (PIND & 0b01111100);
-	interrupts();
+	SPY_INTERRUPTS();
 }
 
 static void pin8bithigh_isr()
 {
 	asm volatile(MICROSECOND_NOPS MICROSECOND_NOPS MICROSECOND_NOPS MICROSECOND_NOPS MICROSECOND_NOPS MICROSECOND_NOPS  MICROSECOND_NOPS MICROSECOND_NOPS);
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	rawData[1] = (PIND & 0b01111100);
-	interrupts();
+	SPY_INTERRUPTS();
 }
 
 static void bitchange_isr1()
@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class ColecoVisionRollerSpy : public ControllerSpy {
+class ColecoVisionRollerSpy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
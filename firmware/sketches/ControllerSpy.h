@@ -28,6 +28,7 @@
 #define ControllerSpy_h
 
 #include "common.h"
+#include "SpyStats.h"
 #include <string.h>
 
 class ControllerSpy {
@@ -59,6 +60,12 @@ public:
 	virtual void setup1() {}
 	virtual void loop() = 0;
 	virtual void loop1() {}
+	// True when loop1() sends frames from the Pico's second core, which is
+	// then also the core that answers host commands.
+	virtual bool sendsFromLoop1() { return false; }
+	// True when the spy reads its own commands from Serial, so the shared
+	// host command parser must leave the port alone.
+	virtual bool readsSerial() { return false; }
 	virtual void writeSerial() = 0;
 	virtual void debugSerial() = 0;
 	virtual void updateState() = 0;
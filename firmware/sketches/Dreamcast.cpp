@@ -330,51 +330,56 @@ FASTRUN void DreamcastSpy::updateState() {
 	
 	//start_state:
 state1:
-	interrupts();
+	SPY_INTERRUPTS();
 	byteCount = 0;
 	DETECT_FALLING_EDGE
 		if (prevPin != 0x3 || rawData[byteCount] != 0x2)   // Starts with both pins High and pin 1 drops
-			goto state1;
+			goto syncFailed;
 	++byteCount;
 
 	//state2:
 	DETECT_FALLING_EDGE
 		if (prevPin != 0x2 || rawData[byteCount] != 0x0)  // Pin 5 now drops, pin 1 stays low
-			goto state1;
+			goto syncFailed;
 	++byteCount;
 
 state3:
 
 	DETECT_FALLING_EDGE
 		if (prevPin != 0x2 || rawData[byteCount] != 0x0)  // Pin 5 drops 3 more times, pin 1 says low
-			goto state1;
+			goto syncFailed;
 		else if (++byteCount != 5)
 			goto state3;
 
 	//state4:
 	DETECT_FALLING_EDGE
 		if (rawData[byteCount] != 0x01 || prevPin != 0x3) // Pin 5 drops 1 more times, this time Pin 1 is high
-			goto state1;
+			goto syncFailed;
 	++byteCount;
 
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 state5:                             // Phase 1
 	DETECT_FALLING_EDGE
 		if (prevPin == 0x3 && rawData[byteCount] == 0x1)
 			goto state7;
 		else if (prevPin == 0x02 || prevPin == 0x0)
-			goto state1;
+			goto syncFailed;
 	++byteCount;
 
 	//state6:                           // Phase 2
 	DETECT_FALLING_EDGE
 		if (prevPin == 0x01 || prevPin == 0x0)
-			goto state1;
+			goto syncFailed;
 	++byteCount;
 	goto state5;
 
+	// Any edge that does not start a packet, or a start sequence that breaks off.
+syncFailed:
+	spyStats.syncFailure();
+	goto state1;
+
 state7:
-	interrupts();
+	SPY_INTERRUPTS();
 }
 #elif defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 
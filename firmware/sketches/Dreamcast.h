@@ -29,12 +29,13 @@
 
 #include "ControllerSpy.h"
 
-class DreamcastSpy : public ControllerSpy {
+class DreamcastSpy final : public ControllerSpy {
 public:
 	void setup();
 	FASTRUN void loop();
 #if defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 	FASTRUN void loop1();
+	bool sendsFromLoop1() { return true; }
 #endif
 	FASTRUN void writeSerial();
 	FASTRUN void debugSerial();
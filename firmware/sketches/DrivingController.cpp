@@ -101,10 +101,10 @@ void DrivingControllerSpy::setup() {
 
 void DrivingControllerSpy::loop() {
 
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	byte rawData = 0;
 	rawData |= (READ_PORTD(0xFF) >> 2);
-	interrupts();
+	SPY_INTERRUPTS();
 
 	byte bitmask = cableType == CABLE_SMS ?  0b00100000 : 0b00010000;
 	
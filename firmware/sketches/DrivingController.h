@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class DrivingControllerSpy : public ControllerSpy {
+class DrivingControllerSpy final : public ControllerSpy {
 public:
 	void setup(uint8_t cableType);
 	void loop();
@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class FMTownsSpy : public ControllerSpy {
+class FMTownsSpy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class FMTownsKeyboardAndMouseSpy : public ControllerSpy {
+class FMTownsKeyboardAndMouseSpy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
@@ -25,19 +25,23 @@
 // THE SOFTWARE.
 
 #include "GBA.h"
+#include "OutputGovernor.h"
+#include "ShiftRegisterCapture.h"
 
 #if defined(ARDUINO_TEENSY35) || defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_NANO) || defined(ARDUINO_AVR_NANO_EVERY) || defined(ARDUINO_AVR_LARDU_328E) || defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 
+typedef ShiftRegisterCapture<FallingEdge<SNES_CLOCK>, true, SNES_BITCOUNT, SNES_DATA> GBACapture;
+
 void GBASpy::loop() {
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	updateState();
-	interrupts();
+	SPY_INTERRUPTS();
 #if !defined(DEBUG)
-	writeSerial();
+	if (outputGovernor.admit(rawData.data(), rawData.byteCount))
+		writeSerial();
 #else
 	debugSerial();
 #endif
-	T_DELAY(5);
 }
 
 void GBASpy::writeSerial() {
@@ -50,11 +54,10 @@ void GBASpy::debugSerial() {
 
 void GBASpy::updateState() {
 
-	unsigned char position = 0;
-	unsigned char bits = 0;
-
 	bytesToReturn = SNES_BITCOUNT;
 
+	GBACapture::clear(rawData.data());
+
 	WAIT_FALLING_EDGE(SNES_LATCH);
 #if defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 	unsigned long start = micros();
@@ -62,11 +65,9 @@ void GBASpy::updateState() {
 #else
 	asm volatile(MICROSECOND_NOPS);
 #endif
-	rawData[position++] = !PIN_READ(SNES_DATA);
-	do {
-		WAIT_FALLING_EDGE(SNES_CLOCK);
-		rawData[position++] = !PIN_READ(SNES_DATA);
-	} while (++bits < SNES_BITCOUNT - 1);
+	// The first bit is already on the data line when the latch drops.
+	GBACapture::sample<0>(rawData.data());
+	GBACapture::clockIn<1, SNES_BITCOUNT - 1>(rawData.data());
 }
 
 const char* GBASpy::startupMsg()
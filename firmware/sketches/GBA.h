@@ -28,8 +28,9 @@
 #define GBASpy_h
 
 #include "ControllerSpy.h"
+#include "BitBuffer.h"
 
-class GBASpy : public ControllerSpy {
+class GBASpy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
@@ -39,7 +40,7 @@ public:
 	virtual const char* startupMsg();
 
 private:
-	unsigned char rawData[SNES_BITCOUNT];
+	BitBuffer<SNES_BITCOUNT> rawData;
 	unsigned char bytesToReturn = SNES_BITCOUNT;
 };
 
@@ -25,12 +25,15 @@
 // THE SOFTWARE.
 
 #include "GC.h"
+#include "OutputGovernor.h"
+
+// The Game Boy Player polls much faster than the display can keep up with,
+// repeats of its frames are held to this rate whatever the governor is set to.
+#define GC_GBP_MAX_RATE 60
 
 #if (defined(__arm__) && defined(CORE_TEENSY) && (defined(ARDUINO_TEENSY35) || defined(ARDUINO_TEENSY40) || defined(ARDUINO_TEENSY41))) || (defined(TP_ELAPSEDMILLIS) && (defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)))
 #include <elapsedMillis.h>
 
-static int show = 0;
-
 static u_int8_t dummyStickData[] = {
 	ONE,
 	ZERO,
@@ -89,17 +92,26 @@ void GCSpy::loop1()
 {
 	if (sendRequest)
 	{
-		memcpy(sendData, rawData, 34 + GC_PREFIX + GC_BITCOUNT);
+		sendData = rawData;
 		sendHeaderVal = headerVal;
 		sendRequest = false;
 	
 #if !defined(DEBUG)
 		if (sendHeaderVal == 0x40)
-			sendRawData(sendData, GC_PREFIX, (sendData[14] | sendData[15]) == 0 ? GC_BITCOUNT - 8 : GC_BITCOUNT);
-		else if (sendHeaderVal == 0x14 && ++show % 2 == 0)  // Gameboy Player polls too damn many times, slows down display.
-			writeSerial(); // This doesn't seem to negatively affect other games.
-		else if(sendHeaderVal == 0x54)
-			writeKeyboard();
+		{
+			if (outputGovernor.admit(sendData.data(), sendData.byteCount, sendData.extractMsbFirst(GC_PREFIX, 16)))
+				sendRawData(sendData, GC_PREFIX, !sendData.get(14) && !sendData.get(15) ? GC_BITCOUNT - 8 : GC_BITCOUNT);
+		}
+		else if (sendHeaderVal == 0x14)
+		{
+			if (outputGovernor.admitAtMost(sendData.data(), sendData.byteCount, GC_GBP_MAX_RATE))
+				writeSerial();
+		}
+		else if (sendHeaderVal == 0x54)
+		{
+			if (outputGovernor.admit(sendData.data(), sendData.byteCount))
+				writeKeyboard();
+		}
 #else
 		if (sendHeaderVal == 0x54)
 			debugKeyboard();
@@ -113,18 +125,19 @@ void GCSpy::loop1()
 
 void GCSpy::loop() 
 {
-	unsigned char *rawDataPtr = rawData;
+	BitCursor cursor(rawData.data());
+	bool bit;
 	elapsedMicros betweenLowSignal = 0;
 	int headerBits = 8;
 
 findcmdinit:
-	interrupts();
+	SPY_INTERRUPTS();
 
 	while (sendRequest)
 	{
 	}
 	headerVal = 0;
-	rawDataPtr = rawData;
+	cursor = BitCursor(rawData.data());
 	
 	// Wait for the line to go high then low.
 	WAIT_FALLING_EDGE(GC_PIN);
@@ -138,7 +151,7 @@ findcmdinit:
 		headerBits = 7;
 		betweenLowSignal = 0;
 		
-		noInterrupts();
+		SPY_NO_INTERRUPTS();
 		// Wait ~2us between line reads
 #if defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 		unsigned long start = micros();
@@ -147,10 +160,10 @@ findcmdinit:
 		asm volatile(MICROSECOND_NOPS MICROSECOND_NOPS);
 #endif
 			
-		// Read a bit from the line and store as a byte in "rawData"
-		*rawDataPtr = PIN_READ(GC_PIN);
-		headerVal = (*rawDataPtr != 0 ? 0x80 : 0x00);
-		++rawDataPtr;
+		// Read a bit from the line and store it in "rawData"
+		bit = PIN_READ(GC_PIN) != 0;
+		cursor.put(bit);
+		headerVal = (bit ? 0x80 : 0x00);
 
 		goto readCmd;
 	}
@@ -170,12 +183,12 @@ readCmd:
 	asm volatile(MICROSECOND_NOPS MICROSECOND_NOPS);
 #endif
 
-	// Read a bit from the line and store as a byte in "rawData"
-	*rawDataPtr = PIN_READ(GC_PIN);
+	// Read a bit from the line and store it in "rawData"
+	bit = PIN_READ(GC_PIN) != 0;
+	cursor.put(bit);
 	
-	headerVal |= *rawDataPtr != 0 ? (1 << (headerBits - 1)) : 0;
+	headerVal |= bit ? (1 << (headerBits - 1)) : 0;
 
-	++rawDataPtr;
 	if (--headerBits == 0)
 	{
 		if (headerVal == 0x40)
@@ -198,7 +211,8 @@ readCmd:
 #if defined(DEBUG)
 			//Serial.println(headerVal);
 #endif
-			interrupts();
+			spyStats.syncFailure();
+			SPY_INTERRUPTS();
 			betweenLowSignal = 0;
 			goto findcmdinit;
 		}
@@ -218,10 +232,9 @@ readData:
 	asm volatile(MICROSECOND_NOPS MICROSECOND_NOPS);
 #endif
 
-	// Read a bit from the line and store as a byte in "rawData"
-	*rawDataPtr = PIN_READ(GC_PIN);
+	// Read a bit from the line and store it in "rawData"
+	cursor.put(PIN_READ(GC_PIN) != 0);
 	
-	rawDataPtr++;
 	
 	if (--readBits == 0)
 	{
@@ -231,7 +244,7 @@ readData:
 	goto readData;
 	
 printData:
-	interrupts();
+	SPY_INTERRUPTS();
 	sendRequest = true;
 
 #if !defined(RASPBERRYPI_PICO) && !defined(ARDUINO_RASPBERRY_PI_PICO)
@@ -250,19 +263,19 @@ void GCSpy::writeSerial() {
 	Serial.write(ZERO);
 	Serial.write(ZERO);
 	Serial.write(ZERO);
-	Serial.write(sendData[21] ? ONE : ZERO);
+	Serial.write(sendData.get(21) ? ONE : ZERO);
 	Serial.write(ZERO);
 	Serial.write(ZERO);
-	Serial.write(sendData[23] ? ONE : ZERO);
-	Serial.write(sendData[24] ? ONE : ZERO);
+	Serial.write(sendData.get(23) ? ONE : ZERO);
+	Serial.write(sendData.get(24) ? ONE : ZERO);
 	Serial.write(ZERO);
-	Serial.write(sendData[31] ? ONE : ZERO);
-	Serial.write(sendData[32] ? ONE : ZERO);
-	Serial.write(sendData[22] ? ONE : ZERO);
-	Serial.write(sendData[18] ? ONE : ZERO);
-	Serial.write(sendData[17] ? ONE : ZERO);
-	Serial.write(sendData[20] ? ONE : ZERO);
-	Serial.write(sendData[19] ? ONE : ZERO);
+	Serial.write(sendData.get(31) ? ONE : ZERO);
+	Serial.write(sendData.get(32) ? ONE : ZERO);
+	Serial.write(sendData.get(22) ? ONE : ZERO);
+	Serial.write(sendData.get(18) ? ONE : ZERO);
+	Serial.write(sendData.get(17) ? ONE : ZERO);
+	Serial.write(sendData.get(20) ? ONE : ZERO);
+	Serial.write(sendData.get(19) ? ONE : ZERO);
 	Serial.write(dummyStickData, 49);
 }
 
@@ -270,19 +283,19 @@ void GCSpy::debugSerial() {
 	Serial.print("0");
 	Serial.print("0");
 	Serial.print("0");
-	Serial.print(sendData[21] ? "t" : "0");
+	Serial.print(sendData.get(21) ? "t" : "0");
 	Serial.print("0");
 	Serial.print("0");
-	Serial.print(sendData[23] ? "b" : "0");
-	Serial.print(sendData[24] ? "a" : "0");
+	Serial.print(sendData.get(23) ? "b" : "0");
+	Serial.print(sendData.get(24) ? "a" : "0");
 	Serial.print("0");
-	Serial.print(sendData[31] ? "L" : "0");
-	Serial.print(sendData[32] ? "R" : "0");
-	Serial.print(sendData[22] ? "s" : "0");
-	Serial.print(sendData[18] ? "u" : "0");
-	Serial.print(sendData[17] ? "d" : "0");
-	Serial.print(sendData[20] ? "l" : "0");
-	Serial.print(sendData[19] ? "r" : "0");
+	Serial.print(sendData.get(31) ? "L" : "0");
+	Serial.print(sendData.get(32) ? "R" : "0");
+	Serial.print(sendData.get(22) ? "s" : "0");
+	Serial.print(sendData.get(18) ? "u" : "0");
+	Serial.print(sendData.get(17) ? "d" : "0");
+	Serial.print(sendData.get(20) ? "l" : "0");
+	Serial.print(sendData.get(19) ? "r" : "0");
 	Serial.print(128);
 	Serial.print(128);
 	Serial.print(128);
@@ -298,14 +311,7 @@ void GCSpy::debugKeyboard()
 	byte vals[3];
 	for (int j = 0; j < 3; ++j)
 	{
-		vals[j] = 0;
-		for (int i = 0; i < 8; ++i)
-		{
-			if (sendData[GC_PREFIX + i + 32 + (j * 8)] != 0)
-			{
-				vals[j] |= (byte)(1 << (7 - i));
-			}
-		}
+		vals[j] = (byte)sendData.extractMsbFirst(GC_PREFIX + 32 + (j * 8), 8);
 	}
 	Serial.print("|");
 	Serial.print(vals[0], HEX);
@@ -320,14 +326,7 @@ void GCSpy::writeKeyboard()
 	byte vals[3];
 	for (int j = 0; j < 3; ++j)
 	{
-		vals[j] = 0;
-		for (int i = 0; i < 8; ++i)
-		{
-			if (sendData[GC_PREFIX + i + 32 + (j * 8)] != 0)
-			{
-				vals[j] |= (byte)(1 << (7 - i));
-			}
-		}
+		vals[j] = (byte)sendData.extractMsbFirst(GC_PREFIX + 32 + (j * 8), 8);
 		if (vals[j] == 10)
 			vals[j] = 11;
 	}
@@ -344,15 +343,16 @@ bool isLuigisMansion = false;
 
 void GCSpy::loop() {
 	if (!seenGC2N64) {
-		noInterrupts();
+		SPY_NO_INTERRUPTS();
 		readBits = GC_PREFIX + GC_BITCOUNT;
 		updateState();
-		interrupts();
+		SPY_INTERRUPTS();
 
 		if (checkPrefixGC() || checkPrefixLuigisMansion() || checkPrefixSNES2GC())
 		{
 #if !defined(DEBUG)
-			sendRawData(rawData, GC_PREFIX, isLuigisMansion ? GC_BITCOUNT - 8 : GC_BITCOUNT);
+			if (outputGovernor.admit(rawData.data(), rawData.byteCount, rawData.extractMsbFirst(GC_PREFIX, 16)))
+				sendRawData(rawData, GC_PREFIX, isLuigisMansion ? GC_BITCOUNT - 8 : GC_BITCOUNT);
 #else
 			sendRawDataDebug(rawData, 0, GC_BITCOUNT + GC_PREFIX);
 #endif
@@ -360,7 +360,8 @@ void GCSpy::loop() {
 		else if (checkPrefixKeyboard())
 		{
 #if !defined(DEBUG)
-			writeKeyboard();
+			if (outputGovernor.admit(rawData.data(), rawData.byteCount))
+				writeKeyboard();
 #else
 			//sendRawData(rawData, GC_PREFIX, GC_BITCOUNT);
 			debugKeyboard();
@@ -368,7 +369,8 @@ void GCSpy::loop() {
 		}
 		else if (checkPrefixGBA()) {
 #if !defined(DEBUG)
-			writeSerial();
+			if (outputGovernor.admitAtMost(rawData.data(), rawData.byteCount, GC_GBP_MAX_RATE))
+				writeSerial();
 #else
 			debugSerial();
 #endif
@@ -378,37 +380,40 @@ void GCSpy::loop() {
 		}
 		else
 		{
+			spyStats.syncFailure();
 #if defined(DEBUG)
 			sendRawDataDebug(rawData, 0, GC_BITCOUNT + GC_PREFIX);
 #endif
 		}
 	}
 	else {
-		noInterrupts();
+		SPY_NO_INTERRUPTS();
 		readBits = 34 + GC_PREFIX + GC_BITCOUNT;
 		updateState();
-		interrupts();
+		SPY_INTERRUPTS();
 		if (checkBothGCPrefixOnRaphnet()) {
-			sendRawData(rawData, 34 + GC_PREFIX, GC_BITCOUNT);
+			if (outputGovernor.admit(rawData.data(), rawData.byteCount, rawData.extractMsbFirst(34 + GC_PREFIX, 16)))
+				sendRawData(rawData, 34 + GC_PREFIX, GC_BITCOUNT);
 		}
 		else if (checkPrefixGC()) {
-			sendRawData(rawData, GC_PREFIX, GC_BITCOUNT);
+			if (outputGovernor.admit(rawData.data(), rawData.byteCount, rawData.extractMsbFirst(GC_PREFIX, 16)))
+				sendRawData(rawData, GC_PREFIX, GC_BITCOUNT);
 		}
 		else if (checkPrefixGBA()) {
 #if !defined(DEBUG)
-			writeSerial();
+			if (outputGovernor.admitAtMost(rawData.data(), rawData.byteCount, GC_GBP_MAX_RATE))
+				writeSerial();
 #else
 			debugSerial();
 #endif
 		}
 	}
-	T_DELAY(5);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Performs a read cycle from one of Nintendo's one-wire interface based controllers.
 void GCSpy::updateState() {
-	unsigned char *rawDataPtr = rawData;
+	BitCursor cursor(rawData.data());
 
 read_loop:
 
@@ -418,9 +423,8 @@ read_loop:
 	// Wait ~2us between line reads
 	asm volatile(MICROSECOND_NOPS MICROSECOND_NOPS);
 
-	// Read a bit from the line and store as a byte in "rawData"
-	*rawDataPtr = PIN_READ(GC_PIN);
-	++rawDataPtr;
+	// Read a bit from the line and store it in "rawData"
+	cursor.put(PIN_READ(GC_PIN) != 0);
 	if (--readBits == 0) return;
 
 	goto read_loop;
@@ -431,19 +435,19 @@ void GCSpy::writeSerial() {
 	Serial.write(ZERO);
 	Serial.write(ZERO);
 	Serial.write(ZERO);
-	Serial.write(rawData[21] ? ONE : ZERO);
+	Serial.write(rawData.get(21) ? ONE : ZERO);
 	Serial.write(ZERO);
 	Serial.write(ZERO);
-	Serial.write(rawData[23] ? ONE : ZERO);
-	Serial.write(rawData[24] ? ONE : ZERO);
+	Serial.write(rawData.get(23) ? ONE : ZERO);
+	Serial.write(rawData.get(24) ? ONE : ZERO);
 	Serial.write(ZERO);
-	Serial.write(rawData[31] ? ONE : ZERO);
-	Serial.write(rawData[32] ? ONE : ZERO);
-	Serial.write(rawData[22] ? ONE : ZERO);
-	Serial.write(rawData[18] ? ONE : ZERO);
-	Serial.write(rawData[17] ? ONE : ZERO);
-	Serial.write(rawData[20] ? ONE : ZERO);
-	Serial.write(rawData[19] ? ONE : ZERO);
+	Serial.write(rawData.get(31) ? ONE : ZERO);
+	Serial.write(rawData.get(32) ? ONE : ZERO);
+	Serial.write(rawData.get(22) ? ONE : ZERO);
+	Serial.write(rawData.get(18) ? ONE : ZERO);
+	Serial.write(rawData.get(17) ? ONE : ZERO);
+	Serial.write(rawData.get(20) ? ONE : ZERO);
+	Serial.write(rawData.get(19) ? ONE : ZERO);
 	Serial.write(ONE);
 	for (int i = 0; i < 7; ++i)
 		Serial.write(ZERO);
@@ -467,19 +471,19 @@ void GCSpy::debugSerial() {
 	Serial.print("0");
 	Serial.print("0");
 	Serial.print("0");
-	Serial.print(rawData[21] ? "t" : "0");
+	Serial.print(rawData.get(21) ? "t" : "0");
 	Serial.print("0");
 	Serial.print("0");
-	Serial.print(rawData[23] ? "b" : "0");
-	Serial.print(rawData[24] ? "a" : "0");
+	Serial.print(rawData.get(23) ? "b" : "0");
+	Serial.print(rawData.get(24) ? "a" : "0");
 	Serial.print("0");
-	Serial.print(rawData[31] ? "L" : "0");
-	Serial.print(rawData[32] ? "R" : "0");
-	Serial.print(rawData[22] ? "s" : "0");
-	Serial.print(rawData[18] ? "u" : "0");
-	Serial.print(rawData[17] ? "d" : "0");
-	Serial.print(rawData[20] ? "l" : "0");
-	Serial.print(rawData[19] ? "r" : "0");
+	Serial.print(rawData.get(31) ? "L" : "0");
+	Serial.print(rawData.get(32) ? "R" : "0");
+	Serial.print(rawData.get(22) ? "s" : "0");
+	Serial.print(rawData.get(18) ? "u" : "0");
+	Serial.print(rawData.get(17) ? "d" : "0");
+	Serial.print(rawData.get(20) ? "l" : "0");
+	Serial.print(rawData.get(19) ? "r" : "0");
 	Serial.print(128);
 	Serial.print(128);
 	Serial.print(128);
@@ -491,112 +495,27 @@ void GCSpy::debugSerial() {
 
 inline bool GCSpy::checkPrefixGBA()
 {
-	if (rawData[0] != 0) return false; // 0
-	if (rawData[1] != 0) return false; // 0
-	if (rawData[2] != 0) return false; // 0
-	if (rawData[3] == 0) return false; // 1
-	if (rawData[4] != 0) return false; // 0
-	if (rawData[5] == 0) return false; // 1
-	if (rawData[6] != 0) return false; // 0
-	if (rawData[7] != 0) return false; // 0
-	if (rawData[8] == 0) return false; // 1
-	if (rawData[9] != 0) return false; // 0
-	if (rawData[10] != 0) return false; // 0
-	if (rawData[11] == 0) return false; // 1
+	if (!BITS_MATCH(rawData, 0, "000101001001")) return false;
 	seenGC2N64 = false;
 	return true;
 }
 
 inline bool GCSpy::checkPrefixSNES2GC()
 {
-	if (rawData[0] != 0) return false; // 0
-	if (rawData[1] == 0) return false;  // 1
-	if (rawData[2] != 0) return false;  // 0
-	if (rawData[3] != 0) return false;  // 0
-	if (rawData[4] != 0) return false;  // 0
-	if (rawData[5] != 0) return false;  // 0
-	if (rawData[6] != 0) return false;  // 0
-	if (rawData[7] != 0) return false;  // 0
-	if (rawData[8] != 0) return false;  // 0
-	if (rawData[9] != 0) return false;  // 0
-	if (rawData[10] != 0) return false;  // 0
-	if (rawData[11] != 0) return false;  // 0
-	if (rawData[12] != 0) return false;  // 0
-	if (rawData[13] != 0) return false;  // 0
-	if (rawData[14] == 0) return false;  // 1
-	if (rawData[15] == 0) return false;  // 1
-	if (rawData[16] != 0) return false;  // 0
-	if (rawData[17] != 0) return false;  // 0
-	if (rawData[18] != 0) return false;  // 0
-	if (rawData[19] != 0) return false;  // 0
-	if (rawData[20] != 0) return false;  // 0
-	if (rawData[21] != 0) return false;  // 0
-	if (rawData[22] != 0) return false; // 0
-	if (rawData[23] != 0) return false;  // 0
-	
-	return true;
+	return BITS_MATCH(rawData, 0, "010000000000001100000000");
 }
 
 inline bool GCSpy::checkPrefixKeyboard()
 {
-	if (rawData[0] != 0) return false; // 0
-	if(rawData[1] == 0) return false;  // 1
-	if(rawData[2] != 0) return false;  // 0
-	if(rawData[3] == 0) return false;  // 1
-	if(rawData[4] != 0) return false;  // 0
-	if(rawData[5] == 0) return false;  // 1
-	if(rawData[6] != 0) return false;  // 0
-	if(rawData[7] != 0) return false;  // 0
-	if(rawData[8] != 0) return false;  // 0
-	if(rawData[9] != 0) return false;  // 0
-	if(rawData[10] != 0) return false;  // 0
-	if(rawData[11] != 0) return false;  // 0
-	if(rawData[12] != 0) return false;  // 0
-	if(rawData[13] != 0) return false;  // 0
-	if(rawData[14] != 0) return false;  // 0
-	if(rawData[15] != 0) return false;  // 0
-	if(rawData[16] != 0) return false;  // 0
-	if(rawData[17] != 0) return false;  // 0
-	if(rawData[18] != 0) return false;  // 0
-	if(rawData[19] != 0) return false;  // 0
-	if(rawData[20] != 0) return false;  // 0
-	if(rawData[21] != 0) return false;  // 0
-	if (rawData[22] != 0) return false; // 0
-	if(rawData[23] != 0) return false;  // 0
-	if(rawData[24] == 0) return false;  // 1
+	if (!BITS_MATCH(rawData, 0, "0101010000000000000000001")) return false;
 	seenGC2N64 = false;
 	return true;
-
 }
 
 inline bool GCSpy::checkPrefixGC()
 {
-	
-	if (rawData[0] != 0) return false; // 0
-	if (rawData[1] == 0) return false; // 1
-	if (rawData[2] != 0) return false; // 0
-	if (rawData[3] != 0) return false; // 0
-	if (rawData[4] != 0) return false; // 0
-	if (rawData[5] != 0) return false; // 0
-	if (rawData[6] != 0) return false; // 0
-	if (rawData[7] != 0) return false; // 0
-	if (rawData[8] != 0) return false; // 0
-	if (rawData[9] != 0) return false; // 0
-	if (rawData[10] != 0) return false; // 0
-	if (rawData[11] != 0) return false; // 0
-	if (rawData[12] != 0) return false; // 0
-	if (rawData[13] != 0) return false; // 0
-	if (rawData[14] == 0) return false; // 1
-	if (rawData[15] == 0) return false; // 1
-	if (rawData[16] != 0) return false; // 0
-	if (rawData[17] != 0) return false; // 0
-	if (rawData[18] != 0) return false; // 0
-	//if (rawData[19] != 0) return false; // 0 or 1
-	if (rawData[20] != 0) return false; // 0
-	if (rawData[21] != 0) return false; // 0
-	//if (rawData[22] != 0) return false; // 0 or 1
-	if (rawData[23] != 0) return false; // 0
-	if (rawData[24] == 0) return false; // 1
+	// Bits 19 and 22 may be either value.
+	if (!BITS_MATCH(rawData, 0, "0100000000000011000x00x01")) return false;
 	seenGC2N64 = false;
 	return true;
 }
@@ -604,31 +523,8 @@ inline bool GCSpy::checkPrefixGC()
 inline bool GCSpy::checkPrefixLuigisMansion()
 {
 	isLuigisMansion = false;
-	if (rawData[0] != 0) return false; // 0
-	if(rawData[1] == 0) return false;  // 1
-	if(rawData[2] != 0) return false;  // 0
-	if(rawData[3] != 0) return false;  // 0
-	if(rawData[4] != 0) return false;  // 0
-	if(rawData[5] != 0) return false;  // 0
-	if(rawData[6] != 0) return false;  // 0
-	if(rawData[7] != 0) return false;  // 0
-	if(rawData[8] != 0) return false;  // 0
-	if(rawData[9] != 0) return false;  // 0
-	if(rawData[10] != 0) return false;  // 0
-	if(rawData[11] != 0) return false;  // 0
-	if(rawData[12] != 0) return false;  // 0
-	if(rawData[13] != 0) return false;  // 0
-	if(rawData[14] != 0) return false;  // 0
-	if(rawData[15] != 0) return false;  // 0
-	if(rawData[16] != 0) return false;  // 0
-	if(rawData[17] != 0) return false;  // 0
-	if(rawData[18] != 0) return false;  // 0
-	if(rawData[19] != 0) return false;  // 0
-	if(rawData[20] != 0) return false;  // 0
-	if(rawData[21] != 0) return false;  // 0
-	//if (rawData[22] != 0) return false; // 0 or 1
-	if(rawData[23] != 0) return false;  // 0
-	if(rawData[24] == 0) return false;  // 1
+	// Bit 22 may be either value.
+	if (!BITS_MATCH(rawData, 0, "0100000000000000000000x01")) return false;
 	seenGC2N64 = false;
 	isLuigisMansion = true;
 	return true;
@@ -636,65 +532,9 @@ inline bool GCSpy::checkPrefixLuigisMansion()
 
 inline bool GCSpy::checkBothGCPrefixOnRaphnet()
 {
-	if (rawData[0] != 0) return false; // 0
-	if (rawData[1] != 0) return false; // 0
-	if (rawData[2] != 0) return false; // 0
-	if (rawData[3] != 0) return false; // 0
-	if (rawData[4] != 0) return false; // 0
-	if (rawData[5] != 0) return false; // 0
-	if (rawData[6] != 0) return false; // 0
-	if (rawData[7] != 0) return false; // 0
-	if (rawData[8] == 0) return false; // 1
-	if (rawData[9] != 0) return false; // 0
-	if (rawData[10] != 0) return false; // 0
-	if (rawData[11] != 0) return false; // 0
-	if (rawData[12] != 0) return false; // 0
-	if (rawData[13] == 0) return false; // 1
-	if (rawData[14] != 0) return false; // 0
-	if (rawData[15] != 0) return false; // 0
-	if (rawData[16] == 0) return false; // 1
-	if (rawData[17] != 0) return false; // 0
-	if (rawData[18] != 0) return false; // 0
-	if (rawData[19] != 0) return false; // 0
-	if (rawData[20] != 0) return false; // 0
-	if (rawData[21] != 0) return false; // 0
-	if (rawData[22] != 0) return false; // 0
-	if (rawData[23] != 0) return false; // 0
-	if (rawData[24] != 0) return false; // 0
-	if (rawData[25] != 0) return false; // 0
-	//if (rawData[26] != 0) return false; // 0 or 1
-	if (rawData[27] == 0) return false; // 1
-	if (rawData[28] != 0) return false; // 0
-	if (rawData[29] != 0) return false; // 0
-	if (rawData[30] != 0) return false; // 0
-	if (rawData[31] == 0) return false; // 1
-	if (rawData[32] == 0) return false; // 1
-	if (rawData[33] != 0) return false; // 0
-	if (rawData[34] != 0) return false; // 0
-	if (rawData[35] == 0) return false; // 1
-	if (rawData[36] != 0) return false; // 0
-	if (rawData[37] != 0) return false; // 0
-	if (rawData[38] != 0) return false; // 0
-	if (rawData[39] != 0) return false; // 0
-	if (rawData[40] != 0) return false; // 0
-	if (rawData[41] != 0) return false; // 0
-	if (rawData[42] != 0) return false; // 0
-	if (rawData[43] != 0) return false; // 0
-	if (rawData[44] != 0) return false; // 0
-	if (rawData[45] != 0) return false; // 0
-	if (rawData[46] != 0) return false; // 0
-	if (rawData[47] != 0) return false; // 0
-	if (rawData[48] == 0) return false; // 1
-	if (rawData[49] == 0) return false; // 1
-	if (rawData[50] != 0) return false; // 0
-	if (rawData[51] != 0) return false; // 0
-	if (rawData[52] != 0) return false; // 0
-	if (rawData[53] != 0) return false; // 0
-	if (rawData[54] != 0) return false; // 0
-	if (rawData[55] != 0) return false; // 0
-	if (rawData[56] != 0) return false; // 0
-	if (rawData[57] != 0) return false; // 0
-	if (rawData[58] == 0) return false; // 1
+	// Bit 26 may be either value.
+	if (!BITS_MATCH(rawData, 0, "00000000100001001000000000x10001")) return false;
+	if (!BITS_MATCH(rawData, 32, "100100000000000011000000001")) return false;
 	seenGC2N64 = true;
 	return true;
 }
@@ -704,14 +544,7 @@ void GCSpy::debugKeyboard()
 	byte vals[3];
 	for (int j = 0; j < 3; ++j)
 	{
-		vals[j] = 0;
-		for (int i = 0; i < 8; ++i)
-		{
-			if (rawData[GC_PREFIX + i + 32 + (j * 8)] != 0)
-			{
-				vals[j] |= (byte)(1 << (7 - i));
-			}
-		}
+		vals[j] = (byte)rawData.extractMsbFirst(GC_PREFIX + 32 + (j * 8), 8);
 	}
 	Serial.print("|");
 	Serial.print(vals[0], HEX);
@@ -726,14 +559,7 @@ void GCSpy::writeKeyboard()
 	byte vals[3];
 	for (int j = 0; j < 3; ++j)
 	{
-		vals[j] = 0;
-		for (int i = 0; i < 8; ++i)
-		{
-			if (rawData[GC_PREFIX + i + 32 + (j * 8)] != 0)
-			{
-				vals[j] |= (byte)(1 << (7 - i));
-			}
-		}
+		vals[j] = (byte)rawData.extractMsbFirst(GC_PREFIX + 32 + (j * 8), 8);
 		if (vals[j] == 10)
 			vals[j] = 11;
 	}
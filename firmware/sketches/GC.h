@@ -28,11 +28,15 @@
 #define GCSpy_h
 
 #include "ControllerSpy.h"
+#include "BitBuffer.h"
 
-class GCSpy : public ControllerSpy {
+class GCSpy final : public ControllerSpy {
 public:
 	void loop();
 	void loop1();
+#if defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
+	bool sendsFromLoop1() { return true; }
+#endif
 	void writeSerial();
 	void debugSerial();
 	void updateState();
@@ -52,10 +56,10 @@ private:
 	void debugKeyboard();
 	void writeKeyboard();
 	
-	unsigned char rawData[34 + GC_PREFIX + GC_BITCOUNT];
+	BitBuffer<34 + GC_PREFIX + GC_BITCOUNT> rawData;
 	unsigned char readBits;
 	
-	unsigned char sendData[34 + GC_PREFIX + GC_BITCOUNT];
+	BitBuffer<34 + GC_PREFIX + GC_BITCOUNT> sendData;
 	volatile bool sendRequest = false;
 	short sendHeaderVal = 0;
 };
@@ -27,13 +27,16 @@
 
 #include "ControllerSpy.h"
 
-class GameBoyPrinterEmulator : public ControllerSpy {
+class GameBoyPrinterEmulator final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
 	void debugSerial();
 	void updateState();
 	void setup();
+	// The diagnostics console owns Serial input and the capture stream is
+	// binary, so host commands stay out of both.
+	bool readsSerial() { return true; }
 	
 	virtual const char* startupMsg();
 
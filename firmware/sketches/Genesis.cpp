@@ -25,6 +25,7 @@
 // THE SOFTWARE.
 
 #include "Genesis.h"
+#include "OutputGovernor.h"
 
 #if defined(ARDUINO_TEENSY35) || defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_NANO) || defined(ARDUINO_AVR_NANO_EVERY) || defined(ARDUINO_AVR_LARDU_328E) || defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 
@@ -69,18 +70,18 @@ void GenesisSpy::setup() {
 void GenesisSpy::loop() {
 	updateState();
 #if !defined(DEBUG)
-	writeSerial();
+	if (outputGovernor.admit((const unsigned char*)&currentState, sizeof(currentState)))
+		writeSerial();
 #else
 	debugSerial();
 #endif
-	T_DELAY(5);
 	A_DELAY(1);
 }
 
 void GenesisSpy::updateState() {
 	currentState = 0xFFFF;
 
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 
 	do {
 		WORKING_WAIT
@@ -121,7 +122,7 @@ void GenesisSpy::updateState() {
 		currentState &= SHIFT_ZYXM;
 	}
 
-	interrupts();
+	SPY_INTERRUPTS();
 
 	currentState = ~currentState;
 }
@@ -58,7 +58,7 @@
 #define WORKING_WAIT
 #endif
 
-class GenesisSpy : public ControllerSpy {
+class GenesisSpy final : public ControllerSpy {
 public:
 	void setup();
 	void loop();
@@ -25,6 +25,7 @@
 // THE SOFTWARE.
 
 #include "GenesisMouse.h"
+#include "OutputGovernor.h"
 
 #if defined(ARDUINO_TEENSY35) || defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_NANO) || defined(ARDUINO_AVR_NANO_EVERY) || defined(ARDUINO_AVR_LARDU_328E) ||  defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 
@@ -68,18 +69,19 @@ void GenesisMouseSpy::setup() {
 void GenesisMouseSpy::loop() {
 	updateState();
 #if !defined(DEBUG)
-	writeSerial();
+	// Low nibble of the first byte is Start, Middle, Right and Left, the rest
+	// is movement.
+	if (outputGovernor.admit(rawData, sizeof(rawData), rawData[0] & 0x0F))
+		writeSerial();
 #else
 	debugSerial();
 #endif
-
-	T_DELAY(5);
 }
 
 void GenesisMouseSpy::updateState() {
 	unsigned long reads = 0;
 
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 
 	WAIT_FALLING_EDGEB(GENESIS_TH);
 	WAIT_FALLING_EDGE(GENESIS_TL);
@@ -100,7 +102,7 @@ void GenesisMouseSpy::updateState() {
 	if (rawData[2] == 0b00001011)
 		rawData[2] &= 0;
 
-	interrupts();
+	SPY_INTERRUPTS();
 }
 
 void GenesisMouseSpy::writeSerial() {
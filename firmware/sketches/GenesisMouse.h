@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class GenesisMouseSpy : public ControllerSpy {
+class GenesisMouseSpy final : public ControllerSpy {
 public:
 	void setup();
 	void loop();
@@ -36,9 +36,9 @@ const unsigned char IntellivisionSpy::buttonMasks[32] = {
 };
 
 void IntellivisionSpy::loop() {
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	updateState();
-	interrupts();
+	SPY_INTERRUPTS();
 #if !defined(DEBUG)
 	writeSerial();
 #else
@@ -35,7 +35,7 @@
 // if you do want the strange behavior
 #define INT_SANE_BEHAVIOR true
 
-class IntellivisionSpy : public ControllerSpy {
+class IntellivisionSpy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
@@ -29,9 +29,9 @@
 #if !(defined(__arm__) && defined(CORE_TEENSY))
 
 void JaguarSpy::loop() {
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	updateState();
-	interrupts();
+	SPY_INTERRUPTS();
 #if !defined(DEBUG)
 	writeSerial();
 #else
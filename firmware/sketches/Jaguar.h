@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class JaguarSpy : public ControllerSpy {
+class JaguarSpy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
@@ -409,14 +409,14 @@ void KeyboardControllerSpy::setup(byte controllerMode, uint8_t cableType)
 void KeyboardControllerSpy::loop()
 {
 #ifdef DEBUG
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	rawData = 0;
 	rawData |= (READ_PORTD(0xFF) >> 2) | (READ_PORTB(0xFF) << 6);
 	int analog0 = analogRead(6);
 	int analog1 = analogRead(7);
 	int analog2 = analogRead(2);
 	int analog3 = analogRead(3);
-	interrupts();
+	SPY_INTERRUPTS();
 #else
 	if (currentControllerMode == MODE_BIG_BIRD)
 	{
@@ -444,10 +444,10 @@ void KeyboardControllerSpy::loop()
 			digitalPin = 7;
 			analogPin = 1;
 		}
-		noInterrupts();
+		SPY_NO_INTERRUPTS();
 		byte pin6 = PIN_READ(digitalPin);
 		int pin9 = analogRead(analogPin);
-		interrupts();
+		SPY_INTERRUPTS();
 		if ((pin6 & bytemask) == 0)
 			currentState = 6;
 		else if (pin9 < digitalThreshold)
@@ -32,7 +32,7 @@
 
 #include "ControllerSpy.h"
 
-class KeyboardControllerSpy : public ControllerSpy {
+class KeyboardControllerSpy final : public ControllerSpy {
 public:
 	void setup(uint8_t controllerMode, uint8_t cableType = CABLE_SMS);
 	void loop();
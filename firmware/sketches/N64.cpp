@@ -25,6 +25,7 @@
 // THE SOFTWARE.
 
 #include "N64.h"
+#include "OutputGovernor.h"
 
 #if (defined(__arm__) && defined(CORE_TEENSY) && (defined(ARDUINO_TEENSY35) || defined(ARDUINO_TEENSY40) || defined(ARDUINO_TEENSY41))) || (defined(TP_ELAPSEDMILLIS) && (defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)))
 
@@ -34,11 +35,13 @@ void N64Spy::loop1()
 {
 	if (sendRequest)
 	{
-		memcpy(sendData, rawData, 9 + N64_BITCOUNT);
+		sendData = rawData;
 		sendRequest = false;
 	
 #if !defined(DEBUG)
-		writeSerial();
+		// The first 16 bits are the buttons, the rest is the stick.
+		if (outputGovernor.admit(sendData.data(), (9 + N64_BITCOUNT + 7) / 8, sendData.extractMsbFirst(9, 16)))
+			writeSerial();
 #else
 		debugSerial();
 #endif
@@ -48,19 +51,20 @@ void N64Spy::loop1()
 
 void N64Spy::loop() 
 {
-	unsigned char *rawDataPtr = rawData;
+	BitCursor cursor(rawData.data());
+	bool bit;
 	elapsedMicros betweenLowSignal = 0;
 	short headerVal = 0;
 	int headerBits = 8;
 	
 findcmdinit:
-	interrupts();
+	SPY_INTERRUPTS();
 
 	while (sendRequest)
 	{
 	}
 	
-	rawDataPtr = rawData;
+	cursor = BitCursor(rawData.data());
 	
 	// Wait for the line to go high then low.
 	WAIT_FALLING_EDGE(N64_PIN);
@@ -74,7 +78,7 @@ findcmdinit:
 		headerBits = 7;
 		betweenLowSignal = 0;
 		
-		noInterrupts();
+		SPY_NO_INTERRUPTS();
 		// Wait ~2us between line reads
 #if defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 		unsigned long start = micros();
@@ -83,10 +87,10 @@ findcmdinit:
 		asm volatile(MICROSECOND_NOPS MICROSECOND_NOPS);
 #endif
 
-		// Read a bit from the line and store as a byte in "rawData"
-		*rawDataPtr = PIN_READ(N64_PIN);
-		headerVal = (*rawDataPtr != 0 ? 0x80 : 0x00);
-		++rawDataPtr;
+		// Read a bit from the line and store it in "rawData"
+		bit = PIN_READ(N64_PIN) != 0;
+		cursor.put(bit);
+		headerVal = (bit ? 0x80 : 0x00);
 
 		goto readCmd;
 	}
@@ -105,12 +109,12 @@ readCmd:
 #else
 	asm volatile(MICROSECOND_NOPS MICROSECOND_NOPS);
 #endif
-	// Read a bit from the line and store as a byte in "rawData"
-	*rawDataPtr = PIN_READ(N64_PIN);
+	// Read a bit from the line and store it in "rawData"
+	bit = PIN_READ(N64_PIN) != 0;
+	cursor.put(bit);
 	
-	headerVal |= *rawDataPtr != 0 ? (1 << (headerBits - 1)) : 0;
+	headerVal |= bit ? (1 << (headerBits - 1)) : 0;
 
-	++rawDataPtr;
 	if (--headerBits == 0)
 	{
 		if (headerVal == 0x00)
@@ -143,7 +147,8 @@ readCmd:
 #if defined(DEBUG)
 			//Serial.println(headerVal);
 #endif
-			interrupts();
+			spyStats.syncFailure();
+			SPY_INTERRUPTS();
 			betweenLowSignal = 0;
 			goto findcmdinit;
 		}
@@ -163,10 +168,9 @@ readData:
 	asm volatile(MICROSECOND_NOPS MICROSECOND_NOPS);
 #endif
 
-	// Read a bit from the line and store as a byte in "rawData"
-	*rawDataPtr = PIN_READ(N64_PIN);
+	// Read a bit from the line and store it in "rawData"
+	cursor.put(PIN_READ(N64_PIN) != 0);
 	
-	rawDataPtr++;
 	
 	if (--readBits == 0)
 	{
@@ -176,7 +180,7 @@ readData:
 	goto readData;
 	
 printData:
-	interrupts();
+	SPY_INTERRUPTS();
 	if (headerVal == 0x01)
 	{
 		sendRequest = true;
@@ -195,12 +199,7 @@ void N64Spy::updateState() {
 }
 
 void N64Spy::writeSerial() {
-	const unsigned char first = 9;
-
-	for (unsigned char i = first; i < first + N64_BITCOUNT; i++) {
-		Serial.write(sendData[i] ? ONE : ZERO);
-	}
-	Serial.write(SPLIT);
+	sendRawData(sendData, 9, N64_BITCOUNT);
 }
 
 void N64Spy::debugSerial() {
@@ -210,7 +209,7 @@ void N64Spy::debugSerial() {
 	for (unsigned char i = first; i < first + N64_BITCOUNT; i++) {
 		if (j % 8 == 0 && j != 0)
 			Serial.print("|");
-		Serial.print(sendData[i] ? "1" : "0");
+		Serial.print(sendData.get(i) ? "1" : "0");
 		j++;
 	}
 	Serial.println();
@@ -221,12 +220,13 @@ void N64Spy::debugSerial() {
 static bool getControllerInfo = false;
 
 void N64Spy::loop() {
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	updateState();
-	interrupts();
+	SPY_INTERRUPTS();
 	if (checkPrefixN64()) {
 #if !defined(DEBUG)
-	writeSerial();
+		if (outputGovernor.admit(rawData.data(), rawData.byteCount, rawData.extractMsbFirst(getControllerInfo ? 0 : 1, 16)))
+			writeSerial();
 #else
 		debugSerial();
 #endif
@@ -235,13 +235,12 @@ void N64Spy::loop() {
 		// This makes no sense, but its needed after command 0x0 or else you get garbage on the line
 		A_DELAY(2);
 	}
-	T_DELAY(5);
 }
 
 // Verifies that the 9 bits prefixing N64 controller data in 'rawData'
 // are actually indicative of a controller state signal.
 inline bool N64Spy::checkPrefixN64() {
-	return rawData[0] == 0x01;
+	return command == 0x01;
 }
 
 void N64Spy::updateState() {
@@ -250,7 +249,7 @@ void N64Spy::updateState() {
 	getControllerInfo = false;
 	bool ignoreBits = false;
 	
-	unsigned char *rawDataPtr = &rawData[1];
+	BitCursor cursor(rawData.data());
 	byte /*bit7, bit6, bit5, bit4, bit3, */bit2, bit1, bit0;
 	WAIT_FALLING_EDGE(N64_PIN);
 	asm volatile(MICROSECOND_NOPS MICROSECOND_NOPS);
@@ -279,7 +278,7 @@ void N64Spy::updateState() {
 		asm volatile(MICROSECOND_NOPS MICROSECOND_NOPS);
 		// bit0 = PIND & 0b00000100;
 		bits = 25;
-		rawData[0] = 0xFF;
+		command = 0xFF;
 		goto read_loop;
 	}
 	WAIT_FALLING_EDGE(N64_PIN);
@@ -292,7 +291,7 @@ void N64Spy::updateState() {
 		// bit0 = PIND & 0b00000100;
 		ignoreBits = true;
 		bits = 281;
-		rawData[0] = 0x02;
+		command = 0x02;
 		goto read_loop;
 	}
 checkControllerPoll:
@@ -302,11 +301,11 @@ checkControllerPoll:
 	if (bit0 != 0) // controller poll
 		{
 			bits = 33;
-			rawData[0] = 0x01;
+			command = 0x01;
 			goto read_loop;
 		}
 	bits = 25;     // Get controller info
-	rawData[0] = 0x00;
+	command = 0x00;
 	getControllerInfo = true;
 
 read_loop:
@@ -318,27 +317,23 @@ read_loop:
 
 	asm volatile(MICROSECOND_NOPS MICROSECOND_NOPS);
 
-	// Read a bit from the line and store as a byte in "rawData"
-	*rawDataPtr = READ_PORTD(0b00000100);
+	// Read a bit from the line and store it in "rawData", memory pack
+	// transfers are only counted
 	if (!ignoreBits)
-		++rawDataPtr;
+		cursor.put(READ_PORTD(0b00000100) != 0);
 	--bits;
 	if (bits == 0)
 	{
 		if (shortcutToControllerPoll) 
 		{   
-			rawDataPtr = &rawData[1];
+			cursor = BitCursor(rawData.data());
 			shortcutToControllerPoll = false;
 			goto checkControllerPoll;
 		}
-		else if (rawData[0] == 0x00 && rawData[2] == 0 && rawData[3] == 0 && rawData[4] == 0 && rawData[5] == 0
-			&& rawData[6] == 0 && rawData[7] != 0 && rawData[8] == 0 && rawData[9] != 0 && rawData[25] != 0) 
-		{
-			shortcutToControllerPoll = true;
-			bits = 8;
-		}
-		else if (rawData[0] == 0x00 && rawData[2] == 0 && rawData[3] == 0 && rawData[4] == 0 && rawData[5] == 0
-			&& rawData[6] == 0 && rawData[7] != 0 && rawData[8] == 0 && rawData[9] != 0 && rawData [24] == 0 && rawData[25] == 0) 
+		// Controller info answered with the standard controller id (bits 1-8
+		// read 00000101), with either a pak present or the status bits clear.
+		else if (command == 0x00 && (rawData.byteAt(0) & 0xFE) == 0x40 && rawData.get(8)
+			&& (rawData.get(24) || !rawData.get(23))) 
 		{
 			shortcutToControllerPoll = true;
 			bits = 8;
@@ -350,23 +345,20 @@ read_loop:
 	goto read_loop;
 }
 void N64Spy::writeSerial() {
-	const unsigned char first = getControllerInfo ? 1 : 2;
+	const unsigned char first = getControllerInfo ? 0 : 1;
 
-	for (unsigned char i = first; i < first + N64_BITCOUNT; i++) {
-		Serial.write(rawData[i] ? ONE : ZERO);
-	}
-	Serial.write(SPLIT);
+	sendRawData(rawData, first, N64_BITCOUNT);
 }
 
 void N64Spy::debugSerial() {
-	Serial.print(rawData[0]);
+	Serial.print(command);
 	Serial.print("|");
 	int j = 0;
-	const unsigned char first = getControllerInfo ? 1 : 2;
+	const unsigned char first = getControllerInfo ? 0 : 1;
 	for (unsigned char i = 0; i < 32; i++) {
 		if (j % 8 == 0 && j != 0)
 			Serial.print("|");
-		Serial.print(rawData[i + first] ? "1" : "0");
+		Serial.print(rawData.get(i + first) ? "1" : "0");
 		j++;
 	}
 	Serial.print("\n");
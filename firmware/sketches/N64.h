@@ -28,11 +28,15 @@
 #define N64Spy_h
 
 #include "ControllerSpy.h"
+#include "BitBuffer.h"
 
-class N64Spy : public ControllerSpy {
+class N64Spy final : public ControllerSpy {
 public:
 	void loop();
 	void loop1();
+#if defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
+	bool sendsFromLoop1() { return true; }
+#endif
 	void writeSerial();
 	void debugSerial();
 	void updateState();
@@ -42,10 +46,13 @@ public:
 private:
 	bool checkPrefixN64();
 #if defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_NANO) || defined(ARDUINO_AVR_NANO_EVERY) || defined(ARDUINO_AVR_LARDU_328E)
-	unsigned char rawData[100];
+	// Command byte seen before the response (0x00 info, 0x01 poll, 0x02
+	// memory pack, 0xFF reset), followed by up to 33 response bits.
+	unsigned char command;
+	BitBuffer<40> rawData;
 #else
-	unsigned char rawData[300];
-	unsigned char sendData[300];
+	BitBuffer<300> rawData;
+	BitBuffer<300> sendData;
 	bool sendRequest = false;
 #endif
 	
@@ -25,19 +25,23 @@
 // THE SOFTWARE.
 
 #include "NES.h"
+#include "OutputGovernor.h"
+#include "ShiftRegisterCapture.h"
 
 #if defined(ARDUINO_TEENSY35) || defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_NANO) || defined(ARDUINO_AVR_NANO_EVERY) || defined(ARDUINO_AVR_LARDU_328E) || defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 
+typedef ShiftRegisterCapture<FallingEdge<NES_CLOCK>, true, NES_BITCOUNT, NES_DATA, NES_DATA0, NES_DATA1> NESCapture;
+
 void NESSpy::loop() {
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	updateState();
-	interrupts();
+	SPY_INTERRUPTS();
 #if !defined(DEBUG)
-	writeSerial();
+	if (outputGovernor.admit(rawData.data(), rawData.byteCount))
+		writeSerial();
 #else
 	debugSerial();
 #endif
-	T_DELAY(5);
 }
 
 void NESSpy::writeSerial() {
@@ -50,20 +54,13 @@ void NESSpy::debugSerial() {
 
 void NESSpy::updateState() {
 #ifdef MODE_2WIRE_NES
-	read_shiftRegister_2wire(rawData, NES_LATCH, NES_DATA, true, NES_BITCOUNT);
+	read_shiftRegister_2wire(rawData.data(), NES_LATCH, NES_DATA, true, NES_BITCOUNT);
 #else
-	unsigned char bits = NES_BITCOUNT;
-	unsigned char *rawDataPtr = rawData;
+	NESCapture::clear(rawData.data());
 
 	WAIT_FALLING_EDGE(NES_LATCH);
 
-	do {
-		WAIT_FALLING_EDGE(NES_CLOCK);
-		*rawDataPtr = !PIN_READ(NES_DATA);
-		*(rawDataPtr + 8) = !PIN_READ(NES_DATA0);
-		*(rawDataPtr + 16) = !PIN_READ(NES_DATA1);
-		++rawDataPtr;
-	} while (--bits > 0);
+	NESCapture::clockIn<0, NES_BITCOUNT>(rawData.data());
 #endif
 }
 
@@ -35,8 +35,9 @@
 // ---------------------------------------------------------------------------------
 
 #include "ControllerSpy.h"
+#include "BitBuffer.h"
 
-class NESSpy : public ControllerSpy {
+class NESSpy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
@@ -46,7 +47,7 @@ public:
 	virtual const char* startupMsg();
 
 private:
-	unsigned char rawData[NES_BITCOUNT * 3];
+	BitBuffer<NES_BITCOUNT * 3> rawData;
 };
 
 #endif
@@ -25,20 +25,20 @@
 // THE SOFTWARE.
 
 #include "NeoGeo.h"
+#include "OutputGovernor.h"
 
 #if defined(ARDUINO_TEENSY35) || defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_NANO) || defined(ARDUINO_AVR_NANO_EVERY) || defined(ARDUINO_AVR_LARDU_328E)  || defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 
 void NeoGeoSpy::loop() {
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	updateState();
-	interrupts();
+	SPY_INTERRUPTS();
 #if !defined(DEBUG)
-	writeSerial();
+	if (outputGovernor.admit(rawData, sizeof(rawData)))
+		writeSerial();
 #else
 	debugSerial();
 #endif
-	
-	T_DELAY(5);
 }
 
 void NeoGeoSpy::updateState() {
@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class NeoGeoSpy : public ControllerSpy {
+class NeoGeoSpy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
@@ -28,6 +28,7 @@
 //#define TRACE
 
 #include "Nuon.h"
+#include "OutputGovernor.h"
  
 #if (defined(__arm__) && defined(CORE_TEENSY) && (defined(ARDUINO_TEENSY40) || defined(ARDUINO_TEENSY41))) || (defined(TP_ELASPEDMILLIS) && (defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)))
 
@@ -35,20 +36,20 @@
 
 static signed char tmp;
 static bool waitTmp = false;
-static unsigned long lastReadTime;
 static byte buffer[19];
 
 FASTRUN void NuonSpy::writeSerial()
 {	
 	buffer[18] = '\n';
 	
-	if (max(micros() - lastReadTime, 0U) < 2000)
-	{
-		// Not enough time has elapsed, return
+	// Buttons always go out, the two analog bytes are rate limited.
+	uint32_t buttons = 0;
+	for (int i = 0; i < 16; ++i)
+		buttons |= (buffer[i] == HIGH) ? (1UL << i) : 0;
+
+	if (!outputGovernor.admit(buffer, 18, buttons))
 		return;
-	}
 	Serial.write(buffer, 19);
-	lastReadTime = micros();
 }
 
 FASTRUN void NuonSpy::debugSerial()
@@ -86,12 +87,14 @@ start:
 	if ((rawData[0] = digitalReadFast(NUON_DATA_PIN)) == LOW)
 	{ 
 		//Serial.println("here3");;
+		spyStats.syncFailure();
 		goto start;
 	}
 	else if (restPeriod < 40)
 	{
 		//Serial.println("here4");
 		restPeriod = 0;
+		spyStats.syncFailure();
 		goto start;
 	}
 	else
@@ -165,13 +168,15 @@ FASTRUN void NuonSpy::loop()
 {
 	while (true)
 	{
-		noInterrupts();
+		SPY_NO_INTERRUPTS();
 		updateState();
-		interrupts();
+		SPY_INTERRUPTS();
 		
 #if !defined(DEBUG) && !defined(TRACE)
 		writeSerial();
 #endif
+		// Never returns to the main loop, so the pass ends here.
+		endSpyPass(true);
 	}
 }
 
@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class NuonSpy : public ControllerSpy {
+class NuonSpy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
@@ -0,0 +1,141 @@
+//
+// OutputGovernor.cpp
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "OutputGovernor.h"
+
+OutputGovernor outputGovernor;
+
+static uint16_t frameChecksum(const unsigned char data[], uint8_t length)
+{
+	uint8_t sum1 = 0;
+	uint8_t sum2 = 0;
+	for (uint8_t i = 0; i < length; ++i)
+	{
+		sum1 += data[i];
+		sum2 += sum1;
+	}
+	return (sum2 << 8) | sum1;
+}
+
+OutputGovernor::OutputGovernor()
+	: sent(0)
+	, coalesced(0)
+	, dropped(0)
+	, lastSent(0)
+	, lastButtons(0)
+	, lastLength(0)
+	, lastChecksum(0)
+{
+	setMaxRate(OUTPUT_MAX_RATE);
+}
+
+void OutputGovernor::setMaxRate(uint16_t hz)
+{
+	rate = hz;
+	interval = hz == 0 ? 0 : 1000000UL / hz;
+	lastLength = 0;
+}
+
+bool OutputGovernor::admit(const unsigned char frame[], uint8_t length)
+{
+	if (interval == 0)
+	{
+		++sent;
+		return true;
+	}
+
+	bool changed = !sameAsLast(frame, length);
+	return admitFrame(frame, length, changed, changed, interval);
+}
+
+bool OutputGovernor::admit(const unsigned char frame[], uint8_t length, uint32_t buttons)
+{
+	if (interval == 0)
+	{
+		++sent;
+		return true;
+	}
+
+	bool transition = buttons != lastButtons;
+	lastButtons = buttons;
+	return admitFrame(frame, length, !sameAsLast(frame, length), transition, interval);
+}
+
+bool OutputGovernor::admitAtMost(const unsigned char frame[], uint8_t length, uint16_t hz)
+{
+	unsigned long minInterval = 1000000UL / hz;
+	if (minInterval < interval)
+		minInterval = interval;
+
+	bool changed = !sameAsLast(frame, length);
+	return admitFrame(frame, length, changed, changed, minInterval);
+}
+
+// Every frame offered is a poll the spy decoded.  The transmit buffer is
+// sampled here too, for the spies that write their frames themselves.
+bool OutputGovernor::admitFrame(const unsigned char frame[], uint8_t length, bool changed, bool transition, unsigned long minInterval)
+{
+	unsigned long now = micros();
+	if (!transition && now - lastSent < minInterval)
+	{
+		if (changed)
+			++coalesced;
+		else
+			++dropped;
+		return false;
+	}
+
+	lastSent = now;
+	lastLength = length;
+	if (length <= OUTPUT_GOVERNOR_FRAME_MAX)
+		memcpy(lastFrame, frame, length);
+	else
+		lastChecksum = frameChecksum(frame, length);
+	++sent;
+	return true;
+}
+
+// Frames too long to keep a copy of are compared by checksum instead.
+bool OutputGovernor::sameAsLast(const unsigned char frame[], uint8_t length) const
+{
+	if (length != lastLength)
+		return false;
+	if (length <= OUTPUT_GOVERNOR_FRAME_MAX)
+		return memcmp(frame, lastFrame, length) == 0;
+	return frameChecksum(frame, length) == lastChecksum;
+}
+
+void OutputGovernor::printStats()
+{
+	Serial.print("// Rate: ");
+	Serial.print(rate);
+	Serial.print(" Sent: ");
+	Serial.print(sent);
+	Serial.print(" Coalesced: ");
+	Serial.print(coalesced);
+	Serial.print(" Dropped: ");
+	Serial.println(dropped);
+}
@@ -0,0 +1,86 @@
+//
+// OutputGovernor.h
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef OutputGovernor_h
+#define OutputGovernor_h
+
+#include "common.h"
+
+#define OUTPUT_GOVERNOR_FRAME_MAX 40
+
+// Sits between a spy and the serial port and decides which captured frames
+// are worth sending.  With a maximum rate set, frames that arrive before the
+// interval is up are held back unless their significant part (usually the
+// buttons) changed, so presses and releases always go out immediately while
+// repeated or analog-only updates are thinned out.  A frame that is held back
+// is never queued: the next frame sent is always the newest state.
+//
+//     sent      - frames passed to the host
+//     coalesced - frames that differed from the last one sent but were
+//                 superseded by a newer frame
+//     dropped   - frames identical to the last one sent
+class OutputGovernor {
+public:
+	OutputGovernor();
+
+	// Frames per second, 0 for no limit.
+	void setMaxRate(uint16_t hz);
+	uint16_t maxRate() const { return rate; }
+
+	// For frames that are all buttons or keys: every byte is significant.
+	// Frames carrying analog or mouse data must use the buttons form,
+	// otherwise nearly every frame counts as a change and nothing is limited.
+	bool admit(const unsigned char frame[], uint8_t length);
+
+	// Only a change in buttons bypasses the rate limit.
+	bool admit(const unsigned char frame[], uint8_t length, uint32_t buttons);
+
+	// As admit(frame, length), but repeats are held to at most hz even when
+	// no rate is set.  For buses polled far faster than the host can draw.
+	bool admitAtMost(const unsigned char frame[], uint8_t length, uint16_t hz);
+
+	void printStats();
+
+	uint32_t sent;
+	uint32_t coalesced;
+	uint32_t dropped;
+
+private:
+	bool admitFrame(const unsigned char frame[], uint8_t length, bool changed, bool transition, unsigned long minInterval);
+	bool sameAsLast(const unsigned char frame[], uint8_t length) const;
+
+	uint16_t rate;
+	unsigned long interval;
+	unsigned long lastSent;
+	uint32_t lastButtons;
+	uint8_t lastLength;
+	uint16_t lastChecksum;
+	unsigned char lastFrame[OUTPUT_GOVERNOR_FRAME_MAX];
+};
+
+extern OutputGovernor outputGovernor;
+
+#endif
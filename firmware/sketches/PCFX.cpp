@@ -25,13 +25,16 @@
 // THE SOFTWARE.
 
 #include "PCFX.h"
+#include "ShiftRegisterCapture.h"
 
 #if !(defined(__arm__) && defined(CORE_TEENSY))
 
+typedef ShiftRegisterCapture<FallingEdge<PCFX_CLOCK>, true, PCFX_BITCOUNT, PCFX_DATA> PCFXCapture;
+
 void PCFXSpy::loop() {
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	updateState();
-	interrupts();
+	SPY_INTERRUPTS();
 #if !defined(DEBUG)
 	writeSerial();
 #else
@@ -40,16 +43,11 @@ void PCFXSpy::loop() {
 }
 
 void PCFXSpy::updateState() {
-	unsigned char bits = PCFX_BITCOUNT;
-	unsigned char *rawDataPtr = rawData;
+	PCFXCapture::clear(rawData.data());
 
 	WAIT_FALLING_EDGE(PCFX_LATCH);
 
-	do {
-		WAIT_FALLING_EDGE(PCFX_CLOCK);
-		*rawDataPtr = !PIN_READ(PCFX_DATA);
-		++rawDataPtr;
-	} while (--bits > 0);
+	PCFXCapture::clockIn<0, PCFX_BITCOUNT>(rawData.data());
 }
 
 void PCFXSpy::writeSerial() {
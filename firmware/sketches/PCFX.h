@@ -28,8 +28,9 @@
 #define PCFXSpy_h
 
 #include "ControllerSpy.h"
+#include "BitBuffer.h"
 
-class PCFXSpy : public ControllerSpy {
+class PCFXSpy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
@@ -39,7 +40,7 @@ public:
 	virtual const char* startupMsg();
 
 private:
-	unsigned char rawData[8];
+	BitBuffer<PCFX_BITCOUNT> rawData;
 };
 
 #endif
@@ -28,9 +28,9 @@
 //#define SNIFFER
 
 #include "Pippin.h"
+#include "BitBuffer.h"
 
 #if defined(TP_TIMERONE) && !(defined(__arm__) && defined(CORE_TEENSY))
-#include <TimerOne.h>
 
 #define BUFFER_SIZE 45
 
@@ -61,62 +61,39 @@ struct Pippin_packet
 }
 ;
 
-static volatile Pippin_packet* buffer[BUFFER_SIZE];
-static uint8_t head, tail;
+// Timer 1 runs free at 2 MHz, so half a count is a microsecond.  The edge
+// interrupt restarts it and, while a packet could end without another
+// edge, arms compare B to close the packet after these many counts.
+#define DATA_START_TIMEOUT (261 * 2)
+#define DATA_STOP_TIMEOUT (51 * 2)
+
+// Packets are decoded in place in a fixed pool that doubles as a single
+// producer, single consumer ring.  The ISR fills the slot after head and
+// publishes it by moving head, loop() hands a slot back by moving tail.
+// When every slot is waiting to be sent new packets are ignored.
+static volatile Pippin_packet packets[BUFFER_SIZE];
+static volatile uint8_t head, tail;
 static volatile Pippin_packet* currentReadPacket = NULL;
 
 static volatile Pippin_packet* currentWritePacket = NULL;
+static uint8_t writeSlot;
 static volatile unsigned long diff;
 static volatile unsigned int count = 0, state = WAITING_FOR_ATTENTION;
 static volatile unsigned char command;
 byte lastMouseReportID;
 
-static byte rawData[16][40];
+// One report per ADB address.  Controller style devices use the first 40
+// bits, the keyboard at address 2 keeps a 128 key bitmap indexed by key code.
+static BitBuffer<128> rawData[16];
 
 void PippinSpy::loop()
 {
-	if (state == WAITING_FOR_DATA_START)
+	uint8_t next = tail;
+	if (next != head)
 	{
-		unsigned long _diff = TCNT1 >> 1;
-		if (_diff > 260)
-		{
-			currentWritePacket->HasData = false;
-			volatile Pippin_packet* donePacket = currentWritePacket;
-			currentWritePacket = NULL;
-			state = WAITING_FOR_ATTENTION;
-			uint8_t i = head + 1;
-			if (i >= BUFFER_SIZE) i = 0;
-			if (i != tail) {
-				buffer[i] = donePacket;
-				head = i;
-			}
-		}
-	}
-	else if (state == COULD_BE_DATA_STOP_BIT)
-	{
-		unsigned long _diff = TCNT1 >> 1;
-		if (_diff > 50)
-		{
-			currentWritePacket->dataStop = true;
-			volatile Pippin_packet* donePacket = currentWritePacket;
-			currentWritePacket = NULL;
-			state = WAITING_FOR_ATTENTION;
-			uint8_t i = head + 1;
-			if (i >= BUFFER_SIZE) i = 0;
-			if (i != tail) {
-				buffer[i] = donePacket;
-				head = i;
-			}
-		}
-	}
-
-	uint8_t i = tail;
-	if (i != head)
-	{
-		i++;
-		if (i >= BUFFER_SIZE) i = 0;
-		currentReadPacket = buffer[i];
-		tail = i;
+		next++;
+		if (next >= BUFFER_SIZE) next = 0;
+		currentReadPacket = &packets[next];
 
 #ifdef SNIFFER
 		
@@ -153,66 +130,53 @@ void PippinSpy::loop()
 				controllerAddress = currentReadPacket->commandAddress;
 			
 				for (int j = 0; j < 3; ++j)
-				{
-					for (int k = 0; k < 8; ++k)
-						rawData[currentReadPacket->commandAddress][(j * 8) + k] = (currentReadPacket->data[j] & (1 << k)) != 0;
-				}
-				rawData[currentReadPacket->commandAddress][24] = (currentReadPacket->data[3] & 0b00000001) != 0;
-				rawData[currentReadPacket->commandAddress][25] = (currentReadPacket->data[3] & 0b00000010) != 0;
-				rawData[currentReadPacket->commandAddress][26] = (currentReadPacket->data[3] & 0b00000100) != 0;
+					rawData[currentReadPacket->commandAddress].setByte(j, currentReadPacket->data[j]);
+				rawData[currentReadPacket->commandAddress].assign(24, (currentReadPacket->data[3] & 0b00000001) != 0);
+				rawData[currentReadPacket->commandAddress].assign(25, (currentReadPacket->data[3] & 0b00000010) != 0);
+				rawData[currentReadPacket->commandAddress].assign(26, (currentReadPacket->data[3] & 0b00000100) != 0);
 			}
 			else if (currentReadPacket->HasData && currentReadPacket->numBytes == 2 && currentReadPacket->commandAddress != 0x02) 
 			{
 				mouseAddress = currentReadPacket->commandAddress;
 				for (int j = 0; j < 2; ++j)
-				{
-					for (int k = 0; k < 8; ++k)
-						rawData[currentReadPacket->commandAddress][(j * 8) + k] = (currentReadPacket->data[j] & (1 << k)) != 0;
-				}  
+					rawData[currentReadPacket->commandAddress].setByte(j, currentReadPacket->data[j]);
 			}
 			else if (currentReadPacket->HasData && currentReadPacket->numBytes == 3 && currentReadPacket->commandAddress != 0x02)
 			{
 				joystickAddress = currentReadPacket->commandAddress;
 				for (int j = 0; j < 3; ++j)
-				{
-					for (int k = 0; k < 8; ++k)
-						rawData[currentReadPacket->commandAddress][(j * 8) + k] = (currentReadPacket->data[j] & (1 << k)) != 0;
-				}
+					rawData[currentReadPacket->commandAddress].setByte(j, currentReadPacket->data[j]);
 			}
 			else if (currentReadPacket->HasData && currentReadPacket->numBytes == 5)
 			{
 				tabletAddress = currentReadPacket->commandAddress;
 				for (int j = 0; j < 4; ++j)
-				{
-					for (int k = 0; k < 8; ++k)
-						rawData[currentReadPacket->commandAddress][(j * 8) + k] = (currentReadPacket->data[j] & (1 << k)) != 0;
-				}
-				rawData[currentReadPacket->commandAddress][32] = 1;
-				for (int j = 0; j < 7; ++j)
-					rawData[currentReadPacket->commandAddress][33 + j] = 0;
+					rawData[currentReadPacket->commandAddress].setByte(j, currentReadPacket->data[j]);
+				// Bit 32 flags the pen as touching, bits 33-39 are unused
+				rawData[currentReadPacket->commandAddress].setByte(4, 0b00000001);
 			}
 			else if (!currentReadPacket->HasData && currentReadPacket->numBytes == 0 && 
 				(currentReadPacket->commandAddress == mouseAddress || currentReadPacket->commandAddress == controllerAddress))
 			{
 				for (int i = 0; i < 7; ++i)
-					rawData[currentReadPacket->commandAddress][i] = 0;
+					rawData[currentReadPacket->commandAddress].reset(i);
 				for (int i = 8; i < 15; ++i)
-					rawData[currentReadPacket->commandAddress][i] = 0;
+					rawData[currentReadPacket->commandAddress].reset(i);
 			}
 			else if (!currentReadPacket->HasData && currentReadPacket->numBytes == 0 && currentReadPacket->commandAddress == tabletAddress)
 			{
-				rawData[currentReadPacket->commandAddress][32] = 0;
+				rawData[currentReadPacket->commandAddress].reset(32);
 			}
 			else if (currentReadPacket->HasData && currentReadPacket->numBytes == 2 && currentReadPacket->commandAddress == 0x02) 
 			{
       
 				if (currentReadPacket->data[0] == 0x7F && currentReadPacket->data[1] == 0x7F)
 				{
-					rawData[currentReadPacket->commandAddress][currentReadPacket->data[0] / 8] |= (1 << (currentReadPacket->data[0] % 8));
+					rawData[currentReadPacket->commandAddress].set(currentReadPacket->data[0]);
 				}
 				else if (currentReadPacket->data[0] == 0xFF && currentReadPacket->data[1] == 0xFF)
 				{
-					rawData[currentReadPacket->commandAddress][0x7F / 8] &= ~(1 << (0x7F % 8));
+					rawData[currentReadPacket->commandAddress].reset(0x7F);
 				}
 				else
 				{
@@ -220,11 +184,11 @@ void PippinSpy::loop()
 					{
 						if ((currentReadPacket->data[i] & 0b10000000) != 0 && currentReadPacket->data[i] != 0xFF)
 						{
-							rawData[currentReadPacket->commandAddress][(currentReadPacket->data[i] & 0b01111111) / 8] &= ~(1 << ((currentReadPacket->data[i] & 0b01111111) % 8));
+							rawData[currentReadPacket->commandAddress].reset(currentReadPacket->data[i] & 0b01111111);
 						}
 						else if (currentReadPacket->data[i] != 0xFF)
 						{ 
-							rawData[currentReadPacket->commandAddress][currentReadPacket->data[i] / 8] |= (1 << (currentReadPacket->data[i] % 8));
+							rawData[currentReadPacket->commandAddress].set(currentReadPacket->data[i]);
 						}
 					}
 				}
@@ -287,7 +251,7 @@ void PippinSpy::loop()
 			Serial.print(currentReadPacket->commandAddress & 0xF0);
 			Serial.print("|");
 			for (int j = 0; j < 27; ++j)
-				Serial.print(rawData[currentReadPacket->commandAddress][j] == 0 ? "0" : "1");
+				Serial.print(rawData[currentReadPacket->commandAddress].get(j) ? "1" : "0");
 			Serial.print("\n");
 		}
 		else
@@ -298,7 +262,7 @@ void PippinSpy::loop()
 			Serial.print("|");
 			for (int i = 0; i < 16; ++i)
 			{
-				Serial.print(rawData[currentReadPacket->commandAddress][i], HEX);
+				Serial.print(rawData[currentReadPacket->commandAddress].byteAt(i), HEX);
 				Serial.print(" ");
 			}
 			Serial.print("\n");        
@@ -312,27 +276,27 @@ void PippinSpy::loop()
 			{
 				lastMouseReportID = controllerAddress;
 				for (int j = 0; j < 27; ++j)
-					Serial.write(rawData[controllerAddress][j] == 0 ? 0 : 1);
+					Serial.write(rawData[controllerAddress].get(j) ? 1 : 0);
 			}
 			else if (currentReadPacket->commandAddress == mouseAddress || (currentReadPacket->commandAddress == 0x02 && lastMouseReportID == mouseAddress))
 			{
 				lastMouseReportID = mouseAddress;
 				for (int j = 0; j < 16; ++j)
-					Serial.write(rawData[mouseAddress][j] == 0 ? 0 : 1);
+					Serial.write(rawData[mouseAddress].get(j) ? 1 : 0);
 				for (int j = 16; j < 27; ++j)
-					Serial.write(rawData[controllerAddress][j] == 0 ? 0 : 1);
+					Serial.write(rawData[controllerAddress].get(j) ? 1 : 0);
 			}
 			else if (currentReadPacket->commandAddress == joystickAddress)
 			{
 				for (int j = 0; j < 24; ++j)
-					Serial.write(rawData[joystickAddress][j] == 0 ? 0 : 1);
+					Serial.write(rawData[joystickAddress].get(j) ? 1 : 0);
 			
 				Serial.write("\n");    
 			}
 			else if (currentReadPacket->commandAddress == tabletAddress)
 			{
 				for (int j = 0; j < 40; ++j)
-					Serial.write(rawData[tabletAddress][j] == 0 ? 0 : 1);			
+					Serial.write(rawData[tabletAddress].get(j) ? 1 : 0);			
 				Serial.write("\n");    
 			}		
 
@@ -340,15 +304,67 @@ void PippinSpy::loop()
 			{
 				for (int i = 0; i < 16; ++i)
 				{
-					Serial.write((rawData[0x02][i] & 0x0F) << 4);
-					Serial.write((rawData[0x02][i] & 0xF0));
+					Serial.write((rawData[0x02].byteAt(i) & 0x0F) << 4);
+					Serial.write((rawData[0x02].byteAt(i) & 0xF0));
 				}
 				Serial.write("\n");        
 			}
 		}
 #endif
 #endif
-		delete currentReadPacket;
+		tail = next;
+	}
+}
+
+// Only called from the ADB interrupts.  Takes the slot after head for the
+// packet that an attention pulse just started, or returns false if loop()
+// has not caught up yet.
+static bool claimPacket()
+{
+	uint8_t slot = head + 1;
+	if (slot >= BUFFER_SIZE) slot = 0;
+	if (slot == tail)
+		return false;
+
+	volatile Pippin_packet* packet = &packets[slot];
+	packet->commandType = 0;
+	packet->commandAddress = 0;
+	packet->commandRegister = 0;
+	packet->commandStop = false;
+	packet->HasData = false;
+	packet->dataStart = false;
+	packet->numBytes = 0;
+	packet->dataStop = false;
+	packet->count = 0;
+	packet->syncTiming = 0;
+
+	writeSlot = slot;
+	currentWritePacket = packet;
+	return true;
+}
+
+static void publishPacket()
+{
+	head = writeSlot;
+	currentWritePacket = NULL;
+	state = WAITING_FOR_ATTENTION;
+}
+
+// Compare B only fires when the line stayed quiet past the timeout armed
+// by the last edge, which ends the packet.
+ISR(TIMER1_COMPB_vect)
+{
+	TIMSK1 &= ~(1 << OCIE1B);
+
+	if (state == WAITING_FOR_DATA_START)
+	{
+		currentWritePacket->HasData = false;
+		publishPacket();
+	}
+	else if (state == COULD_BE_DATA_STOP_BIT)
+	{
+		currentWritePacket->dataStop = true;
+		publishPacket();
 	}
 }
 
@@ -357,9 +373,7 @@ void adbStateChanged()
 	diff = TCNT1 >> 1;
 
 	if (state == WAITING_FOR_ATTENTION) {
-		if (diff < 850 && diff > 750) {
-			if (currentWritePacket == NULL)
-				currentWritePacket = new Pippin_packet();
+		if (diff < 850 && diff > 750 && claimPacket()) {
 			state = WAITING_FOR_SYNC;
 		}
 	}
@@ -440,10 +454,25 @@ void adbStateChanged()
 			currentWritePacket->numBytes++;
 			currentWritePacket->count += count;
 			count = 0;
-			currentWritePacket->data[currentWritePacket->numBytes] = 0;
+			// ADB replies carry at most 8 bytes, anything longer is noise
+			if (currentWritePacket->numBytes >= sizeof(currentWritePacket->data))
+				state = WAITING_FOR_ATTENTION;
+			else
+				currentWritePacket->data[currentWritePacket->numBytes] = 0;
 		}
 	}
 	TCNT1 = 0;
+
+	if (state == WAITING_FOR_DATA_START || state == COULD_BE_DATA_STOP_BIT)
+	{
+		OCR1B = state == WAITING_FOR_DATA_START ? DATA_START_TIMEOUT : DATA_STOP_TIMEOUT;
+		TIFR1 = (1 << OCF1B);
+		TIMSK1 |= (1 << OCIE1B);
+	}
+	else
+	{
+		TIMSK1 &= ~(1 << OCIE1B);
+	}
 }
 
 void PippinSpy::writeSerial() {}
@@ -459,20 +488,25 @@ void PippinSpy::setup(byte controllerAddress, byte mouseAddress)
 	
 	for (int i = 0; i < 27; ++i)
 	{
-		rawData[controllerAddress][i] = 1;
-		rawData[mouseAddress][i] = 1;
-		rawData[0x02][i] = 0;
+		rawData[controllerAddress].set(i);
+		rawData[mouseAddress].set(i);
 	}
+	rawData[0x02].clear();
 	
 	lastMouseReportID = controllerAddress;
 	initialControllerAddress = this->controllerAddress = controllerAddress;
 	initialMouseAddress = this->mouseAddress = mouseAddress;
 	pinMode(ADB_PIN, INPUT_PULLUP);
+
+	// TIMER 1 free running at 2 MHz, compare B is armed per packet
+	cli(); // stop interrupts
+	TCCR1A = 0; // normal mode
+	TCCR1B = (1 << CS11); // 8 prescaler
+	TCNT1 = 0;
+	TIMSK1 = 0;
+	sei(); // allow interrupts
+
 	attachInterrupt(digitalPinToInterrupt(ADB_PIN), adbStateChanged, CHANGE);
-	Timer1.initialize(10000);
-	Timer1.stop();
-	Timer1.restart();
-	Timer1.detachInterrupt();
 }
 
 static char startupBuffer[100];
@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class PippinSpy : public ControllerSpy {
+class PippinSpy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
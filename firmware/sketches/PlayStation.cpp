@@ -25,23 +25,36 @@
 // THE SOFTWARE.
 
 #include "PlayStation.h"
+#include "OutputGovernor.h"
 
 #if defined(ARDUINO_TEENSY35) || defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_NANO) || defined(ARDUINO_AVR_NANO_EVERY) || defined(ARDUINO_AVR_LARDU_328E)  || defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 
 void PlayStationSpy::loop() {
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	updateState();
-	interrupts();
+	SPY_INTERRUPTS();
 #if !defined(DEBUG)
 	writeSerial();
 #else
 	debugSerial();
 #endif
-	T_DELAY(5);
+}
+
+// The PlayStation bus is LSB first and every field is byte aligned, so each
+// byte is assembled in a register and stored whole.
+static inline __attribute__((always_inline)) byte readPlayStationByte()
+{
+	byte value = 0;
+	byte mask = 1;
+	do {
+		WAIT_LEADING_EDGE(PS_CLOCK);
+		if (PIN_READ(PS_DATA))
+			value |= mask;
+	} while ((mask <<= 1) != 0);
+	return value;
 }
 
 void PlayStationSpy::updateState() {
-	byte numBits = 0;
 	WAIT_FALLING_EDGE(PS_ATT);
 
 	unsigned char bits = 0;
@@ -49,76 +62,67 @@ void PlayStationSpy::updateState() {
 		WAIT_LEADING_EDGE(PS_CLOCK);
 	} while (++bits < 8);
 
-	bits = 0;
+	byte controllerType = 0;
+	byte command = 0;
+	byte mask = 1;
 	do {
 		WAIT_LEADING_EDGE(PS_CLOCK);
 		byte pins = READ_PORTD(0b01100000);
 
-		rawData[numBits] = pins & 0b01000000;
-		playstationCommand[numBits] = pins & 0b00100000;
-		numBits++;
-	} while (++bits < 8);
+		if (pins & 0b01000000)
+			controllerType |= mask;
+		if (pins & 0b00100000)
+			command |= mask;
+	} while ((mask <<= 1) != 0);
+	rawData.setByte(0, controllerType);
+	playstationCommand = command;
 
 	bits = 0;
 	do {
 		WAIT_LEADING_EDGE(PS_CLOCK);
 	} while (++bits < 8);
 
-	bits = 0;
-	do {
-		WAIT_LEADING_EDGE(PS_CLOCK);
-		
-		byte pins = READ_PORTD(0b01100000);
+	// Buttons are active low, the rumble bytes sent alongside them are not.
+	for (int i = 0; i < 2; ++i)
+	{
+		byte buttons = 0;
+		byte rumble = 0;
+		mask = 1;
+		do {
+			WAIT_LEADING_EDGE(PS_CLOCK);
+			
+			byte pins = READ_PORTD(0b01100000);
 
-		rawData[numBits++] = !(pins & 0b01000000);
-		rawData[152 + bits] = pins & 0b00100000;
-		
-	} while (++bits < 16);
+			if (!(pins & 0b01000000))
+				buttons |= mask;
+			if (pins & 0b00100000)
+				rumble |= mask;
+		} while ((mask <<= 1) != 0);
+		rawData.setByte(1 + i, buttons);
+		rawData.setByte(152 / 8 + i, rumble);
+	}
 
 	//Read analog sticks for Analog Controller in Red Mode
-	if((rawData[0] != 0 && rawData[1] != 0 && rawData[2] == 0 && rawData[3] == 0 && rawData[4] != 0 && rawData[5] != 0 && rawData[6] != 0 && rawData[7] == 0)    // controllerType == 0x73 (DualShock 1)
-	   || (rawData[0] != 0 && rawData[1] != 0 && rawData[2] == 0 && rawData[3] == 0 && rawData[4] == 0 && rawData[5] != 0 && rawData[6] == 0 && rawData[7] == 0) // controllerType == 0x23 (NegCon)
-	   || (rawData[0] != 0 && rawData[1] != 0 && rawData[2] == 0 && rawData[3] == 0 && rawData[4] != 0 && rawData[5] == 0 && rawData[6] != 0 && rawData[7] == 0) // controllerType == 0x53 (Analogue Controller)
-		) 
-	{
-		for (int i = 0; i < 4; ++i)
-		{
-			bits = 0;
-			do {
-				WAIT_LEADING_EDGE(PS_CLOCK);
-				rawData[numBits++] = PIN_READ(PS_DATA);
-			} while (++bits < 8);
-		}
-	}
-	else if (rawData[0] == 0 && rawData[1] != 0 && rawData[2] == 0 && rawData[3] == 0 && rawData[4] != 0 && rawData[5] == 0 && rawData[6] == 0 && rawData[7] == 0) {
-		// controllerType == 0x12 (mouse)
-		for (int i = 0; i < 2; ++i) {
-			bits = 0;
-			do {
-				WAIT_LEADING_EDGE(PS_CLOCK);
-				rawData[numBits++] = PIN_READ(PS_DATA);
-			} while (++bits < 8);
-		}
-	}
-	else if (rawData[0] != 0 && rawData[1] == 0 && rawData[2] == 0 && rawData[3] != 0 && rawData[4] != 0 && rawData[5] != 0 && rawData[6] != 0 && rawData[7] == 0) {
-		// controllerType == 0x79 (DualShock 2)
-		for (int i = 0; i < 16; ++i) {
-			bits = 0;
-			do {
-				WAIT_LEADING_EDGE(PS_CLOCK);
-				rawData[numBits++] = PIN_READ(PS_DATA);
-			} while (++bits < 8);
-		}
-	}
+	byte extraBytes = 0;
+	if (controllerType == 0x73     // DualShock 1
+	   || controllerType == 0x23   // NegCon
+	   || controllerType == 0x53)  // Analogue Controller
+		extraBytes = 4;
+	else if (controllerType == 0x12) // Mouse
+		extraBytes = 2;
+	else if (controllerType == 0x79) // DualShock 2
+		extraBytes = 16;
+
+	for (byte i = 0; i < extraBytes; ++i)
+		rawData.setByte(3 + i, readPlayStationByte());
 }
 
 void PlayStationSpy::writeSerial() {
-	if (playstationCommand[0] == 0 && playstationCommand[1] != 0 && playstationCommand[2] == 0 && playstationCommand[3] == 0 && playstationCommand[4] == 0 && playstationCommand[5] == 0 && playstationCommand[6] != 0 && playstationCommand[7] == 0) {
-		// playstationCommand=0x42 (Controller Poll)
-		for (unsigned char i = 0; i < 168; ++i) {
-			Serial.write(rawData[i] ? ONE : ZERO);
-		}
-		Serial.write(SPLIT);
+	// Only controller polls (0x42) are sent, the analog axes alone do not
+	// bypass the rate limit.
+	if (playstationCommand == 0x42
+		&& outputGovernor.admit(rawData.data(), rawData.byteCount, ((uint32_t)rawData.byteAt(0) << 16) | (rawData.byteAt(2) << 8) | rawData.byteAt(1))) {
+		sendRawData(rawData, 0, 168);
 	}
 }
 
@@ -127,7 +131,7 @@ void PlayStationSpy::debugSerial() {
 		if (i % 8 == 0) {
 			Serial.print("|");
 		}
-		Serial.print(rawData[i] ? "1" : "0");
+		Serial.print(rawData.get(i) ? "1" : "0");
 	}
 	Serial.print("\n");
 }
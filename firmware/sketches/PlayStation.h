@@ -28,8 +28,9 @@
 #define PlayStationSpy_h
 
 #include "ControllerSpy.h"
+#include "BitBuffer.h"
 
-class PlayStationSpy : public ControllerSpy {
+class PlayStationSpy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
@@ -39,8 +40,8 @@ public:
 	virtual const char* startupMsg();
 
 private:
-	unsigned char rawData[168]; // 8 + 16 + 128 + 16 (for rumble starts at 152)
-	unsigned char playstationCommand[8];
+	BitBuffer<168> rawData; // 8 + 16 + 128 + 16 (for rumble starts at 152)
+	unsigned char playstationCommand;
 };
 
 #endif
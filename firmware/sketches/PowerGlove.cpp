@@ -25,9 +25,16 @@
 // THE SOFTWARE.
 
 #include "PowerGlove.h"
+#include "OutputGovernor.h"
+#include "ShiftRegisterCapture.h"
 
 #if defined(ARDUINO_TEENSY35) || defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_NANO) || defined(ARDUINO_AVR_NANO_EVERY) || defined(ARDUINO_AVR_LARDU_328E) ||  defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 
+typedef ShiftRegisterCapture<FallingEdge<NES_CLOCK>, false, NES_BITCOUNT * 10, NES_DATA> PowerGloveCapture;
+
+// First byte of a Power Glove frame, 0xA0 sent MSB first.
+#define POWERGLOVE_SYNC_BYTE 0x05
+
 static bool sync = false;
 
 void PowerGloveSpy::loop() {
@@ -35,11 +42,12 @@ void PowerGloveSpy::loop() {
 	updateState();
 
 #if !defined(DEBUG)
-	writeSerial();
+	// Bytes 5 and 6 are the fingers and the keypad, the rest is position.
+	if (outputGovernor.admit(rawData.data(), rawData.byteCount, rawData.extractMsbFirst(40, 16)))
+		writeSerial();
 #else
 	debugSerial();
 #endif
-	T_DELAY(5);
 }
 
 void PowerGloveSpy::writeSerial() {
@@ -51,25 +59,19 @@ void PowerGloveSpy::debugSerial() {
 	
 	for(int i = 0 ; i < 5 ; ++i)
 	{
-		int b = 0;
-		for (int j = 0; j < 8; ++j)
-		{
-			b |= rawData[i * 8 + j] == 0 ? 0b00000000 : (1 << (7-j));
-			
-		}
-		Serial.print(b, HEX);
+		Serial.print(rawData.extractMsbFirst(i * 8, 8), HEX);
 		Serial.print("|");
 	}
 	
 	for (int i = 0; i < 8; ++i)
 	{
-		Serial.print(rawData[40 + i] == 0 ? 0 : 1);
+		Serial.print(rawData.get(40 + i) ? 1 : 0);
 	}
 	Serial.print("|");
 	
 	for (int i = 0; i < 8; ++i)
 	{
-		Serial.print(rawData[48 + i] == 0 ? 0 : 1);
+		Serial.print(rawData.get(48 + i) ? 1 : 0);
 	}
 	
 	Serial.print("\n");
@@ -77,51 +79,35 @@ void PowerGloveSpy::debugSerial() {
 
 void PowerGloveSpy::updateState() {
 
-	unsigned char bits = NES_BITCOUNT*10;
-	unsigned char *rawDataPtr = rawData;
-
 	if (!sync)
 	{
-		noInterrupts();
+		SPY_NO_INTERRUPTS();
 		WAIT_FALLING_EDGE(NES_LATCH);
-		interrupts();
+		SPY_INTERRUPTS();
 		delay(5);
 	}
 	
 	while (true)
 	{
-		noInterrupts();
+		rawData.setByte(0, 0);
+		SPY_NO_INTERRUPTS();
 		WAIT_FALLING_EDGE(NES_LATCH);
-		int i = 0;
-		do {
-			WAIT_FALLING_EDGE(NES_CLOCK);
-			*rawDataPtr = PIN_READ(NES_DATA);
-			++rawDataPtr;
-		} while (++i < 8);
-		interrupts();
+		PowerGloveCapture::clockIn<0, 8>(rawData.data());
+		SPY_INTERRUPTS();
 		
-		if (rawData[0] != 0 && rawData[1] == 0 && rawData[2] != 0 && rawData[3] == 0 &&rawData[4] == 0 &&rawData[5] == 0 &&rawData[6] == 0 &&rawData[7] == 0)
+		if (rawData.byteAt(0) == POWERGLOVE_SYNC_BYTE)
 		{
-			bits -= 8;
 			sync = true;
 			break;
 		}
-		else
-		{
-			rawDataPtr = rawData;
-		}
 	}
 	
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	WAIT_FALLING_EDGE(NES_LATCH);
 
-	do {
-		WAIT_FALLING_EDGE(NES_CLOCK);
-		*rawDataPtr = PIN_READ(NES_DATA);
-		++rawDataPtr;
-	} while (--bits > 0);
+	PowerGloveCapture::clockInBytes(rawData.data() + 1, (NES_BITCOUNT * 10) / 8 - 1);
 	
-	interrupts();
+	SPY_INTERRUPTS();
 }
 
 #else
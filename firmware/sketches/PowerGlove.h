@@ -28,8 +28,9 @@
 #define PowerGloveSpy_h
 
 #include "ControllerSpy.h"
+#include "BitBuffer.h"
 
-class PowerGloveSpy : public ControllerSpy {
+class PowerGloveSpy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
@@ -39,7 +40,7 @@ public:
 	virtual const char* startupMsg();
 
 private:
-	unsigned char rawData[NES_BITCOUNT * 10];
+	BitBuffer<NES_BITCOUNT * 10> rawData;
 }
 ;
 
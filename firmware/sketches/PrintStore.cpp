@@ -0,0 +1,224 @@
+//
+// PrintStore.cpp
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "PrintStore.h"
+
+#if defined(ESP_PLATFORM)
+
+#define PRINTSTORE_DIR   "/prints"
+#define PRINTSTORE_INDEX PRINTSTORE_DIR "/index.txt"
+#define PRINTSTORE_EPOCH PRINTSTORE_DIR "/epoch.txt"
+
+PrintStore::PrintStore()
+	: fs(NULL)
+	, nextId(0)
+	, clearCount(0)
+	, printBytes(0)
+	, freeCount(0)
+	, queueHead(0)
+	, queueCount(0)
+	, current(NULL)
+{
+	for (uint8_t i = 0; i < poolSize; ++i)
+		release(&pool[i]);
+}
+
+bool PrintStore::begin(fs::FS& fs)
+{
+	this->fs = &fs;
+	if (!fs.exists(PRINTSTORE_DIR) && !fs.mkdir(PRINTSTORE_DIR))
+		return false;
+
+	// Continue numbering after the last indexed print
+	nextId = 0;
+	File index = fs.open(PRINTSTORE_INDEX, "r");
+	if (index)
+	{
+		while (index.available())
+		{
+			String line = index.readStringUntil('\n');
+			if (line.length() > 0)
+				nextId = line.toInt() + 1;
+		}
+		index.close();
+	}
+
+	clearCount = 0;
+	File epoch = fs.open(PRINTSTORE_EPOCH, "r");
+	if (epoch)
+	{
+		clearCount = epoch.readStringUntil('\n').toInt();
+		epoch.close();
+	}
+	return true;
+}
+
+void PrintStore::write(char c)
+{
+	if (current == NULL)
+	{
+		current = acquire();
+		if (current == NULL)
+		{
+			// Every buffer is waiting for flash, make room
+			flushOne();
+			current = acquire();
+		}
+	}
+
+	current->data[current->length++] = c;
+	if (current->length == bufferSize)
+		queueCurrent();
+}
+
+void PrintStore::write(const char* str)
+{
+	while (*str != '\0')
+		write(*str++);
+}
+
+void PrintStore::service()
+{
+	if (queueCount > 0)
+		flushOne();
+}
+
+bool PrintStore::endPrint()
+{
+	if (current != NULL && current->length > 0)
+		queueCurrent();
+	while (queueCount > 0)
+		flushOne();
+
+	if (!file)
+		return false;
+	file.close();
+
+	File index = fs->open(PRINTSTORE_INDEX, "a", true);
+	if (index)
+	{
+		index.printf("%u,%u,%lu\n", nextId, printBytes, millis());
+		index.close();
+	}
+
+	++nextId;
+	printBytes = 0;
+	return true;
+}
+
+void PrintStore::clear()
+{
+	if (file)
+		file.close();
+	while (queueCount > 0)
+	{
+		release(queue[queueHead]);
+		queueHead = (queueHead + 1) % poolSize;
+		--queueCount;
+	}
+	if (current != NULL)
+		current->length = 0;
+
+	// Everything but the epoch goes, including the print being written and
+	// any left behind by a session that ended before indexing it.
+	File dir = fs->open(PRINTSTORE_DIR);
+	if (dir)
+	{
+		for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile())
+		{
+			const String path = entry.path();
+			const bool isDirectory = entry.isDirectory();
+			entry.close();
+			if (!isDirectory && path != PRINTSTORE_EPOCH)
+				fs->remove(path);
+		}
+		dir.close();
+	}
+	nextId = 0;
+	printBytes = 0;
+
+	++clearCount;
+	File epoch = fs->open(PRINTSTORE_EPOCH, "w");
+	if (epoch)
+	{
+		epoch.printf("%u\n", clearCount);
+		epoch.close();
+	}
+}
+
+PrintStore::Buffer* PrintStore::acquire()
+{
+	if (freeCount == 0)
+		return NULL;
+	Buffer* buffer = freeBuffers[--freeCount];
+	buffer->length = 0;
+	return buffer;
+}
+
+void PrintStore::release(Buffer* buffer)
+{
+	freeBuffers[freeCount++] = buffer;
+}
+
+void PrintStore::queueCurrent()
+{
+	queue[(queueHead + queueCount) % poolSize] = current;
+	++queueCount;
+	current = NULL;
+}
+
+void PrintStore::flushOne()
+{
+	Buffer* buffer = queue[queueHead];
+	queueHead = (queueHead + 1) % poolSize;
+	--queueCount;
+
+	if (file || openPrint())
+	{
+		file.write((const uint8_t*)buffer->data, buffer->length);
+		printBytes += buffer->length;
+	}
+	release(buffer);
+}
+
+bool PrintStore::openPrint()
+{
+	if (fs == NULL)
+		return false;
+
+	char path[24];
+	printPath(path, nextId);
+	file = fs->open(path, "w");
+	return (bool)file;
+}
+
+void PrintStore::printPath(char* path, uint16_t id) const
+{
+	snprintf(path, 24, PRINTSTORE_DIR "/%04u.txt", id);
+}
+
+#endif
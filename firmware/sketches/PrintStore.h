@@ -0,0 +1,104 @@
+//
+// PrintStore.h
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef PrintStore_h
+#define PrintStore_h
+
+#if defined(ESP_PLATFORM)
+
+#include "Arduino.h"
+#include "FS.h"
+
+// Captured printer output on flash, one file per print.
+//
+//     /prints/NNNN.txt   - the raw packet text of print NNNN
+//     /prints/index.txt  - one "id,bytes,millis" line per finished print
+//
+// Text is staged in a fixed pool of write buffers and only full buffers go
+// to flash, one per service() call, so memory use is constant no matter how
+// long a print is and the main loop never blocks on one large write while
+// the link ring is filling.  millis is the uptime when the print finished,
+// the board has no real time clock.  /prints/epoch.txt counts the clears.
+class PrintStore {
+public:
+	static const size_t bufferSize = 1024;
+	static const uint8_t poolSize = 4;
+
+	PrintStore();
+
+	bool begin(fs::FS& fs);
+
+	void write(char c);
+	void write(const char* str);
+
+	// Writes at most one full buffer.  Call once per loop.
+	void service();
+
+	// Flushes and closes the current print and adds it to the index.
+	// Return: false if nothing was written since the last print
+	bool endPrint();
+
+	// Deletes every print, finished or not, and the index.
+	void clear();
+
+	uint16_t printCount() const { return nextId; }
+
+	// Bumped by every clear(), so ids reused afterwards can be told apart.
+	uint16_t epoch() const { return clearCount; }
+
+private:
+	struct Buffer
+	{
+		size_t length;
+		char data[bufferSize];
+	};
+
+	Buffer* acquire();
+	void release(Buffer* buffer);
+	void queueCurrent();
+	void flushOne();
+	bool openPrint();
+	void printPath(char* path, uint16_t id) const;
+
+	fs::FS* fs;
+	File file;
+	uint16_t nextId;
+	uint16_t clearCount;
+	uint32_t printBytes;
+
+	Buffer pool[poolSize];
+	Buffer* freeBuffers[poolSize];
+	uint8_t freeCount;
+	Buffer* queue[poolSize];
+	uint8_t queueHead;
+	uint8_t queueCount;
+	Buffer* current;
+};
+
+#endif
+
+#endif
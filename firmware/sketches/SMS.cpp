@@ -25,6 +25,7 @@
 // THE SOFTWARE.
 
 #include "SMS.h"
+#include "OutputGovernor.h"
 
 #if defined(ARDUINO_TEENSY35) || defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_NANO) || defined(ARDUINO_AVR_NANO_EVERY) || defined(ARDUINO_AVR_LARDU_328E) || defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 
@@ -75,12 +76,11 @@ void SMSSpy::setup() {
 void SMSSpy::loop() {
 	updateState();
 #if !defined(DEBUG)
-	writeSerial();
+	if (outputGovernor.admit((const unsigned char*)&currentState, sizeof(currentState)))
+		writeSerial();
 #else
 	debugSerial();
 #endif
-	
-	T_DELAY(5);
 }
 
 void SMSSpy::updateState() {
@@ -90,7 +90,7 @@ void SMSSpy::updateState() {
 		return;
 	}
 
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 
 	// Clear current state
 	currentState = 0;
@@ -105,7 +105,7 @@ void SMSSpy::updateState() {
 	if (digitalRead(inputPins[4]) == LOW) { currentState |= CC_BTN_1; }
 	if (digitalRead(inputPins[5]) == LOW) { currentState |= CC_BTN_2; }
 	
-	interrupts();
+	SPY_INTERRUPTS();
 
 	lastReadTime = millis();
 }
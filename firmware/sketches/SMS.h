@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class SMSSpy : public ControllerSpy {
+class SMSSpy final : public ControllerSpy {
 public:
 	void setup(uint8_t cableType, uint8_t outputType = OUTPUT_SMS);
 	void setup();
@@ -80,26 +80,26 @@ void SMSPaddleSpy::updateState()
 
 void SMSPaddleSpy::updateStateLegacy()
 {
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	value = 0;
 	WAIT_FALLING_EDGEB(0);
 	value |= (READ_PORTD(0b00111100)) >> 2;
 	WAIT_LEADING_EDGEB(0);
 	value |= (READ_PORTD(0b00111100)) << 2;
 	button = PIN_READ(7) == 0;
-	interrupts();
+	SPY_INTERRUPTS();
 }
 
 void SMSPaddleSpy::updateStateVision()
 {
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	value = 0;
 	WAIT_FALLING_EDGE(7);
 	value |= (READ_PORTD(0b00111100)) >> 2;
 	WAIT_LEADING_EDGE(7);
 	value |= (READ_PORTD(0b00111100)) << 2;
 	button = PIN_READ(6) == 0;
-	interrupts();
+	SPY_INTERRUPTS();
 }
 
 #else
@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class SMSPaddleSpy : public ControllerSpy {
+class SMSPaddleSpy final : public ControllerSpy {
 public:
 	void setup(uint8_t cableType);
 	void setup();
@@ -79,14 +79,14 @@ void SMSSportsPadSpy::updateState()
 	x = y = 0;
 	if (!sync)
 	{
-		noInterrupts();
+		SPY_NO_INTERRUPTS();
 		WAIT_FALLING_EDGEB(0);
-		interrupts();
+		SPY_INTERRUPTS();
 		delay(5);
 		sync = true;
 	}
 	
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	WAIT_FALLING_EDGEB(0);
 	y |= (READ_PORTD(0b00111100)) >> 2;
 	WAIT_LEADING_EDGEB(0);
@@ -98,7 +98,7 @@ void SMSSportsPadSpy::updateState()
 	
 	button1 = PIN_READ(6) == 0;
 	button2 = PIN_READ(7) == 0;
-	interrupts();
+	SPY_INTERRUPTS();
 }
 
 #else
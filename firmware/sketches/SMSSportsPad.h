@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class SMSSportsPadSpy : public ControllerSpy {
+class SMSSportsPadSpy final : public ControllerSpy {
 public:
 	void setup();
 	void loop();
@@ -25,9 +25,13 @@
 // THE SOFTWARE.
 
 #include "SNES.h"
+#include "OutputGovernor.h"
+#include "ShiftRegisterCapture.h"
 
 #if defined(ARDUINO_TEENSY35) || defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_NANO) || defined(ARDUINO_AVR_NANO_EVERY) || defined(ARDUINO_AVR_LARDU_328E) || defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 
+typedef ShiftRegisterCapture<FallingEdge<SNES_CLOCK>, true, SNES_BITCOUNT_EXT, SNES_DATA> SNESCapture;
+
 #if defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_NANO)
 #define LOOP_COUNT_THRESHOLD 8000
 #define USE_LOOP_COUNT_THRESHOLD
@@ -52,14 +56,14 @@ void SNESSpy::loop() {
 	if (sendRequest)
 	{
 		sendBytes = bytesToReturn;
-		memcpy(sendData, rawData, SNES_BITCOUNT_EXT);
+		sendData = rawData;
 		sendRequest = false;
 #ifdef DEBUG
 		debugSerial();
 #else
-		writeSerial();
+		if (outputGovernor.admit(sendData.data(), (sendBytes + 7) / 8))
+			writeSerial();
 #endif
-		T_DELAY(5);
 	}
 }
 
@@ -81,10 +85,8 @@ void SNESSpy::debugSerial() {
 
 void SNESSpy::updateState() {
 #ifdef MODE_2WIRE_SNES
-	read_shiftRegister_2wire(rawData, SNES_LATCH, SNES_DATA, false, SNES_BITCOUNT);
+	read_shiftRegister_2wire(rawData.data(), SNES_LATCH, SNES_DATA, false, SNES_BITCOUNT);
 #else
-	unsigned char position = 0;
-	unsigned char bits = 0;
 #if	!defined(USE_LOOP_COUNT_THRESHOLD)
 	unsigned long start;
 #endif
@@ -94,10 +96,9 @@ waiting_for_latch:
 #if	!defined(USE_LOOP_COUNT_THRESHOLD)
 	start = millis();
 #endif
-	position = 0;
-	bits = 0;
+	SNESCapture::clear(rawData.data());
 #if	defined(USE_LOOP_COUNT_THRESHOLD)
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 #endif
 	WAIT_FALLING_EDGE_COUNT(SNES_LATCH);
 
@@ -107,38 +108,33 @@ waiting_for_latch:
 	if (millis() - start < 10)
 #endif
 	{
+		spyStats.syncFailure();
 #if	defined(USE_LOOP_COUNT_THRESHOLD)
-		interrupts();
+		SPY_INTERRUPTS();
 #endif
 		goto waiting_for_latch;
 	}
 	
 #if	!defined(USE_LOOP_COUNT_THRESHOLD)
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 #endif	
 	
-	do {
-		WAIT_FALLING_EDGE(SNES_CLOCK);
-		rawData[position++] = !PIN_READ(SNES_DATA);
-	} while (++bits < SNES_BITCOUNT);
+	SNESCapture::clockIn<0, SNES_BITCOUNT>(rawData.data());
 
-	if (rawData[15] != 0 && rawData[0] != 0)
+	if (rawData.get(15) && rawData.get(0))
 	{
-		interrupts();
+		spyStats.syncFailure();
+		SPY_INTERRUPTS();
 		goto waiting_for_latch;
 	}
 	
-	if (rawData[15] != 0x0 || (rawData[15] == 0x00 && rawData[13] != 0x00))
+	if (rawData.get(15) || rawData.get(13))
 	{
-		bits = 0;
-		do {
-			WAIT_FALLING_EDGE(SNES_CLOCK);
-			rawData[position++] = !PIN_READ(SNES_DATA);
-		} while (++bits < SNES_BITCOUNT);
+		SNESCapture::clockIn<SNES_BITCOUNT, SNES_BITCOUNT>(rawData.data());
 
 		bytesToReturn = SNES_BITCOUNT_EXT;
 	}
-	interrupts();
+	SPY_INTERRUPTS();
 #endif
 }
 
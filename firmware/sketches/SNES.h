@@ -35,8 +35,9 @@
 // ---------------------------------------------------------------------------------
 
 #include "ControllerSpy.h"
+#include "BitBuffer.h"
 
-class SNESSpy : public ControllerSpy {
+class SNESSpy final : public ControllerSpy {
 public:
 	void setup1();
 	void loop();
@@ -48,9 +49,9 @@ public:
 	virtual const char* startupMsg();
 
 private:
-	unsigned char rawData[SNES_BITCOUNT_EXT];
+	BitBuffer<SNES_BITCOUNT_EXT> rawData;
 	unsigned char bytesToReturn = SNES_BITCOUNT;
-    unsigned char sendData[SNES_BITCOUNT_EXT];
+    BitBuffer<SNES_BITCOUNT_EXT> sendData;
     unsigned char sendBytes = SNES_BITCOUNT;
     volatile bool sendRequest = false;
 };
@@ -25,20 +25,21 @@
 // THE SOFTWARE.
 
 #include "Saturn.h"
+#include "OutputGovernor.h"
 
 #if defined(ARDUINO_TEENSY35) || defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_NANO) || defined(ARDUINO_AVR_NANO_EVERY) || defined(ARDUINO_AVR_LARDU_328E) || defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 
 void SaturnSpy::loop() {
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	updateState();
-	interrupts();
+	SPY_INTERRUPTS();
 #if !defined(DEBUG)
-	writeSerial();
+	const byte frame[] = { ssState1, ssState2, ssState3, ssState4 };
+	if (outputGovernor.admit(frame, sizeof(frame)))
+		writeSerial();
 #else
 	debugSerial();
 #endif
-
-	T_DELAY(5);
 }
 
 void SaturnSpy::updateState() {
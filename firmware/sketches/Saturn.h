@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class SaturnSpy : public ControllerSpy {
+class SaturnSpy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
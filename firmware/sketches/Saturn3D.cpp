@@ -25,6 +25,7 @@
 // THE SOFTWARE.
 
 #include "Saturn3D.h"
+#include "OutputGovernor.h"
 
 #if defined(ARDUINO_TEENSY35) || defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_NANO) || defined(ARDUINO_AVR_NANO_EVERY) || defined(ARDUINO_AVR_LARDU_328E) || defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
 
@@ -36,16 +37,27 @@ static byte keycode = 0;
 
 void Saturn3DSpy::loop() {
 
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	updateState();
-	interrupts();
+	SPY_INTERRUPTS();
 #if !defined(DEBUG)
-	writeSerial();
+	bool admitted;
+	if (isKeyboard)
+		admitted = outputGovernor.admit(keyboardData, sizeof(keyboardData));
+	else
+	{
+		// The ID and the two button bytes, one bit per entry; the analog
+		// axes follow them.
+		uint32_t buttons = 0;
+		for (byte i = 0; i < 24; ++i)
+			buttons = (buttons << 1) | (rawData[i] != 0);
+		admitted = outputGovernor.admit(rawData, sizeof(rawData), buttons);
+	}
+	if (admitted)
+		writeSerial();
 #else
 	debugSerial();
 #endif
-
-	T_DELAY(5);
 }
 
 void Saturn3DSpy::setup()
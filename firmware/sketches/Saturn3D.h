@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class Saturn3DSpy : public ControllerSpy {
+class Saturn3DSpy final : public ControllerSpy {
 public:
 	void setup();
 	void loop();
@@ -0,0 +1,171 @@
+//
+// ShiftRegisterCapture.h
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ShiftRegisterCapture_h
+#define ShiftRegisterCapture_h
+
+#include "BitBuffer.h"
+
+#define SR_ALWAYS_INLINE inline __attribute__((always_inline))
+
+// Clock edge policies.  Each one waits for a single edge on the clock line.
+template<uint8_t Pin>
+struct FallingEdge
+{
+	static SR_ALWAYS_INLINE void wait() { WAIT_FALLING_EDGE(Pin); }
+};
+
+template<uint8_t Pin>
+struct LeadingEdge
+{
+	static SR_ALWAYS_INLINE void wait() { WAIT_LEADING_EDGE(Pin); }
+};
+
+template<uint8_t Pin>
+struct LeadingEdgeB
+{
+	static SR_ALWAYS_INLINE void wait() { WAIT_LEADING_EDGEB(Pin); }
+};
+
+// Capture kernel shared by the shift register based consoles (NES, SNES, GBA,
+// 3DO, PC-FX, Power Glove).  Everything that differs between them is a
+// template argument, so each console gets its own fully unrolled loop with
+// the bit positions folded into constants:
+//
+//     Clock    - edge policy for the clock line (FallingEdge<pin>, ...)
+//     Inverted - true when the bus is active low
+//     LineBits - bits per data line, line n is stored at bit n * LineBits
+//     DataPins - port D pins sampled in parallel on every clock
+//
+// Bits are packed LSB first in the same layout as BitBuffer, spies pass the
+// kernel their buffer's data().  The kernel only ever sets bits, so the
+// buffer must be cleared before each capture.  On boards with a single
+// readable port all data lines are taken from one read of the port per clock
+// edge.
+template<typename Clock, bool Inverted, uint8_t LineBits, uint8_t... DataPins>
+class ShiftRegisterCapture {
+public:
+	static const uint8_t lineCount = sizeof...(DataPins);
+	static const uint8_t byteCount = (lineCount * LineBits + 7) / 8;
+
+	static SR_ALWAYS_INLINE void clear(unsigned char packed[])
+	{
+		for (uint8_t i = 0; i < byteCount; ++i)
+			packed[i] = 0;
+	}
+
+	// Clocks in Count bits per line, storing them from bit First onwards.
+	template<uint8_t First, uint8_t Count>
+	static SR_ALWAYS_INLINE void clockIn(unsigned char packed[])
+	{
+		ClockBits<First, Count>::run(packed);
+	}
+
+	// Samples bit Bit of every line right now, without waiting for a clock.
+	template<uint8_t Bit>
+	static SR_ALWAYS_INLINE void sample(unsigned char packed[])
+	{
+		store<Bit>(packed);
+	}
+
+	// Clocks in count whole bytes on a single data line.  Each byte is
+	// unrolled but the bytes are looped, which keeps long frames such as the
+	// Power Glove's from blowing up flash usage.
+	static void clockInBytes(unsigned char packed[], uint8_t count)
+	{
+		static_assert(sizeof...(DataPins) == 1, "clockInBytes only supports a single data line");
+		do {
+			*packed = 0;
+			ClockBits<0, 8>::run(packed);
+			++packed;
+		} while (--count > 0);
+	}
+
+private:
+	template<uint8_t Bit, uint8_t Remaining>
+	struct ClockBits
+	{
+		static SR_ALWAYS_INLINE void run(unsigned char packed[])
+		{
+			Clock::wait();
+			store<Bit>(packed);
+			ClockBits<Bit + 1, Remaining - 1>::run(packed);
+		}
+	};
+
+	template<uint8_t Bit>
+	struct ClockBits<Bit, 0>
+	{
+		static SR_ALWAYS_INLINE void run(unsigned char[]) {}
+	};
+
+	template<uint8_t Bit, uint8_t Line, uint8_t... Pins>
+	struct StoreLines;
+
+	template<uint8_t Bit, uint8_t Line, uint8_t Pin, uint8_t... Rest>
+	struct StoreLines<Bit, Line, Pin, Rest...>
+	{
+		static const uint8_t index = Line * LineBits + Bit;
+
+		template<typename Port>
+		static SR_ALWAYS_INLINE void run(Port pins, unsigned char packed[])
+		{
+			if (pins & (1 << Pin))
+				packed[index >> 3] |= (1 << (index & 7));
+			StoreLines<Bit, Line + 1, Rest...>::run(pins, packed);
+		}
+
+		static SR_ALWAYS_INLINE void run(unsigned char packed[])
+		{
+			if ((PIN_READ(Pin) != 0) != Inverted)
+				packed[index >> 3] |= (1 << (index & 7));
+			StoreLines<Bit, Line + 1, Rest...>::run(packed);
+		}
+	};
+
+	template<uint8_t Bit, uint8_t Line>
+	struct StoreLines<Bit, Line>
+	{
+		template<typename Port>
+		static SR_ALWAYS_INLINE void run(Port, unsigned char[]) {}
+		static SR_ALWAYS_INLINE void run(unsigned char[]) {}
+	};
+
+	template<uint8_t Bit>
+	static SR_ALWAYS_INLINE void store(unsigned char packed[])
+	{
+#if defined(PIND_SNAPSHOT)
+		auto pins = PIND_SNAPSHOT();
+		if (Inverted)
+			pins = ~pins;
+		StoreLines<Bit, 0, DataPins...>::run(pins, packed);
+#else
+		StoreLines<Bit, 0, DataPins...>::run(packed);
+#endif
+	}
+};
+
+#endif
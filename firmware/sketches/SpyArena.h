@@ -0,0 +1,114 @@
+//
+// SpyArena.h
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SpyArena_h
+#define SpyArena_h
+
+#include "ControllerSpy.h"
+
+#if defined(__AVR__)
+#include <new.h>
+#else
+#include <new>
+#endif
+
+// Size and alignment of the largest spy in a list, worked out by the compiler.
+template<typename... Spies>
+struct SpyArenaLayout;
+
+template<typename Spy>
+struct SpyArenaLayout<Spy>
+{
+	static const size_t size = sizeof(Spy);
+	static const size_t align = alignof(Spy);
+};
+
+template<typename Spy, typename... Rest>
+struct SpyArenaLayout<Spy, Rest...>
+{
+	static const size_t size = sizeof(Spy) > SpyArenaLayout<Rest...>::size ? sizeof(Spy) : SpyArenaLayout<Rest...>::size;
+	static const size_t align = alignof(Spy) > SpyArenaLayout<Rest...>::align ? alignof(Spy) : SpyArenaLayout<Rest...>::align;
+};
+
+// Statically allocated home for the active spy.  The storage lives in .bss,
+// so its size shows up in the linker's RAM usage instead of being carved out
+// of the heap at runtime.  Only one spy exists at a time; creating a new one
+// destroys the previous one first, which keeps runtime mode switching clean.
+template<typename... Spies>
+class SpyArena {
+public:
+	typedef SpyArenaLayout<Spies...> Layout;
+
+	SpyArena() : current(NULL), destroyCurrent(NULL) {}
+
+	template<typename T, typename... CtorArgs>
+	T* create(CtorArgs... args)
+	{
+		static_assert(sizeof(T) <= Layout::size, "Spy does not fit in the arena, add it to the arena's spy list");
+		static_assert(alignof(T) <= Layout::align, "Spy alignment exceeds the arena's alignment");
+
+		destroy();
+		T* spy = new (storage) T(args...);
+		current = spy;
+		destroyCurrent = &destroySpy<T>;
+		return spy;
+	}
+
+	// Constructs the spy and runs its mode specific setup (cable type, video
+	// mode, etc.) in one step.  The caller must not call setup() again.
+	template<typename T, typename... SetupArgs>
+	T* createWithSetup(SetupArgs... args)
+	{
+		T* spy = create<T>();
+		spy->setup(args...);
+		return spy;
+	}
+
+	void destroy()
+	{
+		if (destroyCurrent != NULL)
+			destroyCurrent(storage);
+		current = NULL;
+		destroyCurrent = NULL;
+	}
+
+	ControllerSpy* get() const { return current; }
+
+	static size_t capacity() { return Layout::size; }
+
+private:
+	template<typename T>
+	static void destroySpy(void* p)
+	{
+		static_cast<T*>(p)->~T();
+	}
+
+	alignas(Layout::align) unsigned char storage[Layout::size];
+	ControllerSpy* current;
+	void (*destroyCurrent)(void*);
+};
+
+#endif
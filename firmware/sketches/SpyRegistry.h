@@ -0,0 +1,183 @@
+//
+// SpyRegistry.h
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SpyRegistry_h
+#define SpyRegistry_h
+
+#include "SpyArena.h"
+
+// A spy that needs no arguments.
+template<uint8_t Id, typename Spy>
+struct SpyMode
+{
+	typedef Spy SpyType;
+	static const uint8_t id = Id;
+
+	template<typename Arena>
+	static ControllerSpy* create(Arena& arena, bool&)
+	{
+		return arena.template create<Spy>();
+	}
+};
+
+// A spy configured through setup(...), e.g. cable type or video mode.
+template<uint8_t Id, typename Spy, int... SetupArgs>
+struct SpyModeWithSetup
+{
+	typedef Spy SpyType;
+	static const uint8_t id = Id;
+
+	template<typename Arena>
+	static ControllerSpy* create(Arena& arena, bool& customSetup)
+	{
+		customSetup = true;
+		return arena.template createWithSetup<Spy>(SetupArgs...);
+	}
+};
+
+// A spy configured through its constructor, e.g. the CD-i timeouts.
+template<uint8_t Id, typename Spy, int... CtorArgs>
+struct SpyModeWithArgs
+{
+	typedef Spy SpyType;
+	static const uint8_t id = Id;
+
+	template<typename Arena>
+	static ControllerSpy* create(Arena& arena, bool&)
+	{
+		return arena.template create<Spy>(CtorArgs...);
+	}
+};
+
+// Placeholder for configurations that select no spy at all.  It never gets
+// constructed, it only keeps the registry well formed.
+struct SpyModeNone
+{
+	class SpyType final : public ControllerSpy {
+	public:
+		void loop() {}
+		void writeSerial() {}
+		void debugSerial() {}
+		void updateState() {}
+	};
+	static const uint8_t id = 0xFF;
+
+	template<typename Arena>
+	static ControllerSpy* create(Arena&, bool&)
+	{
+		return NULL;
+	}
+};
+
+template<typename... Modes>
+struct SpyModeTable;
+
+template<>
+struct SpyModeTable<>
+{
+	template<typename Arena>
+	static ControllerSpy* create(Arena&, uint8_t, bool&)
+	{
+		return NULL;
+	}
+};
+
+template<typename Mode, typename... Rest>
+struct SpyModeTable<Mode, Rest...>
+{
+	template<typename Arena>
+	static ControllerSpy* create(Arena& arena, uint8_t id, bool& customSetup)
+	{
+		if (id == Mode::id)
+			return Mode::create(arena, customSetup);
+		return SpyModeTable<Rest...>::create(arena, id, customSetup);
+	}
+};
+
+// endSpyPass() runs after every pass through the spy's loop(), so every mode
+// counts its polls and answers host commands whether or not it sends through
+// the output governor.  Spies that send from loop1() on the Pico answer them
+// from loop1() instead, so replies never interleave with frames written by
+// the other core.  Spies that read Serial themselves never get host
+// commands, two readers would split each other's input.
+//
+// The set of spies a configuration can run.  The arena is sized for the
+// largest of them and only these spies are referenced, so nothing else gets
+// linked.  When the mode is picked at runtime the hot loop still goes through
+// the vtable once per call into the spy; inside the spy the calls are direct
+// since every spy class is final.
+template<typename... Modes>
+class SpyRegistry {
+public:
+	typedef SpyArena<typename Modes::SpyType...> Arena;
+
+	static ControllerSpy* create(Arena& arena, uint8_t id, bool& customSetup)
+	{
+		return SpyModeTable<Modes...>::create(arena, id, customSetup);
+	}
+
+	static void setup1(ControllerSpy* spy) { spy->setup1(); }
+	static void loop(ControllerSpy* spy)
+	{
+		spy->loop();
+		endSpyPass(!spy->sendsFromLoop1() && !spy->readsSerial());
+	}
+	static void loop1(ControllerSpy* spy)
+	{
+		spy->loop1();
+		if (spy->sendsFromLoop1() && !spy->readsSerial())
+			pollHostCommands();
+	}
+};
+
+// Single spy builds know the concrete type at compile time, so calls bind
+// statically and the vtable is never consulted.
+template<typename Mode>
+class SpyRegistry<Mode> {
+public:
+	typedef typename Mode::SpyType Spy;
+	typedef SpyArena<Spy> Arena;
+
+	static ControllerSpy* create(Arena& arena, uint8_t, bool& customSetup)
+	{
+		return Mode::create(arena, customSetup);
+	}
+
+	static void setup1(ControllerSpy* spy) { static_cast<Spy*>(spy)->setup1(); }
+	static void loop(ControllerSpy* spy)
+	{
+		static_cast<Spy*>(spy)->loop();
+		endSpyPass(!static_cast<Spy*>(spy)->sendsFromLoop1() && !static_cast<Spy*>(spy)->readsSerial());
+	}
+	static void loop1(ControllerSpy* spy)
+	{
+		static_cast<Spy*>(spy)->loop1();
+		if (static_cast<Spy*>(spy)->sendsFromLoop1() && !static_cast<Spy*>(spy)->readsSerial())
+			pollHostCommands();
+	}
+};
+
+#endif
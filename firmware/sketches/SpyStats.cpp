@@ -0,0 +1,167 @@
+//
+// SpyStats.cpp
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "SpyStats.h"
+#include "OutputGovernor.h"
+
+SpyStats spyStats;
+
+SpyStats::SpyStats()
+	: polls(0)
+	, syncFailures(0)
+	, maxMasked(0)
+	, serialQueued(0)
+	, serialStalls(0)
+	, maskedSince(0)
+	, isMasked(false)
+	, serialCapacity(0)
+#if defined(PROFILE_IRQ)
+	, site(NULL)
+	, sites(NULL)
+#endif
+{
+#if defined(__arm__) && defined(CORE_TEENSY)
+	// Teensy 4 starts with the cycle counter running, Teensy 3 does not.
+	ARM_DEMCR |= ARM_DEMCR_TRCENA;
+	ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+#endif
+}
+
+// The transmit buffer's size is not exposed, so the most free space ever
+// seen stands in for it.
+void SpyStats::sampleSerial(uint16_t frameLength)
+{
+	int available = Serial.availableForWrite();
+	if (available > serialCapacity)
+		serialCapacity = available;
+	if (serialCapacity - available > serialQueued)
+		serialQueued = serialCapacity - available;
+	if (available < frameLength)
+		++serialStalls;
+}
+
+void SpyStats::printStats()
+{
+	Serial.print("// Polls: ");
+	Serial.print(polls);
+	Serial.print(" Sent: ");
+	Serial.print(outputGovernor.sent);
+	Serial.print(" Coalesced: ");
+	Serial.print(outputGovernor.coalesced);
+	Serial.print(" Dropped: ");
+	Serial.print(outputGovernor.dropped);
+	Serial.print(" Sync failures: ");
+	Serial.print(syncFailures);
+	Serial.print(" Max masked: ");
+	Serial.print(maxMasked / SPY_STATS_TICKS_PER_US);
+	Serial.print("us Serial queued: ");
+	Serial.print(serialQueued);
+	Serial.print(" Serial stalls: ");
+	Serial.println(serialStalls);
+}
+
+#if defined(PROFILE_IRQ)
+
+void SpyStats::profile(uint32_t ticks)
+{
+	uint32_t us = ticks / SPY_STATS_TICKS_PER_US;
+	uint8_t bin = 0;
+	while (us != 0 && bin < IRQ_PROFILE_BINS - 1)
+	{
+		us >>= 1;
+		++bin;
+	}
+
+	++site->count;
+	++site->bins[bin];
+	if (ticks > site->maxTicks)
+		site->maxTicks = ticks;
+	site = NULL;
+}
+
+// One line per site, "// IRQ <file>:<line> Count: <n> Max: <us>us Bins:"
+// and the sixteen bin counts.
+void SpyStats::printProfile()
+{
+	for (const IrqSite* s = sites; s != NULL; s = s->next)
+	{
+		const char* file = strrchr(s->file, '/');
+		if (file == NULL)
+			file = strrchr(s->file, '\\');
+		file = file != NULL ? file + 1 : s->file;
+
+		Serial.print("// IRQ ");
+		Serial.print(file);
+		Serial.print(":");
+		Serial.print(s->line);
+		Serial.print(" Count: ");
+		Serial.print(s->count);
+		Serial.print(" Max: ");
+		Serial.print(s->maxTicks / SPY_STATS_TICKS_PER_US);
+		Serial.print("us Bins:");
+		for (uint8_t i = 0; i < IRQ_PROFILE_BINS; ++i)
+		{
+			Serial.print(" ");
+			Serial.print(s->bins[i]);
+		}
+		Serial.println();
+	}
+}
+
+void SpyStats::clearProfile()
+{
+	for (IrqSite* s = sites; s != NULL; s = s->next)
+	{
+		s->count = 0;
+		s->maxTicks = 0;
+		memset(s->bins, 0, sizeof(s->bins));
+	}
+}
+
+#else
+
+void SpyStats::printProfile()
+{
+	Serial.println("// IRQ profiling is not built in, define PROFILE_IRQ in common.h");
+}
+
+void SpyStats::clearProfile()
+{
+}
+
+#endif
+
+void SpyStats::clear()
+{
+	polls = 0;
+	syncFailures = 0;
+	maxMasked = 0;
+	serialQueued = 0;
+	serialStalls = 0;
+	outputGovernor.sent = 0;
+	outputGovernor.coalesced = 0;
+	outputGovernor.dropped = 0;
+}
@@ -0,0 +1,173 @@
+//
+// SpyStats.h
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SpyStats_h
+#define SpyStats_h
+
+#include "common.h"
+
+// Time source for the counters.  Teensy has the DWT cycle counter, the
+// RP2040's M0+ cores have none so the Pico uses its 1 MHz system timer, the
+// rest fall back on micros().  On AVR micros() stops advancing with
+// interrupts off, so windows longer than a millisecond or two read short.
+#if defined(__arm__) && defined(CORE_TEENSY)
+#define SPY_STATS_TICKS() ARM_DWT_CYCCNT
+#define SPY_STATS_TICKS_PER_US (F_CPU / 1000000)
+#elif defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
+#include <hardware/timer.h>
+#define SPY_STATS_TICKS() time_us_32()
+#define SPY_STATS_TICKS_PER_US 1
+#else
+#define SPY_STATS_TICKS() micros()
+#define SPY_STATS_TICKS_PER_US 1
+#endif
+
+// Counters for diagnosing a spy in the field, reported by the S host
+// command together with the output governor's.
+//
+//     polls          - passes through the spy's loop(), one poll each for
+//                      nearly every spy
+//     syncFailures   - captures abandoned part way, because the bus did not
+//                      look like the start of a poll or the frame failed
+//                      its checks
+//     maxMasked      - longest stretch with interrupts off, in ticks
+//     serialQueued   - most bytes found still waiting in the serial transmit
+//                      buffer when a new frame was ready
+//     serialStalls   - frames that found too little room in the transmit
+//                      buffer and had to wait for it to drain
+//
+// Spies disable interrupts with SPY_NO_INTERRUPTS() and SPY_INTERRUPTS()
+// so the window is timed.  Re-enabling interrupts that were not disabled
+// through the macro is harmless and not counted.
+//
+// With PROFILE_IRQ every SPY_NO_INTERRUPTS() also gets an IrqSite, and the
+// window that follows is added to that site's histogram.
+#if defined(PROFILE_IRQ)
+
+#if defined(__AVR__)
+#error "PROFILE_IRQ needs more RAM than AVR boards have"
+#endif
+
+// Bin 0 counts windows under 1 us, bin n those from 2^(n-1) us up to
+// 2^n us, the last bin everything longer.
+#define IRQ_PROFILE_BINS 16
+
+struct IrqSite {
+	const char* file;
+	uint16_t line;
+	bool listed;
+	IrqSite* next;
+	uint32_t count;
+	uint32_t maxTicks;
+	uint32_t bins[IRQ_PROFILE_BINS];
+};
+
+#endif
+
+class SpyStats {
+public:
+	SpyStats();
+
+	inline void masked()
+	{
+		maskedSince = SPY_STATS_TICKS();
+		isMasked = true;
+	}
+
+	inline void unmasked()
+	{
+		if (isMasked)
+		{
+			uint32_t ticks = SPY_STATS_TICKS() - maskedSince;
+			if (ticks > maxMasked)
+				maxMasked = ticks;
+			isMasked = false;
+#if defined(PROFILE_IRQ)
+			if (site != NULL)
+				profile(ticks);
+#endif
+		}
+	}
+
+#if defined(PROFILE_IRQ)
+	inline void masked(IrqSite* at)
+	{
+		if (!at->listed)
+		{
+			at->listed = true;
+			at->next = sites;
+			sites = at;
+		}
+		site = at;
+		masked();
+	}
+
+	// Sites in the order they were first reached, latest first.
+	const IrqSite* profiledSites() const { return sites; }
+#endif
+
+	// Reports every site's histogram, or that profiling is not built in.
+	void printProfile();
+	void clearProfile();
+
+	inline void syncFailure() { ++syncFailures; }
+
+	// Notes how full the transmit buffer is, before writing frameLength
+	// more bytes.
+	void sampleSerial(uint16_t frameLength);
+
+	void printStats();
+	void clear();
+
+	uint32_t polls;
+	uint32_t syncFailures;
+	uint32_t maxMasked;
+	uint16_t serialQueued;
+	uint32_t serialStalls;
+
+private:
+	uint32_t maskedSince;
+	bool isMasked;
+	int serialCapacity;
+
+#if defined(PROFILE_IRQ)
+	void profile(uint32_t ticks);
+
+	IrqSite* site;
+	IrqSite* sites;
+#endif
+};
+
+extern SpyStats spyStats;
+
+#if defined(PROFILE_IRQ)
+#define SPY_NO_INTERRUPTS() do { static IrqSite irqSite = { __FILE__, __LINE__ }; noInterrupts(); spyStats.masked(&irqSite); } while (0)
+#else
+#define SPY_NO_INTERRUPTS() do { noInterrupts(); spyStats.masked(); } while (0)
+#endif
+#define SPY_INTERRUPTS() do { spyStats.unmasked(); interrupts(); } while (0)
+
+#endif
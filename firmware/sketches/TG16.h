@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class TG16Spy : public ControllerSpy {
+class TG16Spy final : public ControllerSpy {
 public:
 	void loop();
 	void writeSerial();
@@ -25,9 +25,29 @@
 // THE SOFTWARE.
 
 #include "ThreeDO.h"
+#include "ShiftRegisterCapture.h"
 
 #if !(defined(__arm__) && defined(CORE_TEENSY)) && !defined(ARDUINO_AVR_NANO_EVERY) && !defined(ESP_PLATFORM)
 
+typedef ShiftRegisterCapture<LeadingEdge<ThreeDO_CLOCK>, false, ThreeDO_BITCOUNT, ThreeDO_DATA> ThreeDOCapture;
+typedef ShiftRegisterCapture<LeadingEdgeB<VIS_ThreeDO_CLOCK>, false, ThreeDO_BITCOUNT, VIS_ThreeDO_DATA> VisionThreeDOCapture;
+
+// The first bit tells us whether a second controller is daisy chained, in
+// which case the frame is 32 bits long instead of 16.
+template<typename Capture>
+static unsigned char captureThreeDO(unsigned char packed[])
+{
+	Capture::template clockIn<0, 1>(packed);
+	if (packedBit(packed, 0))
+	{
+		Capture::template clockIn<1, ThreeDO_BITCOUNT - 1>(packed);
+		return ThreeDO_BITCOUNT;
+	}
+
+	Capture::template clockIn<1, ThreeDO_BITCOUNT / 2 - 1>(packed);
+	return ThreeDO_BITCOUNT / 2;
+}
+
 void ThreeDOSpy::setup(uint8_t cableType) {
 	this->cableType = cableType;
 	setup();
@@ -46,9 +66,9 @@ void ThreeDOSpy::setup() {
 }
 
 void ThreeDOSpy::loop() {
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	updateState();
-	interrupts();
+	SPY_INTERRUPTS();
 #if !defined(DEBUG)
 	writeSerial();
 #else
@@ -65,42 +85,15 @@ void ThreeDOSpy::updateState()
 }
 
 void ThreeDOSpy::updateStateLegacy() {
-	
-	unsigned char *rawDataPtr = rawData;
-
-	unsigned char bits = 0;
+	ThreeDOCapture::clear(rawData.data());
 	WAIT_FALLING_EDGE(ThreeDO_LATCH);
-
-	do {
-		WAIT_LEADING_EDGE(ThreeDO_CLOCK);
-		*rawDataPtr = PIN_READ(ThreeDO_DATA);
-
-		if (bits == 0 && *rawDataPtr != 0)
-			bytesToReturn = bits = 32;
-		else if (bits == 0)
-			bytesToReturn = bits = 16;
-
-		++rawDataPtr;
-	} while (--bits > 0);
+	bytesToReturn = captureThreeDO<ThreeDOCapture>(rawData.data());
 }
 
 void ThreeDOSpy::updateStateVision() {
-	unsigned char *rawDataPtr = rawData;
-
-	unsigned char bits = 0;
+	VisionThreeDOCapture::clear(rawData.data());
 	WAIT_FALLING_EDGE(VIS_ThreeDO_LATCH);
-
-	do {
-		WAIT_LEADING_EDGEB(VIS_ThreeDO_CLOCK);
-		*rawDataPtr = PIN_READ(VIS_ThreeDO_DATA);
-
-		if (bits == 0 && *rawDataPtr != 0)
-			bytesToReturn = bits = 32;
-		else if (bits == 0)
-			bytesToReturn = bits = 16;
-
-		++rawDataPtr;
-	} while (--bits > 0);
+	bytesToReturn = captureThreeDO<VisionThreeDOCapture>(rawData.data());
 }
 
 void ThreeDOSpy::writeSerial() {
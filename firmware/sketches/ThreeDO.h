@@ -28,8 +28,9 @@
 #define ThreeDOSpy_h
 
 #include "ControllerSpy.h"
+#include "BitBuffer.h"
 
-class ThreeDOSpy : public ControllerSpy {
+class ThreeDOSpy final : public ControllerSpy {
 public:
 	void setup(uint8_t cableType);
 	void setup();
@@ -52,7 +53,7 @@ private:
 	void updateStateLegacy();
 	void updateStateVision();
 
-	unsigned char rawData[32];
+	BitBuffer<ThreeDO_BITCOUNT> rawData;
 	unsigned char bytesToReturn = 0;
 };
 
@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class VFlashSpy : public ControllerSpy {
+class VFlashSpy final : public ControllerSpy {
 public:
 	void setup();
 	void loop();
@@ -50,9 +50,9 @@ void VSmileSpy::setup() {
 }
 
 void VSmileSpy::loop() {
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	updateState();
-	interrupts();
+	SPY_INTERRUPTS();
 #if !defined(DEBUG)
 	writeSerial();
 #else
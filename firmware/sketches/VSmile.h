@@ -29,7 +29,7 @@
 
 #include "ControllerSpy.h"
 
-class VSmileSpy : public ControllerSpy {
+class VSmileSpy final : public ControllerSpy {
 public:
 	void setup();
 	void loop();
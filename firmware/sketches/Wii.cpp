@@ -94,9 +94,9 @@ void WiiSpy::loop1()
 	
 	
 	last_port = current_port;
-	noInterrupts();
+	SPY_NO_INTERRUPTS();
 	current_port = READ_PINS & (BIT_SCL|BIT_SDA);
-	interrupts();
+	SPY_INTERRUPTS();
 	bool bDataReady = current_port != last_port;
 
 	if (bDataReady)
@@ -35,7 +35,7 @@ typedef uint32_t port_t;
 typedef uint8_t port_t;
 #endif
 
-class WiiSpy : public ControllerSpy {
+class WiiSpy final : public ControllerSpy {
 public:
 	void setup();
 	void setup1();
@@ -25,6 +25,8 @@
 // THE SOFTWARE.
 
 #include "common.h"
+#include "OutputGovernor.h"
+#include "SpyStats.h"
 
 void common_pin_setup()
 {
@@ -76,17 +78,28 @@ void common_pin_setup()
 //     data  = Pin index on Port D where the output data wire is attached.
 //     bits  = Number of bits to read from the controller.
 //  longWait = The NES takes a bit longer between reads to get valid results back.
-void read_shiftRegister_2wire(unsigned char rawData[], unsigned char latch, unsigned char data, unsigned char longWait, unsigned char bits)
+// The result is packed LSB first, the same layout ShiftRegisterCapture produces.
+void read_shiftRegister_2wire(unsigned char packedData[], unsigned char latch, unsigned char data, unsigned char longWait, unsigned char bits)
 {
-	unsigned char *rawDataPtr = rawData;
+	unsigned char *packedPtr = packedData;
+	unsigned char mask = 0x01;
+
+	for (unsigned char i = 0; i < (bits + 7) / 8; ++i)
+		packedData[i] = 0;
 
 	WAIT_FALLING_EDGE(latch);
 
 read_loop:
 
-	// Read the data from the line and store in "rawData"
-	*rawDataPtr = !PIN_READ(data);
-	++rawDataPtr;
+	// Read the data from the line and store in "packedData"
+	if (!PIN_READ(data))
+		*packedPtr |= mask;
+	mask <<= 1;
+	if (mask == 0)
+	{
+		mask = 0x01;
+		++packedPtr;
+	}
 	if (--bits == 0) return;
 
 	// Wait until the next button value is on the data line. ~12us between each.
@@ -112,6 +125,7 @@ read_loop:
 #pragma GCC push_options
 void sendRawData(unsigned char rawControllerData[], unsigned char first, unsigned char count)
 {
+	spyStats.sampleSerial(count + 1);
 	for (unsigned char i = first; i < first + count; i++) {
 		Serial.write(rawControllerData[i] ? ONE : ZERO);
 	}
@@ -119,6 +133,34 @@ void sendRawData(unsigned char rawControllerData[], unsigned char first, unsigne
 }
 #pragma GCC pop_options
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Same as sendRawData, but for bits packed LSB first (see ShiftRegisterCapture.h).
+// The wire format to the host is unchanged.
+void sendPackedData(const unsigned char packedData[], unsigned char first, unsigned char count)
+{
+	spyStats.sampleSerial(count + 1);
+	for (unsigned char i = first; i < first + count; i++) {
+		Serial.write((packedData[i >> 3] & (1 << (i & 7))) ? ONE : ZERO);
+	}
+	Serial.write(SPLIT);
+}
+
+void sendPackedDataDebug(const unsigned char packedData[], unsigned char first, unsigned char count)
+{
+	for (unsigned char i = 0; i < first; i++) {
+		Serial.print((packedData[i >> 3] & (1 << (i & 7))) ? "1" : "0");
+	}
+	Serial.print("|");
+	int j = 0;
+	for (unsigned char i = first; i < first + count; i++) {
+		if (j % 8 == 0 && j != 0)
+			Serial.print("|");
+		Serial.print((packedData[i >> 3] & (1 << (i & 7))) ? "1" : "0");
+		++j;
+	}
+	Serial.println();
+}
+
 void sendRawDataDebug(unsigned char rawControllerData[], unsigned char first, unsigned char count)
 {
 	for (unsigned char i = 0; i < first; i++) {
@@ -170,3 +212,73 @@ int middleOfThree(int a, int b, int c)
 			return b;
 	}
 }
+
+static void runHostCommand(char command, bool hasArgument, uint32_t argument)
+{
+	switch (command)
+	{
+	case 'R':
+		// R<hz> sets the maximum output rate, R on its own reports it.
+		if (hasArgument)
+			outputGovernor.setMaxRate(argument > 0xFFFF ? 0xFFFF : argument);
+		outputGovernor.printStats();
+		break;
+	case 'S':
+		// S reports the spy's counters, S0 reports and then clears them.
+		spyStats.printStats();
+		if (hasArgument && argument == 0)
+			spyStats.clear();
+		break;
+	case 'P':
+		// P reports the interrupts-off histograms, P0 reports and then
+		// clears them.
+		spyStats.printProfile();
+		if (hasArgument && argument == 0)
+			spyStats.clearProfile();
+		break;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Bookkeeping after each pass through a spy's loop(), which for nearly every
+// spy is one poll.  answerHost is false when another core owns the output.
+void endSpyPass(bool answerHost)
+{
+	++spyStats.polls;
+	spyStats.sampleSerial(0);
+	if (answerHost)
+		pollHostCommands();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Host commands are a single letter, an optional decimal argument and a
+// newline, e.g. "R120\n".  Never blocks, partial commands are picked up on
+// the next call.
+void pollHostCommands()
+{
+	static char command = 0;
+	static uint32_t argument = 0;
+	static bool hasArgument = false;
+
+	while (Serial.available() > 0)
+	{
+		int c = Serial.read();
+		if (c == '\n' || c == '\r')
+		{
+			if (command != 0)
+				runHostCommand(command, hasArgument, argument);
+			command = 0;
+			argument = 0;
+			hasArgument = false;
+		}
+		else if (command == 0)
+		{
+			command = (char)c;
+		}
+		else if (c >= '0' && c <= '9')
+		{
+			argument = argument * 10 + (c - '0');
+			hasArgument = true;
+		}
+	}
+}
@@ -26,7 +26,9 @@
 
 #include "Arduino.h"
 
-#if  defined(__arm__) && defined(CORE_TEENSY) && (defined(ARDUINO_TEENSY40) || defined(ARDUINO_TEENSY41))
+#if defined(RS_HOST)
+#include "config_host.h"
+#elif defined(__arm__) && defined(CORE_TEENSY) && (defined(ARDUINO_TEENSY40) || defined(ARDUINO_TEENSY41))
 #include "config_teensy4.h"
 #elif defined(__arm__) && defined(CORE_TEENSY) && defined(ARDUINO_TEENSY35)
 #include "config_teensy.h"
@@ -121,6 +123,11 @@ enum VideoOutputType {
 // Uncomment this for serial debugging output
 //#define DEBUG
 
+// Uncomment this to keep a histogram of every interrupts-off window per
+// call site, reported by the P host command.  Not for AVR boards, the
+// histograms do not fit in their RAM.
+//#define PROFILE_IRQ
+
 #define N64_BITCOUNT		    32
 #define SNES_BITCOUNT       16
 #define SNES_BITCOUNT_EXT   32
@@ -145,8 +152,12 @@ enum VideoOutputType {
 #define SPLIT '\n'  // Use a new-line character to split up the controller state packets.
 
 void common_pin_setup();
-void read_shiftRegister_2wire(unsigned char rawData[], unsigned char latch, unsigned char data, unsigned char longWait, unsigned char bits);
+void read_shiftRegister_2wire(unsigned char packedData[], unsigned char latch, unsigned char data, unsigned char longWait, unsigned char bits);
 void sendRawData(unsigned char rawControllerData[], unsigned char first, unsigned char count);
 void sendRawDataDebug(unsigned char rawControllerData[], unsigned char first, unsigned char count);
+void sendPackedData(const unsigned char packedData[], unsigned char first, unsigned char count);
+void sendPackedDataDebug(const unsigned char packedData[], unsigned char first, unsigned char count);
 int ScaleInteger(float oldValue, float oldMin, float oldMax, float newMin, float newMax);
 int middleOfThree(int a, int b, int c);
+void pollHostCommands();
+void endSpyPass(bool answerHost);
@@ -146,4 +146,8 @@
 #define T_DELAY( ms ) delay(0)
 #define A_DELAY( ms ) delay(ms)
 
+// Frames per second sent to the host, 0 for no limit.  The host can change
+// it at runtime, see OutputGovernor.
+#define OUTPUT_MAX_RATE 0
+
 #define FASTRUN
@@ -141,9 +141,16 @@
 #define READ_PORTD( mask ) ((VPORTD.IN << 2) & mask)
 #define READ_PORTB( mask ) (VPORTA.IN & mask)
 
+// Whole port D in one read, bit n corresponds to PIND_READ(n)
+#define PIND_SNAPSHOT() ((uint8_t)(VPORTD.IN << 2))
+
 #define MICROSECOND_NOPS "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
 
 #define T_DELAY( ms ) delay(0)
 #define A_DELAY( ms ) delay(ms)
 
+// Frames per second sent to the host, 0 for no limit.  The host can change
+// it at runtime, see OutputGovernor.
+#define OUTPUT_MAX_RATE 0
+
 #define FASTRUN
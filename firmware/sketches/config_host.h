@@ -0,0 +1,45 @@
+//
+// config_host.h
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// PC build against utils/hostsim.  The simulator is an Uno whose pins come
+// from a trace, so the pin map and port macros are the Uno's; only the
+// delay loops change.
+
+#ifndef config_host_h
+#define config_host_h
+
+#include "config_arduino.h"
+
+#if !defined(__x86_64__)
+#error "The host build charges simulated time from inline asm and needs an x86-64 host"
+#endif
+
+// One microsecond of simulated time instead of 16 nops.  The spies use this
+// in basic asm statements, hence the single %.
+#undef MICROSECOND_NOPS
+#define MICROSECOND_NOPS "addq $1000, hostsim_clock_ns(%rip)\n"
+
+#endif
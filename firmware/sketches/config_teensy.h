@@ -153,6 +153,9 @@
 #define PINB_READ( pin )  ((READ_PORTB(0xF))&(1<<(pin)))
 #define PINC_READ( pin )  (digitalReadFast(pin))
 
+// Whole port D in one read, bit n corresponds to PIND_READ(n)
+#define PIND_SNAPSHOT() (GPIOD_PDIR)
+
 #define FMTOWNS_MOUSE_STROBE 17
 #define FMTOWNS_MOUSE_BUTTON_1	5
 #define FMTOWNS_MOUSE_BUTTON_2	16
@@ -161,3 +164,7 @@
 
 #define T_DELAY( ms ) delay(ms)
 #define A_DELAY( ms ) delay(0)
+
+// Frames per second sent to the host, 0 for no limit.  The host can change
+// it at runtime, see OutputGovernor.
+#define OUTPUT_MAX_RATE 200
@@ -44,3 +44,7 @@
 
 #define T_DELAY( ms ) delay(ms)
 #define A_DELAY( ms ) delay(0)
+
+// Frames per second sent to the host, 0 for no limit.  The host can change
+// it at runtime, see OutputGovernor.
+#define OUTPUT_MAX_RATE 200
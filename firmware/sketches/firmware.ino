@@ -147,10 +147,282 @@
 #include "VSmile.h"
 #include "VFlash.h"
 
+#include "SpyRegistry.h"
+
 bool CreateSpy();
 
+// Mode table for the selected configuration.  Each supported console is a
+// single line: SpyMode<id, Spy> for spies that need no arguments,
+// SpyModeWithSetup<id, Spy, args...> for spies configured through setup(...)
+// and SpyModeWithArgs<id, Spy, args...> for spies configured through their
+// constructor.  The id is the value returned by SPY_MODE_SELECT().
+#if defined(RS_VISION)
+typedef SpyRegistry<
+	SpyMode<0x00, NESSpy>,
+	SpyMode<0x01, PowerGloveSpy>,
+	SpyMode<0x02, SNESSpy>,
+	SpyMode<0x03, N64Spy>,
+	SpyMode<0x04, GCSpy>,
+	SpyModeWithSetup<0x05, SMSSpy, SMSSpy::CABLE_GENESIS>,
+	SpyModeWithSetup<0x06, SMSPaddleSpy, SMSPaddleSpy::CABLE_GENESIS>,
+	SpyMode<0x07, SMSSportsPadSpy>,
+	SpyMode<0x08, GenesisSpy>,
+	SpyMode<0x09, GenesisMouseSpy>,
+	SpyMode<0x0A, SaturnSpy>,
+	SpyMode<0x0B, Saturn3DSpy>,
+	SpyMode<0x0C, PlayStationSpy>,
+	SpyMode<0x0D, GBASpy>,
+	SpyModeWithSetup<0x0E, BoosterGripSpy, BoosterGripSpy::CABLE_GENESIS>,
+	SpyMode<0x0F, TG16Spy>,
+	SpyMode<0x10, NeoGeoSpy>,
+	SpyModeWithSetup<0x11, ThreeDOSpy, ThreeDOSpy::CABLE_GENESIS>,
+	SpyMode<0x12, IntellivisionSpy>,
+	SpyMode<0x13, JaguarSpy>,
+	SpyMode<0x14, FMTownsSpy>,
+	SpyMode<0x15, PCFXSpy>,
+	SpyMode<0x16, AmigaKeyboardSpy>,
+	SpyModeWithSetup<0x17, AmigaMouseSpy, VIDEO_PAL, AmigaMouseSpy::CABLE_GENESIS>,
+	SpyModeWithSetup<0x18, AmigaMouseSpy, VIDEO_NTSC, AmigaMouseSpy::CABLE_GENESIS>,
+	SpyMode<0x19, CDTVWiredSpy>,
+	SpyModeWithSetup<0x1C, KeyboardControllerSpy, KeyboardControllerSpy::MODE_NORMAL, KeyboardControllerSpy::CABLE_GENESIS>,
+	SpyModeWithSetup<0x1D, KeyboardControllerSpy, KeyboardControllerSpy::MODE_STAR_RAIDERS, KeyboardControllerSpy::CABLE_GENESIS>,
+	SpyModeWithSetup<0x1E, KeyboardControllerSpy, KeyboardControllerSpy::MODE_BIG_BIRD, KeyboardControllerSpy::CABLE_GENESIS>,
+	SpyModeWithSetup<0x1F, DrivingControllerSpy, DrivingControllerSpy::CABLE_GENESIS>,
+	SpyModeWithSetup<0x20, SMSSpy, SMSSpy::CABLE_GX4000>> Spies;
+#define SPY_MODE_SELECT() ReadAnalog()
+#elif defined(RS_VISION_DREAM)
+typedef SpyRegistry<
+	SpyMode<0x00, DreamcastSpy>,
+	SpyMode<0x01, N64Spy>,
+	SpyMode<0x02, GCSpy>,
+	SpyMode<0x03, WiiSpy>,
+	SpyMode<0x04, VFlashSpy>,
+	SpyMode<0x05, VSmileSpy>,
+	SpyMode<0x06, NuonSpy>> Spies;
+#define SPY_MODE_SELECT() ReadAnalog4()
+#elif defined(RS_VISION_CDI)
+typedef SpyRegistry<
+	SpyModeWithArgs<0x00, CDiSpy, CDI_WIRED_TIMEOUT, CDI_WIRELESS_TIMEOUT, CDI_WIRELESS_REMOTE_TIMEOUT, 9>,
+	SpyModeWithArgs<0x01, CDiSpy, CDI_WIRED_TIMEOUT, CDI_WIRELESS_TIMEOUT, CDI_WIRELESS_REMOTE_TIMEOUT, 5>,
+	SpyModeWithArgs<0x02, CDiKeyboardSpy, 9>,
+	SpyModeWithArgs<0x03, CDiKeyboardSpy, 5>,
+	SpyMode<0x04, CDTVWirelessSpy>> Spies;
+#define SPY_MODE_SELECT() ReadAnalog()
+#elif defined(RS_VISION_COLECOVISION)
+typedef SpyRegistry<
+	SpyMode<0x00, ColecoVisionSpy>,
+	SpyModeWithSetup<0x01, ColecoVisionRollerSpy, VIDEO_NTSC>,
+	SpyModeWithSetup<0x02, ColecoVisionRollerSpy, VIDEO_PAL>> Spies;
+#define SPY_MODE_SELECT() ReadAnalog()
+#elif defined(RS_VISION_PIPPIN)
+typedef SpyRegistry<SpyMode<0, PippinSpy>> Spies;
+#define SPY_MODE_SELECT() 0
+#elif defined(RS_VISION_ANALOG_1)
+typedef SpyRegistry<
+	SpyMode<0x00, AtariPaddlesSpy>,
+	SpyModeWithSetup<0x01, AmigaAnalogSpy, false>,
+	SpyModeWithSetup<0x02, Atari5200Spy, false>,
+	SpyMode<0x03, NESSpy>,
+	SpyMode<0x04, PowerGloveSpy>,
+	SpyMode<0x05, SNESSpy>,
+	SpyMode<0x06, N64Spy>,
+	SpyMode<0x07, GCSpy>,
+	SpyModeWithSetup<0x08, SMSSpy, SMSSpy::CABLE_GENESIS>,
+	SpyModeWithSetup<0x09, SMSPaddleSpy, SMSPaddleSpy::CABLE_GENESIS>,
+	SpyMode<0x0A, SMSSportsPadSpy>,
+	SpyMode<0x0B, GenesisSpy>,
+	SpyMode<0x0C, GenesisMouseSpy>,
+	SpyMode<0x0D, SaturnSpy>,
+	SpyMode<0x0E, Saturn3DSpy>,
+	SpyMode<0x0F, PlayStationSpy>,
+	SpyMode<0x10, GBASpy>,
+	SpyModeWithSetup<0x11, BoosterGripSpy, BoosterGripSpy::CABLE_GENESIS>,
+	SpyMode<0x12, TG16Spy>,
+	SpyMode<0x13, NeoGeoSpy>,
+	SpyModeWithSetup<0x14, ThreeDOSpy, ThreeDOSpy::CABLE_GENESIS>,
+	SpyMode<0x16, JaguarSpy>,
+	SpyMode<0x18, PCFXSpy>,
+	SpyModeWithSetup<0x1B, DrivingControllerSpy, DrivingControllerSpy::CABLE_GENESIS>,
+	SpyModeWithSetup<0x1C, SMSSpy, SMSSpy::CABLE_GX4000>,
+	SpyMode<0x1D, IntellivisionSpy>,
+	SpyMode<0x1E, GenesisMouseSpy>> Spies;
+#define SPY_MODE_SELECT() ReadAnalog()
+#elif defined(RS_VISION_ANALOG_2)
+typedef SpyRegistry<
+	SpyMode<0x00, AtariPaddlesSpy>,
+	SpyModeWithSetup<0x01, AmigaAnalogSpy, true>,
+	SpyModeWithSetup<0x02, Atari5200Spy, true>> Spies;
+#define SPY_MODE_SELECT() ReadAnalog()
+#elif defined(RS_VISION_FLEX)
+typedef SpyRegistry<
+	SpyMode<0x00, NESSpy>,
+	SpyMode<0x01, SNESSpy>,
+	SpyMode<0x02, N64Spy>,
+	SpyMode<0x03, GCSpy>,
+	SpyMode<0x04, WiiSpy>,
+	SpyModeWithSetup<0x05, SMSSpy, SMSSpy::CABLE_GENESIS>,
+	SpyMode<0x06, GenesisSpy>,
+	SpyMode<0x07, SaturnSpy>,
+	SpyMode<0x08, Saturn3DSpy>,
+	SpyMode<0x09, Saturn3DSpy>,
+	SpyMode<0x0A, PlayStationSpy>,
+	SpyMode<0x0B, GBASpy>,
+	SpyMode<0x0C, AmigaCd32Spy>,
+	SpyMode<0x0D, FMTownsKeyboardAndMouseSpy>,
+	SpyMode<0x0E, TG16Spy>,
+	SpyMode<0x0F, NeoGeoSpy>,
+	SpyModeWithSetup<0x10, BoosterGripSpy, BoosterGripSpy::CABLE_GENESIS>,
+	SpyMode<0x11, JaguarSpy>,
+	SpyMode<0x12, DreamcastSpy>,
+	SpyMode<0x13, VSmileSpy>,
+	SpyMode<0x14, VFlashSpy>,
+	SpyMode<0x15, FMTownsSpy>,
+	SpyMode<0x16, IntellivisionSpy>,
+	SpyMode<0x17, PCFXSpy>,
+	SpyMode<0x18, PowerGloveSpy>,
+	SpyMode<0x19, ThreeDOSpy>,
+	SpyMode<0x1A, GenesisMouseSpy>,
+	SpyMode<0x1B, AmigaKeyboardSpy>,
+	SpyModeWithSetup<0x1C, SMSSpy, SMSSpy::CABLE_GX4000>,
+	SpyModeWithSetup<0x1D, SMSPaddleSpy, SMSPaddleSpy::CABLE_GENESIS>,
+	SpyMode<0x1E, SMSSportsPadSpy>,
+	SpyModeWithSetup<0x1F, KeyboardControllerSpy, KeyboardControllerSpy::MODE_NORMAL, KeyboardControllerSpy::CABLE_GENESIS>,
+	SpyModeWithSetup<0x20, KeyboardControllerSpy, KeyboardControllerSpy::MODE_STAR_RAIDERS, KeyboardControllerSpy::CABLE_GENESIS>,
+	SpyModeWithSetup<0x21, KeyboardControllerSpy, KeyboardControllerSpy::MODE_BIG_BIRD, KeyboardControllerSpy::CABLE_GENESIS>,
+	SpyMode<0x22, N64Slow>,
+	SpyModeWithSetup<0x23, DrivingControllerSpy, DrivingControllerSpy::CABLE_GENESIS>,
+	SpyModeWithSetup<0x24, AmigaMouseSpy, VIDEO_PAL, AmigaMouseSpy::CABLE_GENESIS>,
+	SpyModeWithSetup<0x25, AmigaMouseSpy, VIDEO_NTSC, AmigaMouseSpy::CABLE_GENESIS>,
+	SpyMode<0x26, CDTVWiredSpy>,
+	SpyMode<0x27, NuonSpy>> Spies;
+#define SPY_MODE_SELECT() ReadAnalog()
+#elif defined(MODE_DETECT)
+typedef SpyRegistry<
+	SpyMode<0, SNESSpy>,
+#if !defined(RASPBERRYPI_PICO)
+	SpyMode<1, N64Spy>,
+	SpyMode<2, GCSpy>,
+#endif
+#if !defined(RASPBERRYPI_PICO) && !defined(ARDUINO_RASPBERRY_PI_PICO)
+	SpyMode<5, NESSpy>,
+#endif
+#if defined(__arm__) && defined(CORE_TEENSY)
+	SpyMode<3, DreamcastSpy>,
+#endif
+#if (defined(__arm__) && defined(CORE_TEENSY)) || defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
+	SpyMode<4, WiiSpy>,
+#endif
+	SpyModeNone> Spies;
+#define SPY_MODE_SELECT() DetectMode()
+#elif defined(MODE_NES)
+typedef SpyRegistry<SpyMode<0, NESSpy>> Spies;
+#elif defined(MODE_POWERGLOVE)
+typedef SpyRegistry<SpyMode<0, PowerGloveSpy>> Spies;
+#elif defined(MODE_SNES)
+typedef SpyRegistry<SpyMode<0, SNESSpy>> Spies;
+#elif defined(MODE_N64)
+typedef SpyRegistry<SpyMode<0, N64Spy>> Spies;
+#elif defined(MODE_GC)
+typedef SpyRegistry<SpyMode<0, GCSpy>> Spies;
+#elif defined(MODE_GBA)
+typedef SpyRegistry<SpyMode<0, GBASpy>> Spies;
+#elif defined(MODE_BOOSTER_GRIP)
+typedef SpyRegistry<SpyMode<0, BoosterGripSpy>> Spies;
+#elif defined(MODE_GENESIS)
+typedef SpyRegistry<SpyMode<0, GenesisSpy>> Spies;
+#elif defined(MODE_GENESIS_MOUSE)
+typedef SpyRegistry<SpyMode<0, GenesisMouseSpy>> Spies;
+#elif defined(MODE_SMS)
+typedef SpyRegistry<SpyMode<0, SMSSpy>> Spies;
+#elif defined(MODE_SMS_PADDLE)
+typedef SpyRegistry<SpyMode<0, SMSPaddleSpy>> Spies;
+#elif defined(MODE_SMS_SPORTS_PAD)
+typedef SpyRegistry<SpyMode<0, SMSSportsPadSpy>> Spies;
+#elif defined(MODE_SMS_ON_GENESIS)
+typedef SpyRegistry<SpyModeWithSetup<0, SMSSpy, SMSSpy::CABLE_GENESIS, SMSSpy::OUTPUT_GENESIS>> Spies;
+#elif defined(MODE_SATURN)
+typedef SpyRegistry<SpyMode<0, SaturnSpy>> Spies;
+#elif defined(MODE_SATURN3D)
+typedef SpyRegistry<SpyMode<0, Saturn3DSpy>> Spies;
+#elif defined(MODE_COLECOVISION)
+typedef SpyRegistry<SpyMode<0, ColecoVisionSpy>> Spies;
+#elif defined(MODE_FMTOWNS)
+typedef SpyRegistry<SpyMode<0, FMTownsSpy>> Spies;
+#elif defined(MODE_INTELLIVISION)
+typedef SpyRegistry<SpyMode<0, IntellivisionSpy>> Spies;
+#elif defined(MODE_JAGUAR)
+typedef SpyRegistry<SpyMode<0, JaguarSpy>> Spies;
+#elif defined(MODE_NEOGEO)
+typedef SpyRegistry<SpyMode<0, NeoGeoSpy>> Spies;
+#elif defined(MODE_PCFX)
+typedef SpyRegistry<SpyMode<0, PCFXSpy>> Spies;
+#elif defined(MODE_PLAYSTATION)
+typedef SpyRegistry<SpyMode<0, PlayStationSpy>> Spies;
+#elif defined(MODE_TG16)
+typedef SpyRegistry<SpyMode<0, TG16Spy>> Spies;
+#elif defined(MODE_3DO)
+typedef SpyRegistry<SpyMode<0, ThreeDOSpy>> Spies;
+#elif defined(MODE_DREAMCAST)
+typedef SpyRegistry<SpyMode<0, DreamcastSpy>> Spies;
+#elif defined(MODE_WII)
+typedef SpyRegistry<SpyMode<0, WiiSpy>> Spies;
+#elif defined(MODE_CD32)
+typedef SpyRegistry<SpyMode<0, AmigaCd32Spy>> Spies;
+#elif defined(MODE_DRIVING_CONTROLLER)
+typedef SpyRegistry<SpyMode<0, DrivingControllerSpy>> Spies;
+#elif defined(MODE_PIPPIN)
+typedef SpyRegistry<SpyModeWithSetup<0, PippinSpy, PIPPIN_CONTROLLER_SPY_ADDRESS, PIPPIN_MOUSE_SPY_ADDRESS>> Spies;
+#elif defined(MODE_AMIGA_KEYBOARD)
+typedef SpyRegistry<SpyMode<0, AmigaKeyboardSpy>> Spies;
+#elif defined(MODE_AMIGA_MOUSE)
+typedef SpyRegistry<SpyModeWithSetup<0, AmigaMouseSpy, VIDEO_OUTPUT>> Spies;
+#elif defined(MODE_CDTV_WIRED)
+typedef SpyRegistry<SpyMode<0, CDTVWiredSpy>> Spies;
+#elif defined(MODE_CDTV_WIRELESS)
+typedef SpyRegistry<SpyMode<0, CDTVWirelessSpy>> Spies;
+#elif defined(MODE_FMTOWNS_KEYBOARD_AND_MOUSE)
+typedef SpyRegistry<SpyMode<0, FMTownsKeyboardAndMouseSpy>> Spies;
+#elif defined(MODE_CDI)
+typedef SpyRegistry<SpyModeWithArgs<0, CDiSpy, CDI_WIRED_TIMEOUT, CDI_WIRELESS_TIMEOUT, CDI_WIRELESS_REMOTE_TIMEOUT, 0xFF>> Spies;
+#elif defined(MODE_CDI_KEYBOARD)
+typedef SpyRegistry<SpyMode<0, CDiKeyboardSpy>> Spies;
+#elif defined(MODE_GAMEBOY_PRINTER) || defined(RS_PIXEL_2)
+typedef SpyRegistry<SpyMode<0, GameBoyPrinterEmulator>> Spies;
+#elif defined(MODE_AMIGA_ANALOG_1)
+typedef SpyRegistry<SpyModeWithSetup<0, AmigaAnalogSpy, false>> Spies;
+#elif defined(MODE_AMIGA_ANALOG_2)
+typedef SpyRegistry<SpyModeWithSetup<0, AmigaAnalogSpy, true>> Spies;
+#elif defined(MODE_ATARI5200_1)
+typedef SpyRegistry<SpyModeWithSetup<0, Atari5200Spy, false>> Spies;
+#elif defined(MODE_ATARI5200_2)
+typedef SpyRegistry<SpyModeWithSetup<0, Atari5200Spy, true>> Spies;
+#elif defined(MODE_COLECOVISION_ROLLER)
+typedef SpyRegistry<SpyModeWithSetup<0, ColecoVisionRollerSpy, VIDEO_OUTPUT>> Spies;
+#elif defined(MODE_ATARI_PADDLES)
+typedef SpyRegistry<SpyMode<0, AtariPaddlesSpy>> Spies;
+#elif defined(MODE_NUON)
+typedef SpyRegistry<SpyMode<0, NuonSpy>> Spies;
+#elif defined(MODE_VSMILE)
+typedef SpyRegistry<SpyMode<0, VSmileSpy>> Spies;
+#elif defined(MODE_VFLASH)
+typedef SpyRegistry<SpyMode<0, VFlashSpy>> Spies;
+#elif defined(MODE_KEYBOARD_CONTROLLER)
+typedef SpyRegistry<SpyModeWithSetup<0, KeyboardControllerSpy, KeyboardControllerSpy::MODE_NORMAL>> Spies;
+#elif defined(MODE_KEYBOARD_CONTROLLER_STAR_RAIDERS)
+typedef SpyRegistry<SpyModeWithSetup<0, KeyboardControllerSpy, KeyboardControllerSpy::MODE_STAR_RAIDERS>> Spies;
+#elif defined(MODE_KEYBOARD_CONTROLLER_BIG_BIRD)
+typedef SpyRegistry<SpyModeWithSetup<0, KeyboardControllerSpy, KeyboardControllerSpy::MODE_BIG_BIRD, KeyboardControllerSpy::CABLE_GENESIS>> Spies;
+#else
+typedef SpyRegistry<SpyModeNone> Spies;
+#endif
+
+#if !defined(SPY_MODE_SELECT)
+#define SPY_MODE_SELECT() 0
+#endif
+
+static Spies::Arena spyArena;
+
 ControllerSpy* currentSpy = NULL;
-bool muteStartupMessage;
 
 #ifdef VISION_ANALOG_ADC_INT_HANDLER
 extern byte adcint_mode;
@@ -160,8 +432,6 @@ extern byte adcint_mode;
 // General initialization, just sets all pins to input and starts serial communication.
 void setup()
 {
-	muteStartupMessage = false;
-	
 	// FOR MODE DETECTION
 #if defined(RS_VISION_DREAM)
 	for (int i = 13; i <= 18; ++i)
@@ -205,7 +475,7 @@ void setup()
 		currentSpy->setup();
 	}
 
-	if (!muteStartupMessage && currentSpy != NULL)
+	if (currentSpy != NULL)
 	{
 		currentSpy->printFirmwareInfo();
 	}
@@ -225,7 +495,7 @@ void setup1()
 	while (*p == NULL)
 	{
 	}
-	currentSpy->setup1();
+	Spies::setup1(currentSpy);
 }
 #endif
 
@@ -234,14 +504,14 @@ void setup1()
 void loop()
 {
 	if (currentSpy != NULL)
-		currentSpy->loop();
+		Spies::loop(currentSpy);
 }
 
 #if defined(RASPBERRYPI_PICO)  || defined(ARDUINO_RASPBERRY_PI_PICO)
 void loop1()
 {
 	if (currentSpy != NULL)
-		currentSpy->loop1();
+		Spies::loop1(currentSpy);
 }
 #endif
 
@@ -320,609 +590,52 @@ byte ReadDigital()
 }
 #endif
 
-bool CreateSpy()
+#if defined(MODE_DETECT)
+byte DetectMode()
 {
-	bool customSetup = false;
-#if defined(RS_VISION)
-	switch (ReadAnalog())
-	{
-	case 0x00:
-		currentSpy = new NESSpy();
-		break;
-	case 0x01:
-		currentSpy = new PowerGloveSpy();
-		break;
-	case 0x02:
-		currentSpy = new SNESSpy();
-		break;
-	case 0x03:
-		currentSpy = new N64Spy();
-		break;
-	case 0x04:
-		currentSpy = new GCSpy();
-		break;
-	case 0x05:
-		currentSpy = new SMSSpy();		
-		((SMSSpy*)currentSpy)->setup(SMSSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;	
-	case 0x06:
-		currentSpy = new SMSPaddleSpy();
-		((SMSPaddleSpy*)currentSpy)->setup(SMSPaddleSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x07:
-		currentSpy = new SMSSportsPadSpy();
-		break;
-	case 0x08:
-		currentSpy = new GenesisSpy();
-		break;
-	case 0x09:
-		currentSpy = new GenesisMouseSpy();
-		break;
-	case 0x0A:
-		currentSpy = new SaturnSpy();
-		break;
-	case 0x0B:
-		currentSpy = new Saturn3DSpy();
-		break;
-	case 0x0C:
-		currentSpy = new PlayStationSpy();
-		break;
-	case 0x0D:
-		currentSpy = new GBASpy();
-		break;
-	case 0x0E:
-		currentSpy = new BoosterGripSpy();
-		((BoosterGripSpy*)currentSpy)->setup(BoosterGripSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x0F:
-		currentSpy = new TG16Spy();
-		break;
-	case 0x10:
-		currentSpy = new NeoGeoSpy();
-		break;
-	case 0x11:
-		currentSpy = new ThreeDOSpy();
-		((ThreeDOSpy*)currentSpy)->setup(ThreeDOSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x12:
-		currentSpy = new IntellivisionSpy();
-		break;	
-	case 0x13:
-		currentSpy = new JaguarSpy();
-		break;
-	case 0x14:
-		currentSpy = new FMTownsSpy();
-		break;
-	case 0x15:
-		currentSpy = new PCFXSpy();
-		break;
-	case 0x16:
-		currentSpy = new AmigaKeyboardSpy();
-		break;
-	case 0x17:
-		currentSpy = new AmigaMouseSpy();
-		((AmigaMouseSpy*)currentSpy)->setup(VIDEO_PAL, AmigaMouseSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x18:
-		currentSpy = new AmigaMouseSpy();
-		((AmigaMouseSpy*)currentSpy)->setup(VIDEO_NTSC, AmigaMouseSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x19:
-		currentSpy = new CDTVWiredSpy();
-		muteStartupMessage = true;
-		break;
-	case 0x1C:
-		currentSpy = new KeyboardControllerSpy();
-		((KeyboardControllerSpy*)currentSpy)->setup(KeyboardControllerSpy::MODE_NORMAL, KeyboardControllerSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x1D:
-		currentSpy = new KeyboardControllerSpy();
-		((KeyboardControllerSpy*)currentSpy)->setup(KeyboardControllerSpy::MODE_STAR_RAIDERS, KeyboardControllerSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x1E:
-		currentSpy = new KeyboardControllerSpy();
-		((KeyboardControllerSpy*)currentSpy)->setup(KeyboardControllerSpy::MODE_BIG_BIRD, KeyboardControllerSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x1F:
-		currentSpy = new DrivingControllerSpy();
-		((DrivingControllerSpy*)currentSpy)->setup(DrivingControllerSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;		
-	case 0x20:
-		currentSpy = new SMSSpy();		
-		((SMSSpy*)currentSpy)->setup(SMSSpy::CABLE_GX4000);
-		customSetup = true;
-		break;	
-	}
-#elif defined(RS_VISION_DREAM)
-	switch (ReadAnalog4())
-	{
-	case 0x00:
-		currentSpy = new DreamcastSpy();
-		break;
-	case 0x01:
-		currentSpy = new N64Spy();
-		break;
-	case 0x02:
-		currentSpy = new GCSpy();
-		break;	
-	case 0x03:
-		currentSpy = new WiiSpy();
-		break;
-	case 0x04:
-		currentSpy = new VFlashSpy();
-		break;
-	case 0x05:
-		currentSpy = new VSmileSpy();
-		break;
-	case 0x06:
-		currentSpy = new NuonSpy();
-		break;
-	}
-#elif defined(RS_VISION_CDI)
-	switch (ReadAnalog())
-	{
-	case 0x00:
-		currentSpy = new CDiSpy(CDI_WIRED_TIMEOUT, CDI_WIRELESS_TIMEOUT, CDI_WIRELESS_REMOTE_TIMEOUT, 9);
-		break;
-	case 0x01:
-		currentSpy = new CDiSpy(CDI_WIRED_TIMEOUT, CDI_WIRELESS_TIMEOUT, CDI_WIRELESS_REMOTE_TIMEOUT, 5);
-		break;
-	case 0x02:
-		currentSpy = new CDiKeyboardSpy(9);
-		break;
-	case 0x03:
-		currentSpy = new CDiKeyboardSpy(5);
-		break;
-	case 0x04:
-		currentSpy = new CDTVWirelessSpy();
-		break;
-	}
-#elif defined(RS_VISION_COLECOVISION)
-	switch (ReadAnalog())
-	{
-	case 0x00:
-		currentSpy = new ColecoVisionSpy();
-		break;
-	case 0x01:
-		currentSpy = new ColecoVisionRollerSpy();
-		((ColecoVisionRollerSpy*)currentSpy)->setup(VIDEO_NTSC);
-		customSetup = true;
-		break;	
-	case 0x02:
-		currentSpy = new ColecoVisionRollerSpy();
-		((ColecoVisionRollerSpy*)currentSpy)->setup(VIDEO_PAL);
-		customSetup = true;
-		break;	
-	}
-#elif defined(RS_VISION_PIPPIN)
-	byte switchVal = ReadDigital();
-	byte controllerAddress = (switchVal & 0x0F);
-	byte mouseAddress = ((switchVal & 0xF0) >> 4);
-	
-	if (controllerAddress == mouseAddress && controllerAddress != 0x0F)
-	{
-		controllerAddress = PIPPIN_CONTROLLER_SPY_ADDRESS;
-		mouseAddress = PIPPIN_MOUSE_SPY_ADDRESS;
-	}
-		
-	currentSpy = new PippinSpy();
-	((PippinSpy*)currentSpy)->setup(controllerAddress, mouseAddress);
-	customSetup = true;
-#elif defined(RS_VISION_ANALOG_1)
-	switch (ReadAnalog())
-	{
-	case 0x00:
-		currentSpy = new AtariPaddlesSpy();
-		break;
-	case 0x01:
-		currentSpy = new AmigaAnalogSpy();
-		((AmigaAnalogSpy*)currentSpy)->setup(false);
-		customSetup = true;
-		break;	
-	case 0x02:
-		currentSpy = new Atari5200Spy();
-		((Atari5200Spy*)currentSpy)->setup(false);
-		customSetup = true;
-		break;	
-	case 0x03:
-		currentSpy = new NESSpy();
-		break;
-	case 0x04:
-		currentSpy = new PowerGloveSpy();
-		break;
-	case 0x05:
-		currentSpy = new SNESSpy();
-		break;
-	case 0x06:
-		currentSpy = new N64Spy();
-		break;
-	case 0x07:
-		currentSpy = new GCSpy();
-		break;
-	case 0x08:
-		currentSpy = new SMSSpy();		
-		((SMSSpy*)currentSpy)->setup(SMSSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;	
-	case 0x09:
-		currentSpy = new SMSPaddleSpy();
-		((SMSPaddleSpy*)currentSpy)->setup(SMSPaddleSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x0A:
-		currentSpy = new SMSSportsPadSpy();
-		break;
-	case 0x0B:
-		currentSpy = new GenesisSpy();
-		break;
-	case 0x0C:
-		currentSpy = new GenesisMouseSpy();
-		break;
-	case 0x0D:
-		currentSpy = new SaturnSpy();
-		break;
-	case 0x0E:
-		currentSpy = new Saturn3DSpy();
-		break;
-	case 0x0F:
-		currentSpy = new PlayStationSpy();
-		break;
-	case 0x10:
-		currentSpy = new GBASpy();
-		break;
-	case 0x11:
-		currentSpy = new BoosterGripSpy();
-		((BoosterGripSpy*)currentSpy)->setup(BoosterGripSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x12:
-		currentSpy = new TG16Spy();
-		break;
-	case 0x13:
-		currentSpy = new NeoGeoSpy();
-		break;
-	case 0x14:
-		currentSpy = new ThreeDOSpy();
-		((ThreeDOSpy*)currentSpy)->setup(ThreeDOSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x16:
-		currentSpy = new JaguarSpy();
-		break;
-	case 0x18:
-		currentSpy = new PCFXSpy();
-		break;
-	case 0x1B:
-		currentSpy = new DrivingControllerSpy();
-		((DrivingControllerSpy*)currentSpy)->setup(DrivingControllerSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;		
-	case 0x1C:
-		currentSpy = new SMSSpy();		
-		((SMSSpy*)currentSpy)->setup(SMSSpy::CABLE_GX4000);
-		customSetup = true;
-		break;	
-	case 0x1D:
-		currentSpy = new IntellivisionSpy();
-		break;
-	case 0x1E:
-		currentSpy = new GenesisMouseSpy();
-		break;
-	}
-#elif defined(RS_VISION_ANALOG_2)
-	switch (ReadAnalog())
-	{
-	case 0x00:
-		currentSpy = new AtariPaddlesSpy();
-		break;
-	case 0x01:
-		currentSpy = new AmigaAnalogSpy();
-		((AmigaAnalogSpy*)currentSpy)->setup(true);
-		customSetup = true;
-		break;	
-	case 0x02:
-		currentSpy = new Atari5200Spy();
-		((Atari5200Spy*)currentSpy)->setup(true);
-		customSetup = true;
-		break;	
-	}
-#elif defined(RS_VISION_FLEX)
-	switch (ReadAnalog())
-	{
-	case 0x00:
-		currentSpy = new NESSpy();
-		break;
-	case 0x01:
-		currentSpy = new SNESSpy();
-		break;
-	case 0x02:
-		currentSpy = new N64Spy();
-		break;
-	case 0x03:
-		currentSpy = new GCSpy();
-		break;
-	case 0x04:
-		currentSpy = new WiiSpy();
-		break;	
-	case 0x05:
-		currentSpy = new SMSSpy();		
-		((SMSSpy*)currentSpy)->setup(SMSSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;	
-	case 0x06:
-		currentSpy = new GenesisSpy();
-		break;
-	case 0x07:
-		currentSpy = new SaturnSpy();
-		break;
-	case 0x08:
-		currentSpy = new Saturn3DSpy();
-		break;
-	case 0x09:
-		currentSpy = new Saturn3DSpy();
-		break;
-	case 0x0A:
-		currentSpy = new PlayStationSpy();
-		break;
-	case 0x0B:
-		currentSpy = new GBASpy();
-		break;
-	case 0x0C:
-		currentSpy = new AmigaCd32Spy();
-		break;
-	case 0x0D:
-		currentSpy = new FMTownsKeyboardAndMouseSpy();
-		break;
-	case 0x0E:
-		currentSpy = new TG16Spy();
-		break;
-	case 0x0F:
-		currentSpy = new NeoGeoSpy();
-		break;
-	case 0x10:
-		currentSpy = new BoosterGripSpy();
-		((BoosterGripSpy*)currentSpy)->setup(BoosterGripSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x11:
-		currentSpy = new JaguarSpy();
-		break;
-	case 0x12:
-		currentSpy = new DreamcastSpy();
-		break;
-	case 0x13:
-		currentSpy = new VSmileSpy();
-		break;
-	case 0x14:
-		currentSpy = new VFlashSpy();
-		break;
-	case 0x15:
-		currentSpy = new FMTownsSpy();
-		break;
-	case 0x16:
-		currentSpy = new IntellivisionSpy();
-		break;
-	case 0x17:
-		currentSpy = new PCFXSpy();
-		break;
-	case 0x18:
-		currentSpy = new PowerGloveSpy();
-		break;
-	case 0x19:
-		currentSpy = new ThreeDOSpy();
-		break;
-	case 0x1A:
-		currentSpy = new GenesisMouseSpy();
-		break;
-	case 0x1B:
-		currentSpy = new AmigaKeyboardSpy();
-		break;
-	case 0x1C:
-		currentSpy = new SMSSpy();		
-		((SMSSpy*)currentSpy)->setup(SMSSpy::CABLE_GX4000);
-		customSetup = true;
-		break;
-	case 0x1D:
-		currentSpy = new SMSPaddleSpy();
-		((SMSPaddleSpy*)currentSpy)->setup(SMSPaddleSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x1E:
-		currentSpy = new SMSSportsPadSpy();
-		break;
-	case 0x1F:
-		currentSpy = new KeyboardControllerSpy();
-		((KeyboardControllerSpy*)currentSpy)->setup(KeyboardControllerSpy::MODE_NORMAL, KeyboardControllerSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x20:
-		currentSpy = new KeyboardControllerSpy();
-		((KeyboardControllerSpy*)currentSpy)->setup(KeyboardControllerSpy::MODE_STAR_RAIDERS, KeyboardControllerSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x21:
-		currentSpy = new KeyboardControllerSpy();
-		((KeyboardControllerSpy*)currentSpy)->setup(KeyboardControllerSpy::MODE_BIG_BIRD, KeyboardControllerSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x22:
-		currentSpy = new N64Slow();
-		break;
-	case 0x23:
-		currentSpy = new DrivingControllerSpy();
-		((DrivingControllerSpy*)currentSpy)->setup(DrivingControllerSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x24:
-		currentSpy = new AmigaMouseSpy();
-		((AmigaMouseSpy*)currentSpy)->setup(VIDEO_PAL, AmigaMouseSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x25:
-		currentSpy = new AmigaMouseSpy();
-		((AmigaMouseSpy*)currentSpy)->setup(VIDEO_NTSC, AmigaMouseSpy::CABLE_GENESIS);
-		customSetup = true;
-		break;
-	case 0x26:
-		currentSpy = new CDTVWiredSpy();
-		muteStartupMessage = true;
-		break;
-	case 0x27:
-		currentSpy = new NuonSpy();
-		break;
-	}
-#elif defined(MODE_DETECT)
 	if (!PINC_READ(MODEPIN_SNES))
-		currentSpy = new SNESSpy;
+		return 0;
 #if !defined(RASPBERRYPI_PICO)
 	else if (!PINC_READ(MODEPIN_N64))
-		currentSpy = new N64Spy();
+		return 1;
 	else if (!PINC_READ(MODEPIN_GC))
-		currentSpy = new GCSpy();
+		return 2;
 #endif
 #if defined(__arm__) && defined(CORE_TEENSY)
 	else if (!PINC_READ(MODEPIN_DREAMCAST))
-		currentSpy = new DreamcastSpy();
+		return 3;
 #endif
 #if (defined(__arm__) && defined(CORE_TEENSY)) || defined(RASPBERRYPI_PICO)  || defined(ARDUINO_RASPBERRY_PI_PICO)
 	else if (!PINC_READ(MODEPIN_WII))
-		currentSpy = new WiiSpy();
+		return 4;
 #endif 
 #if !defined(RASPBERRYPI_PICO) && !defined(ARDUINO_RASPBERRY_PI_PICO)
 	else
-		currentSpy = new NESSpy();
+		return 5;
+#else
+	return 0xFF;
 #endif
-#elif defined(MODE_NES)
-	currentSpy = new NESSpy();
-#elif defined(MODE_POWERGLOVE)
-	currentSpy = new PowerGloveSpy();
-#elif defined(MODE_SNES)
-	currentSpy = new SNESSpy();
-#elif defined(MODE_N64)
-	currentSpy = new N64Spy();
-#elif defined(MODE_GC)
-	currentSpy = new GCSpy();
-#elif defined(MODE_GBA)
-	currentSpy = new GBASpy();
-#elif defined(MODE_BOOSTER_GRIP)
-	currentSpy = new BoosterGripSpy();
-#elif defined(MODE_GENESIS)
-	currentSpy = new GenesisSpy();
-#elif defined(MODE_GENESIS_MOUSE)
-	currentSpy = new GenesisMouseSpy();
-#elif defined(MODE_SMS)
-	currentSpy = new SMSSpy();
-#elif defined(MODE_SMS_PADDLE)
-	currentSpy = new SMSPaddleSpy();
-#elif defined(MODE_SMS_SPORTS_PAD)
-	currentSpy = new SMSSportsPadSpy();
-#elif defined(MODE_SMS_ON_GENESIS)
-	currentSpy = new SMSSpy();
-	((SMSSpy*)currentSpy)->setup(SMSSpy::CABLE_GENESIS, SMSSpy::OUTPUT_GENESIS);
-	customSetup = true;
-#elif defined(MODE_SATURN)
-	currentSpy = new SaturnSpy();
-#elif defined(MODE_SATURN3D)
-	currentSpy = new Saturn3DSpy();
-#elif defined(MODE_COLECOVISION)
-	currentSpy = new ColecoVisionSpy();
-#elif defined(MODE_FMTOWNS)
-	currentSpy = new FMTownsSpy();
-#elif defined(MODE_INTELLIVISION)
-	currentSpy = new IntelliVisionSpy();
-#elif defined(MODE_JAGUAR)
-	currentSpy = new JaguarSpy();
-#elif defined(MODE_NEOGEO)
-	currentSpy = new NeoGeoSpy();
-# elif defined(MODE_PCFX)
-	currentSpy = new PCFXSpy();
-#elif  defined(MODE_PLAYSTATION)
-	currentSpy = new PlayStationSpy();
-#elif defined(MODE_TG16)
-	currentSpy = new TG16Spy();
-#elif defined(MODE_3DO)
-	currentSpy = new ThreeDOSpy();
-#elif defined(MODE_DREAMCAST)
-	currentSpy = new DCSpy();
-#elif defined(MODE_WII)
-	currentSpy = new WiiSpy();
-#elif defined(MODE_CD32)
-	currentSpy = new AmigaCd32Spy();
-#elif defined(MODE_DRIVING_CONTROLLER)
-	currentSpy = new DrivingControllerSpy();
-#elif defined(MODE_PIPPIN)
-	currentSpy = new PippinSpy();
-	((PippinSpy*)currentSpy)->setup(PIPPIN_CONTROLLER_SPY_ADDRESS, PIPPIN_MOUSE_SPY_ADDRESS);
-	customSetup = true;
-#elif defined(MODE_AMIGA_KEYBOARD)
-	currentSpy = new AmigaKeyboardSpy();
-#elif defined(MODE_AMIGA_MOUSE)                                            
-	currentSpy = new AmigaMouseSpy();
-	((AmigaMouseSpy*)currentSpy)->setup(VIDEO_OUTPUT);
-	customSetup = true;
-#elif defined(MODE_CDTV_WIRED)
-	currentSpy = new CDTVWiredSpy();
-	muteStartupMessage = true;
-#elif defined(MODE_CDTV_WIRELESS)
-	currentSpy = new CDTVWirelessSpy();
-#elif defined(MODE_FMTOWNS_KEYBOARD_AND_MOUSE)
-	currentSpy = new FMTownsKeyboardAndMouseSpy();
-#elif defined(MODE_CDI)
-	currentSpy = new CDiSpy(CDI_WIRED_TIMEOUT, CDI_WIRELESS_TIMEOUT, CDI_WIRELESS_REMOTE_TIMEOUT, 0xFF);
-#elif defined(MODE_CDI_KEYBOARD)
-	currentSpy = new CDiKeyboardSpy();
-#elif defined(MODE_GAMEBOY_PRINTER) || defined(RS_PIXEL_2)
-	currentSpy = new GameBoyPrinterEmulator();
-#elif defined(MODE_AMIGA_ANALOG_1)
-	currentSpy = new AmigaAnalogSpy();
-	((AmigaAnalogSpy*)currentSpy)->setup(false);
-	customSetup = true;
-#elif defined(MODE_AMIGA_ANALOG_2)
-	currentSpy = new AmigaAnalogSpy();
-	((AmigaAnalogSpy*)currentSpy)->setup(true);
-	customSetup = true;
-#elif defined(MODE_ATARI5200_1) 
-	currentSpy = new Atari5200Spy();
-	((Atari5200Spy*)currentSpy)->setup(false);
-	customSetup = true;
-#elif defined(MODE_ATARI5200_2)
-	currentSpy = new Atari5200Spy();
-	((Atari5200Spy*)currentSpy)->setup(true);
-	customSetup = true;
-#elif defined(MODE_COLECOVISION_ROLLER)                                                  
-	currentSpy = new ColecoVisionRollerSpy();
-	((ColecoVisionRollerSpy*)currentSpy)->setup(VIDEO_OUTPUT);
-	customSetup = true;
-#elif defined(MODE_ATARI_PADDLES)                                                  
-	currentSpy = new AtariPaddlesSpy();
-#elif defined(MODE_NUON)                                                  
-	currentSpy = new NuonSpy();
-#elif defined(MODE_VSMILE)                                                  
-	currentSpy = new VSmileSpy();
-#elif defined(MODE_VFLASH)                                                  
-	currentSpy = new VFlashSpy();
-#elif defined(MODE_KEYBOARD_CONTROLLER) 
-	currentSpy = new KeyboardControllerSpy();
-	((KeyboardControllerSpy*)currentSpy)->setup(KeyboardControllerSpy::MODE_NORMAL);
-	customSetup = true;
-#elif defined(MODE_KEYBOARD_CONTROLLER_STAR_RAIDERS) 
-	currentSpy = new KeyboardControllerSpy();
-	((KeyboardControllerSpy*)currentSpy)->setup(KeyboardControllerSpy::MODE_STAR_RAIDERS);
-	customSetup = true;
-#elif defined(MODE_KEYBOARD_CONTROLLER_BIG_BIRD)
-	currentSpy = new KeyboardControllerSpy();
-	((KeyboardControllerSpy*)currentSpy)->setup(KeyboardControllerSpy::MODE_BIG_BIRD, KeyboardControllerSpy::CABLE_GENESIS);
+}
+#endif
+
+bool CreateSpy()
+{
+	bool customSetup = false;
+#if defined(RS_VISION_PIPPIN)
+	byte switchVal = ReadDigital();
+	byte controllerAddress = (switchVal & 0x0F);
+	byte mouseAddress = ((switchVal & 0xF0) >> 4);
+	
+	if (controllerAddress == mouseAddress && controllerAddress != 0x0F)
+	{
+		controllerAddress = PIPPIN_CONTROLLER_SPY_ADDRESS;
+		mouseAddress = PIPPIN_MOUSE_SPY_ADDRESS;
+	}
+		
+	currentSpy = spyArena.createWithSetup<PippinSpy>(controllerAddress, mouseAddress);
 	customSetup = true;
+#else
+	currentSpy = Spies::create(spyArena, SPY_MODE_SELECT(), customSetup);
 #endif
 	
 	return customSetup;
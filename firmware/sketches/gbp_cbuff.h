@@ -30,120 +30,205 @@
 // Author: Brian Khuu (July 2020) (briankhuu.com) (mofosyne@gmail.com)
 // This Gist (Pointer): https://gist.github.com/mofosyne/d7a4a8d6a567133561c18aaddfd82e6f
 // This Gist (Index): https://gist.github.com/mofosyne/82020d5c0e1e11af0eb9b05c73734956
+//
+// Single producer (serial clock ISR) / single consumer (main loop) ring.
+// Wrapping never divides, which matters on AVR where `%` is a software
+// routine run on every byte.  head is only written by the producer and tail
+// only by the consumer, the item count is derived from the two so there is
+// no shared counter that can lose an update.  With a power of two capacity
+// the indices run freely, wrap at 16 bits and pick their slot with a mask.
+// Any other capacity runs them over twice the capacity and wraps them with a
+// compare, so a full ring still differs from an empty one.
 #include <stdint.h> // uint8_t
 #include <stddef.h> // size_t
 #include <stdbool.h> // bool
+#if defined(__AVR__)
+#include <util/atomic.h>
+#endif
 
-typedef struct gpb_cbuff_t
+/* Index publication */
+// The producer fills a slot then publishes head (release), the consumer loads
+// head (acquire) before reading the slot.  Same for tail in the other
+// direction.  On ARM and ESP32 the builtins emit the required barriers, the
+// ESP32 ISR may even run on the other core.  AVR has no barriers to speak of
+// but a 16 bit access takes two instructions, so the main loop side briefly
+// masks interrupts to keep the ISR from seeing half an index.
+#if defined(__AVR__)
+static inline uint16_t gpb_cbuff_load(const volatile uint16_t *index)
 {
-	size_t capacity; ///< Maximum number of items in the buffer
-	size_t count; ///< Number of items in the buffer
-	uint8_t *buffer; ///< Data Buffer
-	size_t head; ///< Head Index
-	size_t tail; ///< Tail Index
-
-#ifdef FEATURE_CHECKSUM_SUPPORTED
-	  // Temp
-	size_t countTemp; ///< Number of items in the buffer
-	size_t headTemp; ///< Head Index
-#endif // FEATURE_CHECKSUM_SUPPORTED
-} gpb_cbuff_t;
-
-static inline bool gpb_cbuff_Init(gpb_cbuff_t *cb, size_t capacity, uint8_t *buffPtr)
-{
-	gpb_cbuff_t emptyCB = { 0 };
-	if ((cb == NULL) || (buffPtr == NULL))
-		return false; ///< Failed
-	  // Init Struct
-	*cb = emptyCB;
-	cb->capacity = capacity;
-	cb->buffer   = buffPtr;
-	cb->count    = 0;
-	cb->head     = 0;
-	cb->tail     = 0;
-	return true; ///< Successful
+	uint16_t value;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		value = *index;
+	}
+	return value;
 }
 
-static inline bool gpb_cbuff_Reset(gpb_cbuff_t *cb)
+static inline void gpb_cbuff_store(volatile uint16_t *index, uint16_t value)
 {
-	cb->count = 0;
-	cb->head = 0;
-	cb->tail = 0;
-	return true; ///< Successful
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		*index = value;
+	}
 }
-
-static inline bool gpb_cbuff_Enqueue(gpb_cbuff_t *cb, uint8_t b)
+#else
+static inline uint16_t gpb_cbuff_load(const volatile uint16_t *index)
 {
-	// Full
-	if (cb->count >= cb->capacity)
-		return false; ///< Failed
-	  // Push value
-	cb->buffer[cb->head] = b;
-	// Increment head
-	cb->head = (cb->head + 1) % cb->capacity;
-	cb->count = cb->count + 1;
-	return true; ///< Successful
+	return __atomic_load_n(index, __ATOMIC_ACQUIRE);
 }
 
-static inline bool gpb_cbuff_Dequeue(gpb_cbuff_t *cb, uint8_t *b)
+static inline void gpb_cbuff_store(volatile uint16_t *index, uint16_t value)
 {
-	// Empty
-	if (cb->count == 0)
-		return false; ///< Failed
-	  // Pop value
-	*b = cb->buffer[cb->tail];
-	// Increment tail
-	cb->tail = (cb->tail + 1) % cb->capacity;
-	cb->count = cb->count - 1;
-	return true; ///< Successful
+	__atomic_store_n(index, value, __ATOMIC_RELEASE);
 }
+#endif
 
-static inline bool gpb_cbuff_Dequeue_Peek(gpb_cbuff_t *cb, uint8_t *b, uint32_t offset)
+template<uint16_t Capacity>
+class gpb_cbuff_t
 {
-	// Empty
-	if (cb->count == 0)
-		return false; ///< Failed
-	if (cb->count < offset)
-		return false; ///< Failed
-	  // Pop value
-	*b = cb->buffer[(cb->tail + offset) % cb->capacity];
-	return true; ///< Successful
-}
+	static_assert(Capacity > 0 && (Capacity <= 0x7FFF || Capacity == 0x8000), "Capacity must be no larger than 32768");
 
-static inline size_t gpb_cbuff_Capacity(gpb_cbuff_t *cb) { return cb->capacity;}
-static inline size_t gpb_cbuff_Count(gpb_cbuff_t *cb)   { return cb->count;}
-static inline bool gpb_cbuff_IsFull(gpb_cbuff_t *cb)    { return (cb->count >= cb->capacity);}
-static inline bool gpb_cbuff_IsEmpty(gpb_cbuff_t *cb)   { return (cb->count == 0);}
+	static const bool powerOfTwo = (Capacity & (Capacity - 1)) == 0;
 
+	static uint16_t advance(uint16_t index, uint16_t count)
+	{
+		if (powerOfTwo)
+			return index + count;
+		uint32_t next = (uint32_t)index + count;
+		if (next >= 2UL * Capacity)
+			next -= 2UL * Capacity;
+		return next;
+	}
+
+	static uint16_t distance(uint16_t from, uint16_t to)
+	{
+		uint16_t d = to - from;
+		if (!powerOfTwo && to < from)
+			d += 2 * Capacity;
+		return d;
+	}
+
+	static uint16_t slot(uint16_t index)
+	{
+		if (powerOfTwo)
+			return index & (Capacity - 1);
+		return index >= Capacity ? index - Capacity : index;
+	}
+
+public:
+
+	gpb_cbuff_t() : head(0), tail(0)
 #ifdef FEATURE_CHECKSUM_SUPPORTED
-/* Temp Enqeue */
-static inline bool gpb_cbuff_ResetTemp(gpb_cbuff_t *cb)
-{
-	cb->countTemp = 0;
-	cb->headTemp  = cb->head;
-}
+		, headTemp(0)
+#endif
+	{
+	}
 
-static inline bool gpb_cbuff_AcceptTemp(gpb_cbuff_t *cb)
-{
-	cb->count += cb->countTemp;
-	cb->head  = cb->headTemp;
-	return true; ///< Successful
-}
+	/* Producer */
+	bool enqueue(uint8_t b)
+	{
+		// Only the producer writes head, so a plain read is fine here
+		const uint16_t h = head;
+		// Full
+		if (distance(gpb_cbuff_load(&tail), h) >= Capacity)
+			return false; ///< Failed
+		  // Push value then publish it
+		buffer[slot(h)] = b;
+		gpb_cbuff_store(&head, advance(h, 1));
+		return true; ///< Successful
+	}
 
-static inline bool gpb_cbuff_EnqueueTemp(gpb_cbuff_t *cb, uint8_t b)
-{
-	// Full
-	if (cb->countTemp >= (cb->capacity - cb->count))
-		return false; ///< Failed
-	  // Push value
-	cb->buffer[cb->headTemp] = b;
-	// Increment headTemp
-	cb->headTemp = (cb->headTemp + 1) % cb->capacity;
-	cb->countTemp = cb->countTemp + 1;
-	return true; ///< Successful
-}
+	/* Consumer */
+	bool dequeue(uint8_t *b)
+	{
+		const uint16_t t = tail;
+		// Empty
+		if (gpb_cbuff_load(&head) == t)
+			return false; ///< Failed
+		  // Pop value then hand the slot back
+		*b = buffer[slot(t)];
+		gpb_cbuff_store(&tail, advance(t, 1));
+		return true; ///< Successful
+	}
+
+	bool peek(uint8_t *b, uint16_t offset) const
+	{
+		const uint16_t t = tail;
+		if (distance(t, gpb_cbuff_load(&head)) <= offset)
+			return false; ///< Failed
+		*b = buffer[slot(advance(t, offset))];
+		return true; ///< Successful
+	}
+
+	// Longest run of queued bytes that is contiguous in memory, starting at
+	// the oldest one.  A wrapped queue takes two calls to drain.  The bytes
+	// stay valid until they are released with consume().
+	uint16_t peekSpan(const uint8_t **bytes) const
+	{
+		const uint16_t t = tail;
+		const uint16_t queued = distance(t, gpb_cbuff_load(&head));
+		const uint16_t untilWrap = Capacity - slot(t);
+		*bytes = &buffer[slot(t)];
+		return queued < untilWrap ? queued : untilWrap;
+	}
+
+	void consume(uint16_t count)
+	{
+		gpb_cbuff_store(&tail, advance(tail, count));
+	}
+
+	// Drops everything queued.  Only the consumer may call this, the
+	// producer's head is left where it is.
+	void reset()
+	{
+		gpb_cbuff_store(&tail, gpb_cbuff_load(&head));
+	}
+
+	/* Either side */
+	uint16_t count() const
+	{
+		const uint16_t t = gpb_cbuff_load(&tail);
+		return distance(t, gpb_cbuff_load(&head));
+	}
+	uint16_t capacity() const { return Capacity; }
+	bool isFull() const { return count() >= Capacity; }
+	bool isEmpty() const { return count() == 0; }
+
+#ifdef FEATURE_CHECKSUM_SUPPORTED
+	/* Temp Enqeue */
+	// Bytes are staged past head and only published on accept, the consumer
+	// never sees a packet that is later thrown away.
+	void resetTemp()
+	{
+		headTemp = head;
+	}
+
+	void acceptTemp()
+	{
+		gpb_cbuff_store(&head, headTemp);
+	}
+
+	bool enqueueTemp(uint8_t b)
+	{
+		// Full
+		if (distance(gpb_cbuff_load(&tail), headTemp) >= Capacity)
+			return false; ///< Failed
+		  // Push value
+		buffer[slot(headTemp)] = b;
+		headTemp = advance(headTemp, 1);
+		return true; ///< Successful
+	}
 #else
-#define gpb_cbuff_EnqueueTemp(CB, B) gpb_cbuff_Enqueue(CB, B)
+	bool enqueueTemp(uint8_t b) { return enqueue(b); }
 #endif // FEATURE_CHECKSUM_SUPPORTED
 
-#endif // GBP_CBUFF_H
\ No newline at end of file
+private:
+	volatile uint16_t head; ///< Next slot to write, owned by the producer
+	volatile uint16_t tail; ///< Next slot to read, owned by the consumer
+#ifdef FEATURE_CHECKSUM_SUPPORTED
+	uint16_t headTemp; ///< Staged head, owned by the producer
+#endif
+	uint8_t buffer[Capacity]; ///< Data Buffer
+};
+
+#endif // GBP_CBUFF_H
@@ -36,9 +36,6 @@ WebUSB WebUSBSerial(1, "herrzatacke.github.io/gb-printer-web/#/webusb");
 #define Serial WebUSBSerial
 #endif
 
-#define GBP_OUTPUT_RAW_PACKETS true // by default, packets are parsed. if enabled, output will change to raw data packets for parsing and decompressing later
-#define GBP_USE_PARSE_DECOMPRESSOR false // embedded decompressor can be enabled for use with parse mode but it requires fast hardware (SAMD21, SAMD51, ESP8266, ESP32)
-
 #include "common.h"
 
 #include "gameboy_printer_protocol.h"
@@ -49,12 +46,12 @@ WebUSB WebUSBSerial(1, "herrzatacke.github.io/gb-printer-web/#/webusb");
 #include "ESPAsyncWebServer.h"
 #include "FS.h"
 #include "FFat.h"
-#include "PSString.h"
+#include "PrintStore.h"
 
 // Set web server port number to 80
 AsyncWebServer server(80);
 
-PSString output;
+PrintStore printStore;
 #endif
 
 #if GBP_OUTPUT_RAW_PACKETS
@@ -66,9 +63,16 @@ PSString output;
 #endif
 #endif
 
-#ifdef GBP_FEATURE_PARSE_PACKET_MODE
+#if defined(ESP_PLATFORM)
+#define GBP_FEATURE_IMAGE_PIPELINE // Decode prints to BMP on the device, next to the raw packet output
+#endif
+
+#if defined(GBP_FEATURE_PARSE_PACKET_MODE) || defined(GBP_FEATURE_IMAGE_PIPELINE)
 #include "gbp_pkt.h"
 #endif
+#ifdef GBP_FEATURE_IMAGE_PIPELINE
+#include "gbp_image.h"
+#endif
 
 
 
@@ -113,18 +117,6 @@ PSString output;
 /*******************************************************************************
 *******************************************************************************/
 
-// Dev Note: Gamboy camera sends data payload of 640 bytes usually
-
-#ifdef GBP_FEATURE_PARSE_PACKET_MODE
-#define GBP_BUFFER_SIZE 400
-#else
-#define GBP_BUFFER_SIZE 1024
-#endif
-
-/* Serial IO */
-// This circular buffer contains a stream of raw packets from the gameboy
-uint8_t gbp_serialIO_raw_buffer[GBP_BUFFER_SIZE] = { 0 };
-
 #ifdef GBP_FEATURE_PARSE_PACKET_MODE
 /* Packet Buffer */
 gbp_pkt_t gbp_pktState = { GBP_REC_NONE, 0 };
@@ -135,7 +127,179 @@ gbp_pkt_tileAcc_t tileBuff = { 0 };
 #endif
 #endif
 
+#ifdef GBP_FEATURE_IMAGE_PIPELINE
+/* Image Pipeline */
+// Runs its own packet parser over the captured stream, so it works in either
+// output mode.  Peak RAM is one 16 scanline strip, see gbp_image.h.
+static gbp_pkt_t gbp_imagePktState = { GBP_REC_NONE, 0 };
+static uint8_t gbp_imagePktBuff[GBP_PKT_PAYLOAD_BUFF_SIZE_IN_BYTE] = { 0 };
+static uint8_t gbp_imagePktBuffSize = 0;
+static gbp_pkt_tileAcc_t gbp_imageTileBuff = { 0 };
+static gbp_image_t gbp_image;
+
+#if defined(ESP_PLATFORM)
+#define GBP_IMAGE_FILE "/print.bmp"
+
+static File gbp_imageFile;
+
+static void gbp_imageFile_begin(void *context)
+{
+	static const uint8_t placeholder[GBP_IMAGE_BMP_HEADER_SIZE] = { 0 };
+	gbp_imageFile = FFat.open(GBP_IMAGE_FILE, "w");
+	if (gbp_imageFile)
+		gbp_imageFile.write(placeholder, sizeof(placeholder));
+}
+
+static void gbp_imageFile_write(void *context, const uint8_t *bytes, size_t size)
+{
+	if (gbp_imageFile)
+		gbp_imageFile.write(bytes, size);
+}
+
+static void gbp_imageFile_finish(void *context, const uint8_t *header, size_t size)
+{
+	if (!gbp_imageFile)
+		return;
+	gbp_imageFile.seek(0);
+	gbp_imageFile.write(header, size);
+	gbp_imageFile.close();
+}
+
+static const gbp_image_sink_t gbp_imageSink = { NULL, gbp_imageFile_begin, gbp_imageFile_write, gbp_imageFile_finish };
+#endif
+
+static void gbp_image_pipeline_byte(const uint8_t data_8bit)
+{
+	if (!gbp_pkt_processByte(&gbp_imagePktState, data_8bit, gbp_imagePktBuff, &gbp_imagePktBuffSize, sizeof(gbp_imagePktBuff)))
+		return;
+
+	if (gbp_imagePktState.received == GBP_REC_GOT_PACKET)
+	{
+		if (gbp_imagePktState.command == GBP_COMMAND_PRINT)
+			gbp_image_print(&gbp_image, gbp_imagePktBuff);
+		return;
+	}
+
+	// Payload chunk of a data packet
+	while (gbp_pkt_decompressor(&gbp_imagePktState, gbp_imagePktBuff, gbp_imagePktBuffSize, &gbp_imageTileBuff))
+	{
+		if (gbp_pkt_tileAccu_tileReadyCheck(&gbp_imageTileBuff))
+			gbp_image_addTile(&gbp_image, gbp_imageTileBuff.tile);
+	}
+}
+
+static void gbp_image_pipeline_timeout(void)
+{
+	gbp_image_finish(&gbp_image);
+	gbp_pkt_reset(&gbp_imagePktState);
+	gbp_imageTileBuff.count = 0;
+}
+#endif
+
 #ifdef GBP_FEATURE_PACKET_CAPTURE_MODE
+/* Binary Capture */
+// 'b' on the diagnostics console switches packet capture from hex text to
+// framed binary records, 't' switches back.  Text stays the default so the
+// web tool and plain serial monitors keep working.  Every record is
+//
+//     0xA5 | type | length (u16 LE) | payload | CRC-16/CCITT (u16 LE)
+//
+// with the CRC (init 0xFFFF, poly 0x1021) taken over type, length and
+// payload.  All multi byte fields are little endian.
+//
+//     'H' hello, sent on switching to binary: u8 format version
+//     'P' one printer packet exactly as seen on the link, 10 + data length bytes
+//     'T' trailer, sent on printer timeout and on 'd':
+//         u32 packets, u32 bytes, u16 buffer waterline, u16 buffer size
+//
+// A packet cut off by a printer timeout is padded with zeros to the length
+// its header gave and closed with the CRC inverted, so readers stay in step
+// and drop it.
+#define GBP_CAPTURE_SYNC        0xA5
+#define GBP_CAPTURE_VERSION     1
+#define GBP_CAPTURE_REC_HELLO   'H'
+#define GBP_CAPTURE_REC_PACKET  'P'
+#define GBP_CAPTURE_REC_TRAILER 'T'
+
+static bool gbp_captureBinary = false;
+static bool gbp_captureBinaryRequested = false; // Applied between packets
+static uint16_t gbp_captureCrc = 0;
+static uint32_t gbp_capturePktTotal = 0;
+static uint32_t gbp_captureByteTotal = 0;
+static uint32_t gbp_capturePktByteIndex = 0; // Bytes of the current packet seen so far
+static uint16_t gbp_capturePktDataLength = 0;
+static bool gbp_captureTrailerRequested = false; // 'd' mid packet, sent once it ends
+
+static uint16_t gbp_capture_crc16(uint16_t crc, const uint8_t *bytes, size_t size)
+{
+	while (size-- > 0)
+	{
+		crc ^= (uint16_t)(*bytes++) << 8;
+		for (uint8_t bit = 0; bit < 8; bit++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+	}
+	return crc;
+}
+
+static void gbp_capture_beginRecord(const uint8_t type, const uint16_t length)
+{
+	const uint8_t header[4] = { GBP_CAPTURE_SYNC, type, (uint8_t)(length & 0xFF), (uint8_t)(length >> 8) };
+	Serial.write(header, sizeof(header));
+	gbp_captureCrc = gbp_capture_crc16(0xFFFF, header + 1, sizeof(header) - 1);
+}
+
+static void gbp_capture_writeRecord(const uint8_t *bytes, const size_t size)
+{
+	Serial.write(bytes, size);
+	gbp_captureCrc = gbp_capture_crc16(gbp_captureCrc, bytes, size);
+}
+
+static void gbp_capture_endRecord(void)
+{
+	const uint8_t crc[2] = { (uint8_t)(gbp_captureCrc & 0xFF), (uint8_t)(gbp_captureCrc >> 8) };
+	Serial.write(crc, sizeof(crc));
+}
+
+static void gbp_capture_trailer(void)
+{
+	const uint16_t waterline = gbp_serial_io_dataBuff_waterline(false);
+	const uint16_t buffSize = gbp_serial_io_dataBuff_max();
+	const uint8_t trailer[12] = {
+		(uint8_t)(gbp_capturePktTotal >> 0), (uint8_t)(gbp_capturePktTotal >> 8),
+		(uint8_t)(gbp_capturePktTotal >> 16), (uint8_t)(gbp_capturePktTotal >> 24),
+		(uint8_t)(gbp_captureByteTotal >> 0), (uint8_t)(gbp_captureByteTotal >> 8),
+		(uint8_t)(gbp_captureByteTotal >> 16), (uint8_t)(gbp_captureByteTotal >> 24),
+		(uint8_t)(waterline & 0xFF), (uint8_t)(waterline >> 8),
+		(uint8_t)(buffSize & 0xFF), (uint8_t)(buffSize >> 8)
+	};
+	gbp_capture_beginRecord(GBP_CAPTURE_REC_TRAILER, sizeof(trailer));
+	gbp_capture_writeRecord(trailer, sizeof(trailer));
+	gbp_capture_endRecord();
+	Serial.flush();
+	gbp_captureTrailerRequested = false;
+}
+
+static void gbp_capture_abortPacket(void)
+{
+	if (gbp_capturePktByteIndex == 0)
+		return;
+
+	if (gbp_captureBinary)
+	{
+		static const uint8_t padding[16] = { 0 };
+		uint32_t missing = 10 + gbp_capturePktDataLength - gbp_capturePktByteIndex;
+		while (missing > 0)
+		{
+			const uint32_t size = missing < sizeof(padding) ? missing : sizeof(padding);
+			gbp_capture_writeRecord(padding, size);
+			missing -= size;
+		}
+		gbp_captureCrc = ~gbp_captureCrc;
+		gbp_capture_endRecord();
+	}
+	gbp_capturePktByteIndex = 0;
+}
+
 inline void gbp_packet_capture_loop();
 #endif
 #ifdef GBP_FEATURE_PARSE_PACKET_MODE
@@ -160,24 +324,180 @@ const char *gbpCommand_toStr(int val)
 }
 
 /*******************************************************************************
-  Interrupt Service Routine
+  Link Port Backends
 *******************************************************************************/
 
+// RP2040 : A PIO state machine is the link port.  It shifts the bits on the
+//          clock edges by itself and raises one interrupt per byte, which
+//          queues the reply for the next transfer in its TX FIFO.
+// AVR    : One interrupt per clock, pins accessed through the port registers.
+// ESP32  : One interrupt per clock, pins accessed through the GPIO registers.
+//          The SPI peripheral cannot be used, slave mode needs a chip select
+//          and the link cable has none.
+// Other  : One interrupt per clock through digitalRead/digitalWrite.
+
+#if defined(RASPBERRYPI_PICO) || defined(ARDUINO_RASPBERRY_PI_PICO)
+#define GBP_LINK_PIO
+#endif
+
+#if defined(GBP_LINK_PIO)
+
+#include "hardware/pio.h"
+#include "hardware/irq.h"
+
+#define GBP_LINK_PIO_BLOCK pio0
+#define GBP_LINK_PIO_IRQ   PIO0_IRQ_0
+
+static uint gbp_linkSm;
+static uint gbp_linkOffset;
+
+// SPI mode 3 slave, MSB first.  The Game Boy changes its output on the
+// falling edge and samples ours on the rising edge, so we do the same.  The
+// clock pin is not next to the data pins, so the waits are encoded against
+// the absolute GPIO and the program is assembled here instead of by pioasm.
+//
+// The reply to a byte depends on that byte, so it can only be queued once
+// the byte is in.  The interrupt has from the last rising edge of one byte
+// to the first falling edge of the next to do it: half a bit plus whatever
+// gap the Game Boy leaves between bytes, as little as 2 us at double speed.
+// The state machine takes the reply at that falling edge without blocking,
+// if it is not there yet X (always 0) goes out instead, so a late interrupt
+// costs one reply byte but never the bit alignment.
+static uint16_t gbp_linkProgramInstructions[] = {
+	0, // wait 0 gpio SC
+	0, // pull ifempty noblock   (every 8 bits, X when the FIFO is empty)
+	0, // out  pins, 1
+	0, // wait 1 gpio SC
+	0, // in   pins, 1           (autopush every 8 bits)
+};
+
+static void gbp_link_pio_isr(void)
+{
+	while (!pio_sm_is_rx_fifo_empty(GBP_LINK_PIO_BLOCK, gbp_linkSm))
+	{
+		const uint8_t rx = (uint8_t)pio_sm_get(GBP_LINK_PIO_BLOCK, gbp_linkSm);
+		// A reply still queued missed its byte, it would go out one late
+		if (!pio_sm_is_tx_fifo_empty(GBP_LINK_PIO_BLOCK, gbp_linkSm))
+			pio_sm_clear_fifos(GBP_LINK_PIO_BLOCK, gbp_linkSm);
+		pio_sm_put(GBP_LINK_PIO_BLOCK, gbp_linkSm, (uint32_t)gpb_serial_io_OnByte_ISR(rx) << 24);
+	}
+}
+
+// Drops any partial byte.  Only call while the link is idle.
+static void gbp_link_resync(void)
+{
+	pio_sm_set_enabled(GBP_LINK_PIO_BLOCK, gbp_linkSm, false);
+	pio_sm_clear_fifos(GBP_LINK_PIO_BLOCK, gbp_linkSm);
+	pio_sm_restart(GBP_LINK_PIO_BLOCK, gbp_linkSm);
+	pio_sm_exec(GBP_LINK_PIO_BLOCK, gbp_linkSm, pio_encode_set(pio_x, 0));
+	pio_sm_exec(GBP_LINK_PIO_BLOCK, gbp_linkSm, pio_encode_jmp(gbp_linkOffset));
+	pio_sm_set_enabled(GBP_LINK_PIO_BLOCK, gbp_linkSm, true);
+}
+
+static void gbp_link_begin(void)
+{
+	gbp_linkProgramInstructions[0] = pio_encode_wait_gpio(false, GBP_SC_PIN);
+	gbp_linkProgramInstructions[1] = pio_encode_pull(true, false);
+	gbp_linkProgramInstructions[2] = pio_encode_out(pio_pins, 1);
+	gbp_linkProgramInstructions[3] = pio_encode_wait_gpio(true, GBP_SC_PIN);
+	gbp_linkProgramInstructions[4] = pio_encode_in(pio_pins, 1);
+
+	const struct pio_program program = { gbp_linkProgramInstructions, 5, -1 };
+	const uint offset = gbp_linkOffset = pio_add_program(GBP_LINK_PIO_BLOCK, &program);
+	gbp_linkSm = pio_claim_unused_sm(GBP_LINK_PIO_BLOCK, true);
+
+	pio_sm_config c = pio_get_default_sm_config();
+	sm_config_set_wrap(&c, offset, offset + 4);
+	sm_config_set_in_pins(&c, GBP_SO_PIN);
+	sm_config_set_out_pins(&c, GBP_SI_PIN, 1);
+	// Shift to left (MSB first), autopush enabled, the program pulls, 8 bits at a time
+	sm_config_set_in_shift(&c, false, true, 8);
+	sm_config_set_out_shift(&c, false, false, 8);
+	// Sample as fast as possible
+	sm_config_set_clkdiv(&c, 1);
+
+	pio_gpio_init(GBP_LINK_PIO_BLOCK, GBP_SI_PIN);
+	pio_sm_set_consecutive_pindirs(GBP_LINK_PIO_BLOCK, gbp_linkSm, GBP_SI_PIN, 1, true);
+	pio_sm_init(GBP_LINK_PIO_BLOCK, gbp_linkSm, offset, &c);
+	pio_sm_exec(GBP_LINK_PIO_BLOCK, gbp_linkSm, pio_encode_set(pio_x, 0));
+
+	pio_set_irq0_source_enabled(GBP_LINK_PIO_BLOCK, (enum pio_interrupt_source)(pis_sm0_rx_fifo_not_empty + gbp_linkSm), true);
+	irq_set_exclusive_handler(GBP_LINK_PIO_IRQ, gbp_link_pio_isr);
+	irq_set_priority(GBP_LINK_PIO_IRQ, PICO_HIGHEST_IRQ_PRIORITY);
+	irq_set_enabled(GBP_LINK_PIO_IRQ, true);
+
+	// The first byte gets X, every later one the reply the ISR queued
+	pio_sm_set_enabled(GBP_LINK_PIO_BLOCK, gbp_linkSm, true);
+}
+
+#else
+
+#if defined(__AVR__)
+// Resolved once in gbp_link_begin(), saves the pin lookups digitalRead and
+// digitalWrite would do on every clock edge.
+static volatile uint8_t *gbp_linkScIn;
+static volatile uint8_t *gbp_linkSoIn;
+static volatile uint8_t *gbp_linkSiOut;
+static uint8_t gbp_linkScMask;
+static uint8_t gbp_linkSoMask;
+static uint8_t gbp_linkSiMask;
+
+#define GBP_LINK_READ_SC()  ((*gbp_linkScIn & gbp_linkScMask) != 0)
+#define GBP_LINK_READ_SO()  ((*gbp_linkSoIn & gbp_linkSoMask) != 0)
+#define GBP_LINK_WRITE_SI(b) do { if (b) *gbp_linkSiOut |= gbp_linkSiMask; else *gbp_linkSiOut &= ~gbp_linkSiMask; } while (0)
+#elif defined(ESP_PLATFORM)
+#define GBP_LINK_READ_SC()  ((REG_READ(GPIO_IN_REG) >> GBP_SC_PIN) & 1)
+#define GBP_LINK_READ_SO()  ((REG_READ(GPIO_IN_REG) >> GBP_SO_PIN) & 1)
+#define GBP_LINK_WRITE_SI(b) REG_WRITE((b) ? GPIO_OUT_W1TS_REG : GPIO_OUT_W1TC_REG, 1UL << GBP_SI_PIN)
+#else
+#define GBP_LINK_READ_SC()  digitalRead(GBP_SC_PIN)
+#define GBP_LINK_READ_SO()  digitalRead(GBP_SO_PIN)
+#define GBP_LINK_WRITE_SI(b) digitalWrite(GBP_SI_PIN, (b) ? HIGH : LOW)
+#endif
+
 #ifdef ESP8266
 void ICACHE_RAM_ATTR serialClock_ISR(void)
+#elif defined(ESP_PLATFORM)
+void IRAM_ATTR serialClock_ISR(void)
 #else
 void serialClock_ISR(void)
 #endif
 {
 	// Serial Clock (1 = Rising Edge) (0 = Falling Edge); Master Output Slave Input (This device is slave)
 #ifdef GBP_FEATURE_USING_RISING_CLOCK_ONLY_ISR
-	const bool txBit = gpb_serial_io_OnRising_ISR(digitalRead(GBP_SO_PIN));
+	const bool txBit = gpb_serial_io_OnRising_ISR(GBP_LINK_READ_SO());
+#else
+	const bool txBit = gpb_serial_io_OnChange_ISR(GBP_LINK_READ_SC(), GBP_LINK_READ_SO());
+#endif
+	GBP_LINK_WRITE_SI(txBit);
+}
+
+// The bit engine finds the byte framing from the preamble by itself
+static void gbp_link_resync(void)
+{
+}
+
+static void gbp_link_begin(void)
+{
+#if defined(__AVR__)
+	gbp_linkScIn   = portInputRegister(digitalPinToPort(GBP_SC_PIN));
+	gbp_linkSoIn   = portInputRegister(digitalPinToPort(GBP_SO_PIN));
+	gbp_linkSiOut  = portOutputRegister(digitalPinToPort(GBP_SI_PIN));
+	gbp_linkScMask = digitalPinToBitMask(GBP_SC_PIN);
+	gbp_linkSoMask = digitalPinToBitMask(GBP_SO_PIN);
+	gbp_linkSiMask = digitalPinToBitMask(GBP_SI_PIN);
+#endif
+
+	/* Attach ISR */
+#ifdef GBP_FEATURE_USING_RISING_CLOCK_ONLY_ISR
+	attachInterrupt(digitalPinToInterrupt(GBP_SC_PIN), serialClock_ISR, RISING); // attach interrupt handler
 #else
-	const bool txBit = gpb_serial_io_OnChange_ISR(digitalRead(GBP_SC_PIN), digitalRead(GBP_SO_PIN));
+	attachInterrupt(digitalPinToInterrupt(GBP_SC_PIN), serialClock_ISR, CHANGE); // attach interrupt handler
 #endif
-	digitalWrite(GBP_SI_PIN, txBit ? HIGH : LOW);
 }
 
+#endif
+
 /*******************************************************************************
   Main Setup and Loop
 *******************************************************************************/
@@ -222,20 +542,171 @@ String SaveStringToFile(String value, String filename)
 	return value;
 }
 
+/* Web Server */
+// Template values are kept in RAM instead of being read from flash on every
+// request.  The usage figure is written by the main loop and read by the
+// web task, so it is a plain char array rather than a String.
+static String gbp_webSsid;
+static String gbp_webPassword;
+static char gbp_webPercentUsed[12];
+static volatile bool gbp_webClearRequested = false;
+
+static void gbp_web_refreshUsage(void)
+{
+	snprintf(gbp_webPercentUsed, sizeof(gbp_webPercentUsed), "%.2f", (float)FFat.usedBytes() / (float)FFat.totalBytes() * 100.0);
+}
+
 String processor(const String& var) {
-	Serial.println(var);
 	if (var == "PERCENTUSED")
 	{		
-		return String((float)FFat.usedBytes() / (float)FFat.totalBytes() * 100.0);			
+		return String(gbp_webPercentUsed);
 	}
 	else if (var == "SSID")
 	{
-		return GetStringFromFile("Default", "/SSID.txt");
+		return gbp_webSsid;
 	}
 	else if (var == "PASSWORD")
 	{
-		return GetStringFromFile("", "/Password.txt");
+		return gbp_webPassword;
+	}
+	return String();
+}
+
+// Static assets only change with the firmware, so the build time is their
+// Last-Modified date.
+static struct tm *gbp_web_buildTime(void)
+{
+	static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+	static struct tm built = { 0 };
+	char month[4] = { __DATE__[0], __DATE__[1], __DATE__[2], '\0' };
+
+	built.tm_mon  = (strstr(months, month) - months) / 3;
+	built.tm_mday = atoi(__DATE__ + 4);
+	built.tm_year = atoi(__DATE__ + 7) - 1900;
+	built.tm_hour = atoi(__TIME__);
+	built.tm_min  = atoi(__TIME__ + 3);
+	built.tm_sec  = atoi(__TIME__ + 6);
+	mktime(&built); // Fills in the weekday
+	return &built;
+}
+
+typedef enum
+{
+	GBP_WEB_RANGE_NONE,          // Not a range we understand, send the whole file
+	GBP_WEB_RANGE_OK,
+	GBP_WEB_RANGE_UNSATISFIABLE  // Well formed but past the end, 416
+} gbp_web_range_t;
+
+static bool gbp_web_isDigits(const String& s)
+{
+	if (s.length() == 0)
+		return false;
+	for (unsigned int i = 0; i < s.length(); i++)
+		if (!isDigit(s[i]))
+			return false;
+	return true;
+}
+
+// Single range only: bytes=a-b, bytes=a- or bytes=-n
+static gbp_web_range_t gbp_web_parseRange(const String& range, size_t size, size_t& start, size_t& end)
+{
+	const int dash = range.indexOf('-');
+	if (!range.startsWith("bytes=") || dash < 0)
+		return GBP_WEB_RANGE_NONE;
+
+	const String first = range.substring(6, dash);
+	const String last = range.substring(dash + 1);
+	if (first.length() == 0)
+	{
+		if (!gbp_web_isDigits(last))
+			return GBP_WEB_RANGE_NONE;
+		const size_t suffix = last.toInt();
+		if (suffix == 0 || size == 0)
+			return GBP_WEB_RANGE_UNSATISFIABLE;
+		start = (suffix >= size) ? 0 : size - suffix;
+		end = size - 1;
+		return GBP_WEB_RANGE_OK;
 	}
+
+	if (!gbp_web_isDigits(first) || (last.length() > 0 && !gbp_web_isDigits(last)))
+		return GBP_WEB_RANGE_NONE;
+	const size_t rangeStart = first.toInt();
+	const size_t rangeEnd = (last.length() > 0) ? (size_t)last.toInt() : SIZE_MAX;
+	if (rangeEnd < rangeStart)
+		return GBP_WEB_RANGE_NONE;
+	if (rangeStart >= size)
+		return GBP_WEB_RANGE_UNSATISFIABLE;
+	start = rangeStart;
+	end = (rangeEnd >= size) ? size - 1 : rangeEnd;
+	return GBP_WEB_RANGE_OK;
+}
+
+// Serves /prints/... with range requests and revalidation.  A print file
+// never changes once it is in the index and the index only grows, until the
+// store is cleared, which bumps the epoch.  So epoch and size make an ETag.
+static void gbp_web_sendPrintFile(AsyncWebServerRequest *request)
+{
+	const String path = request->url();
+	if (path.indexOf("..") >= 0)
+	{
+		request->send(400);
+		return;
+	}
+
+	File file = FFat.open(path, "r");
+	if (!file || file.isDirectory())
+	{
+		request->send(404);
+		return;
+	}
+
+	const size_t size = file.size();
+	const String etag = "\"" + String(printStore.epoch()) + "-" + String(size) + "\"";
+	if (request->hasHeader("If-None-Match") && request->header("If-None-Match") == etag)
+	{
+		AsyncWebServerResponse *response = request->beginResponse(304);
+		response->addHeader("ETag", etag);
+		request->send(response);
+		return;
+	}
+
+	size_t start = 0;
+	size_t end = (size > 0) ? size - 1 : 0;
+	bool partial = false;
+	// Multiple ranges and ones that do not parse are legal to ignore, the
+	// whole file is sent instead
+	if (request->hasHeader("Range") && request->header("Range").indexOf(',') < 0)
+	{
+		const gbp_web_range_t range = gbp_web_parseRange(request->header("Range"), size, start, end);
+		if (range == GBP_WEB_RANGE_UNSATISFIABLE)
+		{
+			AsyncWebServerResponse *response = request->beginResponse(416);
+			response->addHeader("Content-Range", "bytes */" + String(size));
+			request->send(response);
+			return;
+		}
+		partial = (range == GBP_WEB_RANGE_OK);
+	}
+
+	const size_t length = (size > 0) ? end - start + 1 : 0;
+	AsyncWebServerResponse *response = request->beginResponse("text/plain", length,
+		[file, start, length](uint8_t *buffer, size_t maxLen, size_t index) mutable -> size_t {
+			if (index >= length)
+				return 0;
+			if (maxLen > length - index)
+				maxLen = length - index;
+			file.seek(start + index);
+			return file.read(buffer, maxLen);
+		});
+	response->addHeader("Accept-Ranges", "bytes");
+	response->addHeader("ETag", etag);
+	response->addHeader("Cache-Control", "no-cache");
+	if (partial)
+	{
+		response->setCode(206);
+		response->addHeader("Content-Range", "bytes " + String(start) + "-" + String(end) + "/" + String(size));
+	}
+	request->send(response);
 }
 #endif
 
@@ -266,13 +737,14 @@ void GameBoyPrinterEmulator::setup(void)
 	digitalWrite(LED_STATUS_PIN, LOW);
 
 	/* Setup */
-	gpb_serial_io_init(sizeof(gbp_serialIO_raw_buffer), gbp_serialIO_raw_buffer);
+	gpb_serial_io_init();
 
-	/* Attach ISR */
-#ifdef GBP_FEATURE_USING_RISING_CLOCK_ONLY_ISR
-	attachInterrupt(digitalPinToInterrupt(GBP_SC_PIN), serialClock_ISR, RISING); // attach interrupt handler
-#else
-	attachInterrupt(digitalPinToInterrupt(GBP_SC_PIN), serialClock_ISR, CHANGE); // attach interrupt handler
+	/* Link Port */
+	gbp_link_begin();
+
+#ifdef GBP_FEATURE_IMAGE_PIPELINE
+	gbp_pkt_init(&gbp_imagePktState);
+	gbp_image_init(&gbp_image, &gbp_imageSink);
 #endif
 
 	  /* Packet Parser */
@@ -309,19 +781,23 @@ void GameBoyPrinterEmulator::setup(void)
 		Serial.println("Fat FS mount failed. Not enough RAM?");
 		return;
 	}
+
+	if (!printStore.begin(FFat))
+		Serial.println("// Could not create the prints directory");
 	
-	String ssid = GetStringFromFile("Default", "/SSID.txt");
-	String password = GetStringFromFile("", "/Password.txt");
+	gbp_webSsid = GetStringFromFile("Default", "/SSID.txt");
+	gbp_webPassword = GetStringFromFile("", "/Password.txt");
+	gbp_web_refreshUsage();
 	
 	Serial.print("SSID: ");
-	Serial.println(ssid);
+	Serial.println(gbp_webSsid);
 	Serial.print("Password: ");
-	Serial.println(password);
+	Serial.println(gbp_webPassword);
 	
 	// Connect to Wi-Fi network with SSID and password
 	Serial.print("Setting AP (Access Point)...");
 	// Remove the password parameter, if you want the AP (Access Point) to be open
-	WiFi.softAP(ssid, password);
+	WiFi.softAP(gbp_webSsid, gbp_webPassword);
 	IPAddress IP = WiFi.softAPIP();
 	Serial.print("AP IP address: ");
 	Serial.println(IP);
@@ -333,30 +809,31 @@ void GameBoyPrinterEmulator::setup(void)
 			request->send(FFat, "/gbp_js_raw_decoder.html", "text/html", false, processor);
 		});
  
-	server.on("/gbp_gbp2bpp_raw.js",
-		HTTP_GET,
-		[](AsyncWebServerRequest *request) {
-			request->send(FFat,
-				"/gbp_gbp2bpp_raw.js",
-				"text/javascript");
-		});
+	// A .gz next to each script is sent precompressed, see FFat/gzip_assets.sh
+	server.serveStatic("/gbp_gbp2bpp_raw.js", FFat, "/gbp_gbp2bpp_raw.js")
+		.setCacheControl("max-age=86400")
+		.setLastModified(gbp_web_buildTime());
 	
-	server.on("/rawFunctions.js",
-		HTTP_GET,
-		[](AsyncWebServerRequest *request) {
-			request->send(FFat, "/rawFunctions.js", "text/javascript");
-		});
+	server.serveStatic("/rawFunctions.js", FFat, "/rawFunctions.js")
+		.setCacheControl("max-age=86400")
+		.setLastModified(gbp_web_buildTime());
 	
-	server.on("/images.dat",
+	// index.txt and one NNNN.txt per print, see PrintStore.h
+	server.on("/prints", HTTP_GET, gbp_web_sendPrintFile);
+	
+#ifdef GBP_FEATURE_IMAGE_PIPELINE
+	server.on("/print.bmp",
 		HTTP_GET,
 		[](AsyncWebServerRequest *request) {
-			request->send(FFat, "/images.dat", "text/plain", false, NULL);
+			request->send(FFat, GBP_IMAGE_FILE, "image/bmp");
 		});
-	
+#endif
+
 	server.on("/clear",
 		HTTP_GET,
 		[](AsyncWebServerRequest *request) {
-			FFat.remove("/images.dat");
+			// The main loop owns the print store, it does the actual clearing
+			gbp_webClearRequested = true;
 			request->redirect("/");
 		});
 	
@@ -373,13 +850,13 @@ void GameBoyPrinterEmulator::setup(void)
 			{
 				AsyncWebParameter* p = request->getParam("ssid");
 				Serial.println(p->value());
-				SaveStringToFile(p->value(), "/SSID.txt");
+				gbp_webSsid = SaveStringToFile(p->value(), "/SSID.txt");
 			}
 			if (request->hasParam("password"))
 			{
 				AsyncWebParameter* p = request->getParam("password");
 				Serial.println(p->value());
-				SaveStringToFile(p->value(), "/Password.txt");
+				gbp_webPassword = SaveStringToFile(p->value(), "/Password.txt");
 			}
 			request->redirect("/wifi_setup.html");
 		});
@@ -406,6 +883,15 @@ void GameBoyPrinterEmulator::loop()
 #ifdef GBP_FEATURE_PACKET_CAPTURE_MODE
 	gbp_packet_capture_loop();
 #endif
+#if defined(ESP_PLATFORM)
+	printStore.service();
+	if (gbp_webClearRequested)
+	{
+		printStore.clear();
+		gbp_web_refreshUsage();
+		gbp_webClearRequested = false;
+	}
+#endif
 #ifdef GBP_FEATURE_PARSE_PACKET_MODE
 	gbp_parse_packet_loop();
 #endif
@@ -418,26 +904,37 @@ void GameBoyPrinterEmulator::loop()
 		uint32_t elapsed_ms = curr_millis - last_millis;
 		if (gbp_serial_io_timeout_handler(elapsed_ms))
 		{	
+			gbp_link_resync();
+#ifdef GBP_FEATURE_IMAGE_PIPELINE
+			gbp_image_pipeline_timeout();
+#endif
 #if defined(ESP_PLATFORM)
-			File file = FFat.open("/images.dat", "a", true);
-			if (!file) {
-				Serial.println("// There was an error opening images.dat for appending");
-				output.clear();
-				return;
-			}			
-			file.print(output.c_str());
-			file.close();
-			output.clear();
-			Serial.println("// Successfully appended print to images.dat");
-#endif
-			Serial.println("");
-			Serial.print("// Completed ");
-			Serial.print("(Memory Waterline: ");
-			Serial.print(gbp_serial_io_dataBuff_waterline(false));
-			Serial.print("B out of ");
-			Serial.print(gbp_serial_io_dataBuff_max());
-			Serial.println("B)");
-			Serial.flush();
+			const bool savedPrint = printStore.endPrint();
+			if (savedPrint)
+				gbp_web_refreshUsage();
+#endif
+#ifdef GBP_FEATURE_PACKET_CAPTURE_MODE
+			gbp_capture_abortPacket();
+			if (gbp_captureBinary)
+			{
+				gbp_capture_trailer();
+			}
+			else
+#endif
+			{
+#if defined(ESP_PLATFORM)
+				if (savedPrint)
+					Serial.println("// Saved print to flash");
+#endif
+				Serial.println("");
+				Serial.print("// Completed ");
+				Serial.print("(Memory Waterline: ");
+				Serial.print(gbp_serial_io_dataBuff_waterline(false));
+				Serial.print("B out of ");
+				Serial.print(gbp_serial_io_dataBuff_max());
+				Serial.println("B)");
+				Serial.flush();
+			}
 			digitalWrite(LED_STATUS_PIN, LOW);
 			
 #ifdef GBP_FEATURE_PARSE_PACKET_MODE
@@ -456,10 +953,34 @@ void GameBoyPrinterEmulator::loop()
 		switch (Serial.read())
 		{
 		case '?':
+#ifdef GBP_FEATURE_PACKET_CAPTURE_MODE
+			Serial.println("d=debug, b=binary capture, t=text capture, ?=help");
+#else
 			Serial.println("d=debug, ?=help");
+#endif
 			break;
 
+#ifdef GBP_FEATURE_PACKET_CAPTURE_MODE
+		case 'b':
+			gbp_captureBinaryRequested = true;
+			break;
+
+		case 't':
+			gbp_captureBinaryRequested = false;
+			break;
+#endif
+
 		case 'd':
+#ifdef GBP_FEATURE_PACKET_CAPTURE_MODE
+			if (gbp_captureBinary)
+			{
+				if (gbp_capturePktByteIndex != 0)
+					gbp_captureTrailerRequested = true;
+				else
+					gbp_capture_trailer();
+				break;
+			}
+#endif
 			Serial.print("waterline: ");
 			Serial.print(gbp_serial_io_dataBuff_waterline(false));
 			Serial.print("B out of ");
@@ -477,9 +998,14 @@ void GameBoyPrinterEmulator::loop()
 inline void gbp_parse_packet_loop(void)
 {
 	const char nibbleToCharLUT[] = "0123456789ABCDEF";
-	for (int i = 0; i < gbp_serial_io_dataBuff_getByteCount(); i++)
+	const uint8_t *bytes;
+	const size_t byteCount = gbp_serial_io_dataBuff_getSpan(&bytes);
+	for (size_t n = 0; n < byteCount; n++)
 	{
-		if (gbp_pkt_processByte(&gbp_pktState, (const uint8_t) gbp_serial_io_dataBuff_getByte(), gbp_pktbuff, &gbp_pktbuffSize, sizeof(gbp_pktbuff)))
+#ifdef GBP_FEATURE_IMAGE_PIPELINE
+		gbp_image_pipeline_byte(bytes[n]);
+#endif
+		if (gbp_pkt_processByte(&gbp_pktState, bytes[n], gbp_pktbuff, &gbp_pktbuffSize, sizeof(gbp_pktbuff)))
 		{
 			if (gbp_pktState.received == GBP_REC_GOT_PACKET)
 			{
@@ -589,72 +1115,121 @@ inline void gbp_parse_packet_loop(void)
 			}
 		}
 	}
+	gbp_serial_io_dataBuff_consume(byteCount);
 }
 #endif
 
 #ifdef GBP_FEATURE_PACKET_CAPTURE_MODE
 inline void gbp_packet_capture_loop()
 {
-	/* tiles received */
-	static uint32_t byteTotal = 0;
-	static uint32_t pktTotalCount = 0;
-	static uint32_t pktByteIndex = 0;
-	static uint16_t pktDataLength = 0;
+	// Only switch formats or send a trailer between packets, so no record is
+	// ever cut in half
+	if ((gbp_capturePktByteIndex == 0) && gbp_captureTrailerRequested)
+	{
+		if (gbp_captureBinary)
+			gbp_capture_trailer();
+		gbp_captureTrailerRequested = false;
+	}
+	if ((gbp_capturePktByteIndex == 0) && (gbp_captureBinary != gbp_captureBinaryRequested))
+	{
+		gbp_captureBinary = gbp_captureBinaryRequested;
+		if (gbp_captureBinary)
+		{
+			const uint8_t version = GBP_CAPTURE_VERSION;
+			gbp_capture_beginRecord(GBP_CAPTURE_REC_HELLO, sizeof(version));
+			gbp_capture_writeRecord(&version, sizeof(version));
+			gbp_capture_endRecord();
+		}
+	}
+
 	const size_t dataBuffCount = gbp_serial_io_dataBuff_getByteCount();
 	if (
-	    ((pktByteIndex != 0)&&(dataBuffCount > 0)) ||
-	    ((pktByteIndex == 0)&&(dataBuffCount >= 6)))
+	    ((gbp_capturePktByteIndex != 0)&&(dataBuffCount > 0)) ||
+	    ((gbp_capturePktByteIndex == 0)&&(dataBuffCount >= 6)))
 	{
 		const char nibbleToCharLUT[] = "0123456789ABCDEF";
 		uint8_t data_8bit = 0;
-		for (int i = 0; i < dataBuffCount; i++)
+		const uint8_t *bytes;
+		size_t byteCount = gbp_serial_io_dataBuff_getSpan(&bytes);
+		size_t runStart = 0; // First byte of the span not yet sent as binary
+		for (size_t i = 0; i < byteCount; i++)
 		{
 			// Display the data payload encoded in hex
 		  // Start of a new packet
-			if (pktByteIndex == 0)
+			if (gbp_capturePktByteIndex == 0)
 			{
-				pktDataLength = gbp_serial_io_dataBuff_getByte_Peek(4);
-				pktDataLength |= (gbp_serial_io_dataBuff_getByte_Peek(5) << 8) & 0xFF00;
+				// The header's length field has not arrived yet, leave the
+				// packet queued until it has
+				if (dataBuffCount - i < 6)
+				{
+					byteCount = i;
+					break;
+				}
+				gbp_capturePktDataLength = gbp_serial_io_dataBuff_getByte_Peek(i + 4);
+				gbp_capturePktDataLength |= (gbp_serial_io_dataBuff_getByte_Peek(i + 5) << 8) & 0xFF00;
 #if 0
 				Serial.print("// ");
 				Serial.print(pktTotalCount);
 				Serial.print(" : ");
-				Serial.println(gbpCommand_toStr(gbp_serial_io_dataBuff_getByte_Peek(2)));
+				Serial.println(gbpCommand_toStr(gbp_serial_io_dataBuff_getByte_Peek(i + 2)));
 #endif
 				digitalWrite(LED_STATUS_PIN, HIGH);
+				if (gbp_captureBinary)
+				{
+					runStart = i;
+					gbp_capture_beginRecord(GBP_CAPTURE_REC_PACKET, 10 + gbp_capturePktDataLength);
+				}
 			}
 			// Print Hex Byte
-			data_8bit = gbp_serial_io_dataBuff_getByte();
-			Serial.print((char)nibbleToCharLUT[(data_8bit >> 4) & 0xF]);
-#if defined(ESP_PLATFORM)
-			output.concat((char)nibbleToCharLUT[(data_8bit >> 4) & 0xF]);
+			data_8bit = bytes[i];
+#ifdef GBP_FEATURE_IMAGE_PIPELINE
+			gbp_image_pipeline_byte(data_8bit);
 #endif
-			Serial.print((char)nibbleToCharLUT[(data_8bit >> 0) & 0xF]);
+			if (!gbp_captureBinary)
+			{
+				Serial.print((char)nibbleToCharLUT[(data_8bit >> 4) & 0xF]);
+				Serial.print((char)nibbleToCharLUT[(data_8bit >> 0) & 0xF]);
+			}
 #if defined(ESP_PLATFORM)
-			output.concat((char)nibbleToCharLUT[(data_8bit >> 0) & 0xF]);
+			printStore.write((char)nibbleToCharLUT[(data_8bit >> 4) & 0xF]);
+			printStore.write((char)nibbleToCharLUT[(data_8bit >> 0) & 0xF]);
 #endif
+			gbp_captureByteTotal++; // Byte total counter
 
 			// Splitting packets for convenience
-			if ((pktByteIndex > 5)&&(pktByteIndex >= (9 + pktDataLength)))
+			if ((gbp_capturePktByteIndex > 5)&&(gbp_capturePktByteIndex >= (9 + (uint32_t)gbp_capturePktDataLength)))
 			{
 				digitalWrite(LED_STATUS_PIN, LOW);
-				Serial.println("");
+				if (gbp_captureBinary)
+				{
+					gbp_capture_writeRecord(bytes + runStart, i + 1 - runStart);
+					runStart = i + 1;
+					gbp_capture_endRecord();
+				}
+				else
+				{
+					Serial.println("");
+				}
 #if defined(ESP_PLATFORM)
-				output.concat("\r\n");
+				printStore.write("\r\n");
 #endif
-				pktByteIndex = 0;
-				pktTotalCount++;
+				gbp_capturePktByteIndex = 0;
+				gbp_capturePktTotal++;
 			}
 			else
 			{
-				Serial.print((char)' ');
+				if (!gbp_captureBinary)
+					Serial.print((char)' ');
 #if defined(ESP_PLATFORM)
-				output.concat((char)' ') ;
+				printStore.write((char)' ');
 #endif
-				pktByteIndex++; // Byte hex split counter
-				byteTotal++; // Byte total counter
+				gbp_capturePktByteIndex++; // Byte hex split counter
 			}
 		}
+		// Rest of a packet that continues in the next span
+		if (gbp_captureBinary && (runStart < byteCount))
+			gbp_capture_writeRecord(bytes + runStart, byteCount - runStart);
+		gbp_serial_io_dataBuff_consume(byteCount);
 		Serial.flush();
 	}
 }
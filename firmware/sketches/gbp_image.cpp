@@ -0,0 +1,215 @@
+//
+// gbp_image.cpp
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <string.h> // memcpy
+#include "gbp_image.h"
+
+#define GBP_IMAGE_DEFAULT_PALETTE  0xE4
+#define GBP_IMAGE_DEFAULT_EXPOSURE 0x40
+#define GBP_IMAGE_BLANK_INDEX      4 // Colour table entry that is always white
+
+/*******************************************************************************
+  Utility Functions
+*******************************************************************************/
+
+static uint8_t *gbp_image_put16(uint8_t *p, uint16_t v)
+{
+	*p++ = (uint8_t)(v >> 0);
+	*p++ = (uint8_t)(v >> 8);
+	return p;
+}
+
+static uint8_t *gbp_image_put32(uint8_t *p, uint32_t v)
+{
+	p = gbp_image_put16(p, (uint16_t)(v >> 0));
+	return gbp_image_put16(p, (uint16_t)(v >> 16));
+}
+
+static void gbp_image_start(gbp_image_t *img)
+{
+	if (img->started)
+		return;
+
+	img->started = true;
+	if (img->sink.begin)
+		img->sink.begin(img->sink.context);
+}
+
+static void gbp_image_writeRow(gbp_image_t *img, const uint8_t row[GBP_IMAGE_ROW_SIZE_IN_BYTE])
+{
+	img->sink.write(img->sink.context, row, GBP_IMAGE_ROW_SIZE_IN_BYTE);
+	img->rowCount++;
+}
+
+// Writes the first tileRows rows of tiles in the strip as scanlines
+static void gbp_image_flushStrip(gbp_image_t *img, uint8_t tileRows)
+{
+	uint8_t row[GBP_IMAGE_ROW_SIZE_IN_BYTE];
+
+	gbp_image_start(img);
+
+	for (uint8_t tileRow = 0; tileRow < tileRows; tileRow++)
+	{
+		for (uint8_t line = 0; line < 8; line++)
+		{
+			uint8_t *out = row;
+			for (uint8_t x = 0; x < GBP_IMAGE_WIDTH_IN_TILE; x++)
+			{
+				// 2bpp planar: low bit plane first, high bit plane second
+				const uint8_t *tile = img->strip[tileRow * GBP_IMAGE_WIDTH_IN_TILE + x];
+				const uint8_t lo = tile[line * 2 + 0];
+				const uint8_t hi = tile[line * 2 + 1];
+				for (int8_t bit = 7; bit > 0; bit -= 2)
+				{
+					const uint8_t left  = (((hi >> bit) & 1) << 1) | ((lo >> bit) & 1);
+					const uint8_t right = (((hi >> (bit - 1)) & 1) << 1) | ((lo >> (bit - 1)) & 1);
+					*out++ = (left << 4) | right;
+				}
+			}
+			gbp_image_writeRow(img, row);
+		}
+	}
+}
+
+static void gbp_image_feedBlank(gbp_image_t *img, uint16_t lines)
+{
+	uint8_t row[GBP_IMAGE_ROW_SIZE_IN_BYTE];
+	memset(row, (GBP_IMAGE_BLANK_INDEX << 4) | GBP_IMAGE_BLANK_INDEX, sizeof(row));
+	while (lines-- > 0)
+		gbp_image_writeRow(img, row);
+}
+
+/*******************************************************************************
+*******************************************************************************/
+
+void gbp_image_init(gbp_image_t *img, const gbp_image_sink_t *sink)
+{
+	img->sink = *sink;
+	gbp_image_reset(img);
+}
+
+// Forgets the image in progress without finishing it
+void gbp_image_reset(gbp_image_t *img)
+{
+	img->started = false;
+	img->palette = GBP_IMAGE_DEFAULT_PALETTE;
+	img->exposure = GBP_IMAGE_DEFAULT_EXPOSURE;
+	img->tileCount = 0;
+	img->rowCount = 0;
+}
+
+void gbp_image_addTile(gbp_image_t *img, const uint8_t tile[GBP_TILE_SIZE_IN_BYTE])
+{
+	memcpy(img->strip[img->tileCount++], tile, GBP_TILE_SIZE_IN_BYTE);
+	if (img->tileCount == GBP_IMAGE_STRIP_TILES)
+	{
+		gbp_image_flushStrip(img, GBP_IMAGE_STRIP_TILE_ROWS);
+		img->tileCount = 0;
+	}
+}
+
+// Print instruction: whatever has been received so far is printed with its
+// palette and exposure.  Like the JS decoder, a lower margin of 3 ends the
+// picture and any other margin feeds 16 blank lines per unit.
+void gbp_image_print(gbp_image_t *img, const uint8_t printInstruction[GBP_PRINT_INSTRUCT_PAYLOAD_SIZE])
+{
+	const uint8_t palette = printInstruction[GBP_PRINT_INSTRUCT_INDEX_PALETTE_VALUE];
+	const uint8_t density = printInstruction[GBP_PRINT_INSTRUCT_INDEX_PRINT_DENSITY];
+	const uint8_t marginLower = printInstruction[GBP_PRINT_INSTRUCT_INDEX_NUM_OF_LINEFEED] & 0x0F;
+
+	img->palette = (palette != 0) ? palette : GBP_IMAGE_DEFAULT_PALETTE;
+	img->exposure = (density < 0x80) ? density : GBP_IMAGE_DEFAULT_EXPOSURE;
+
+	// Data always comes in whole rows of tiles, a stray partial row is dropped
+	if (img->tileCount >= GBP_IMAGE_WIDTH_IN_TILE)
+		gbp_image_flushStrip(img, img->tileCount / GBP_IMAGE_WIDTH_IN_TILE);
+	img->tileCount = 0;
+
+	if (marginLower == 3)
+		gbp_image_finish(img);
+	else if (img->started)
+		gbp_image_feedBlank(img, marginLower * 16);
+}
+
+// Completes the image and hands the header to the sink.
+// Return: false if there was nothing to finish
+bool gbp_image_finish(gbp_image_t *img)
+{
+	if (img->tileCount >= GBP_IMAGE_WIDTH_IN_TILE)
+		gbp_image_flushStrip(img, img->tileCount / GBP_IMAGE_WIDTH_IN_TILE);
+	img->tileCount = 0;
+
+	if (!img->started)
+		return false;
+
+	const uint32_t imageSize = img->rowCount * GBP_IMAGE_ROW_SIZE_IN_BYTE;
+	uint8_t header[GBP_IMAGE_BMP_HEADER_SIZE] = { 0 };
+	uint8_t *p = header;
+
+	/* BITMAPFILEHEADER */
+	*p++ = 'B';
+	*p++ = 'M';
+	p = gbp_image_put32(p, GBP_IMAGE_BMP_HEADER_SIZE + imageSize);
+	p = gbp_image_put32(p, 0);
+	p = gbp_image_put32(p, GBP_IMAGE_BMP_HEADER_SIZE);
+
+	/* BITMAPINFOHEADER */
+	p = gbp_image_put32(p, 40);
+	p = gbp_image_put32(p, GBP_IMAGE_WIDTH_IN_PIXEL);
+	p = gbp_image_put32(p, (uint32_t)(-(int32_t)img->rowCount)); // Negative height: rows are top down
+	p = gbp_image_put16(p, 1);
+	p = gbp_image_put16(p, 4);
+	p = gbp_image_put32(p, 0);
+	p = gbp_image_put32(p, imageSize);
+	p = gbp_image_put32(p, 2835);
+	p = gbp_image_put32(p, 2835);
+	p = gbp_image_put32(p, 16);
+	p = gbp_image_put32(p, 0);
+
+	/* Colour table (BGRX) */
+	// Raw pixel value v prints as shade (palette >> 2v) & 3, 0 being white.
+	// Exposure 0x40 is nominal, 0x00 is 25% lighter and 0x7F 25% darker.
+	for (uint8_t v = 0; v < 4; v++)
+	{
+		const uint8_t shade = (img->palette >> (v * 2)) & 0x03;
+		uint32_t darkness = ((uint32_t)shade * 85 * (192 + img->exposure)) >> 8;
+		if (darkness > 255)
+			darkness = 255;
+		const uint8_t level = 255 - darkness;
+		p[v * 4 + 0] = level;
+		p[v * 4 + 1] = level;
+		p[v * 4 + 2] = level;
+	}
+	p[GBP_IMAGE_BLANK_INDEX * 4 + 0] = 0xFF;
+	p[GBP_IMAGE_BLANK_INDEX * 4 + 1] = 0xFF;
+	p[GBP_IMAGE_BLANK_INDEX * 4 + 2] = 0xFF;
+
+	img->sink.finish(img->sink.context, header, sizeof(header));
+
+	gbp_image_reset(img);
+	return true;
+}
@@ -0,0 +1,85 @@
+//
+// gbp_image.h
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef GBP_IMAGE_H
+#define GBP_IMAGE_H
+
+#include <stdint.h> // uint8_t
+#include <stddef.h> // size_t
+#include <stdbool.h> // bool
+#include "gameboy_printer_protocol.h"
+
+/*******************************************************************************
+  Game Boy Printer image pipeline
+
+  Turns the decompressed tiles coming out of gbp_pkt_decompressor() into a
+  4 bit indexed BMP.  Tiles are collected into a strip of 16 scanlines (two
+  rows of 20 tiles, the size of one Game Boy Camera data packet) and each
+  strip is written out as soon as it is complete, so RAM use does not depend
+  on the length of the print.
+
+  Pixels are stored as the raw 2 bit tile values.  The palette and exposure
+  only arrive with the print command after the data, so they live in the
+  BMP colour table, which the sink patches in when the image is finished.
+*******************************************************************************/
+
+#define GBP_IMAGE_WIDTH_IN_TILE       20
+#define GBP_IMAGE_WIDTH_IN_PIXEL      (GBP_IMAGE_WIDTH_IN_TILE * 8)
+#define GBP_IMAGE_STRIP_TILE_ROWS     2
+#define GBP_IMAGE_STRIP_TILES         (GBP_IMAGE_WIDTH_IN_TILE * GBP_IMAGE_STRIP_TILE_ROWS)
+#define GBP_IMAGE_ROW_SIZE_IN_BYTE    (GBP_IMAGE_WIDTH_IN_PIXEL / 2)
+#define GBP_IMAGE_BMP_HEADER_SIZE     (14 + 40 + 16 * 4)
+
+// Where the image goes.  begin() is called before the first row, the sink
+// should reserve GBP_IMAGE_BMP_HEADER_SIZE bytes for the header.  finish()
+// hands over the final header, which belongs at the start of the image.
+typedef struct
+{
+	void *context;
+	void (*begin)(void *context);
+	void (*write)(void *context, const uint8_t *bytes, size_t size);
+	void (*finish)(void *context, const uint8_t *header, size_t size);
+} gbp_image_sink_t;
+
+typedef struct
+{
+	gbp_image_sink_t sink;
+	bool started;
+	uint8_t palette;
+	uint8_t exposure;
+	uint16_t tileCount; ///< Tiles in the current strip
+	uint32_t rowCount; ///< Scanlines written so far
+	uint8_t strip[GBP_IMAGE_STRIP_TILES][GBP_TILE_SIZE_IN_BYTE];
+} gbp_image_t;
+
+void gbp_image_init(gbp_image_t *img, const gbp_image_sink_t *sink);
+void gbp_image_reset(gbp_image_t *img);
+void gbp_image_addTile(gbp_image_t *img, const uint8_t tile[GBP_TILE_SIZE_IN_BYTE]);
+void gbp_image_print(gbp_image_t *img, const uint8_t printInstruction[GBP_PRINT_INSTRUCT_PAYLOAD_SIZE]);
+bool gbp_image_finish(gbp_image_t *img);
+
+#endif // GBP_IMAGE_H
@@ -47,6 +47,17 @@
 
 #define GBP_BUSY_PACKET_COUNT 20 // 68 Inquiry packets is generally approximately how long it takes for a real printer to print. This is not a real printer so can be shorter
 
+// Flow control: once the data buffer fills past the high water mark the
+// printer reports busy / unprocessed data until the host drains it below the
+// low water mark.  The Game Boy only waits on busy while it polls after a
+// print, so this holds off the next print rather than the current packet.
+#ifndef GBP_FLOW_HIGH_WATER
+#define GBP_FLOW_HIGH_WATER (GBP_BUFFER_SIZE * 3 / 4)
+#endif
+#ifndef GBP_FLOW_LOW_WATER
+#define GBP_FLOW_LOW_WATER (GBP_BUFFER_SIZE / 4)
+#endif
+
 
 /******************************************************************************/
 
@@ -95,7 +106,7 @@ static struct
 	uint32_t timeout_ms;
 
 	// Circular Buffer : To store raw packet stream for packet processor
-	gpb_cbuff_t dataBuffer;
+	gpb_cbuff_t<GBP_BUFFER_SIZE> dataBuffer;
 
 	// What packets was received for internal processing
 	bool printInstructionReceived; ///< Print Instruction Command
@@ -119,11 +130,55 @@ static struct
 	int untransPacketCountdown;
 	int dataPacketCountdown;
 
+	// Flow Control (Status bits held while the data buffer is draining)
+	bool flowHeld;
+
 	// Dev
 	uint16_t dataBufferWaterline;
 } gpb_pktIO;
 
 
+/*******************************************************************************
+ * Flow Control
+*******************************************************************************/
+
+// Called on every packet just before its status goes out
+static void gpb_flow_update(void)
+{
+	const uint16_t used = gpb_pktIO.dataBuffer.count();
+
+	if (!gpb_pktIO.flowHeld && (used >= GBP_FLOW_HIGH_WATER))
+	{
+		gpb_pktIO.flowHeld = true;
+	}
+	else if (gpb_pktIO.flowHeld && (used <= GBP_FLOW_LOW_WATER))
+	{
+		// Hand the bits back to the packet countdowns
+		gpb_pktIO.flowHeld = false;
+		if (gpb_pktIO.busyPacketCountdown == 0)
+		{
+			gpb_status_bit_update_printer_busy(gpb_pktIO.statusBuffer, false);
+		}
+		if (gpb_pktIO.untransPacketCountdown == 0)
+		{
+			gpb_status_bit_update_unprocessed_data(gpb_pktIO.statusBuffer, false);
+		}
+	}
+
+	if (gpb_pktIO.flowHeld)
+	{
+		// Busy only means something to the Game Boy while it polls for the
+		// end of a print, elsewhere unprocessed data is what a real printer
+		// would report with a full buffer.
+		gpb_status_bit_update_unprocessed_data(gpb_pktIO.statusBuffer, true);
+		if ((gpb_pktIO.command == GBP_COMMAND_PRINT) || (gpb_pktIO.command == GBP_COMMAND_INQUIRY))
+		{
+			gpb_status_bit_update_printer_busy(gpb_pktIO.statusBuffer, true);
+		}
+	}
+}
+
+
 /*******************************************************************************
  * Serial IO
 *******************************************************************************/
@@ -215,14 +270,14 @@ bool gbp_serial_io_timeout_handler(uint32_t elapsed_ms)
 
 size_t gbp_serial_io_dataBuff_getByteCount(void)
 {
-	return gpb_cbuff_Count(&gpb_pktIO.dataBuffer);
+	return gpb_pktIO.dataBuffer.count();
 }
 
 uint8_t gbp_serial_io_dataBuff_getByte(void)
 {
 	uint8_t b = 0;
 
-	if (!gpb_cbuff_Dequeue(&gpb_pktIO.dataBuffer, &b))
+	if (!gpb_pktIO.dataBuffer.dequeue(&b))
 		return 0;
 
 	/* Packet Timeout Reset (Still Processing) */
@@ -234,10 +289,26 @@ uint8_t gbp_serial_io_dataBuff_getByte(void)
 uint8_t gbp_serial_io_dataBuff_getByte_Peek(uint32_t offset)
 {
 	uint8_t b = 0;
-	gpb_cbuff_Dequeue_Peek(&gpb_pktIO.dataBuffer, &b, offset);
+	gpb_pktIO.dataBuffer.peek(&b, offset);
 	return b;
 }
 
+size_t gbp_serial_io_dataBuff_getSpan(const uint8_t **bytes)
+{
+	return gpb_pktIO.dataBuffer.peekSpan(bytes);
+}
+
+void gbp_serial_io_dataBuff_consume(size_t byteCount)
+{
+	if (byteCount == 0)
+		return;
+
+	gpb_pktIO.dataBuffer.consume(byteCount);
+
+	/* Packet Timeout Reset (Still Processing) */
+	gpb_pktIO.timeout_ms = GBP_PKT10_TIMEOUT_MS;
+}
+
 uint16_t gbp_serial_io_dataBuff_waterline(bool resetWaterline)
 {
 	uint16_t retval = gpb_pktIO.dataBufferWaterline;
@@ -250,7 +321,7 @@ uint16_t gbp_serial_io_dataBuff_waterline(bool resetWaterline)
 
 uint16_t gbp_serial_io_dataBuff_max(void)
 {
-	return gpb_cbuff_Capacity(&gpb_pktIO.dataBuffer);
+	return gpb_pktIO.dataBuffer.capacity();
 }
 
 
@@ -273,28 +344,26 @@ bool gpb_serial_io_reset(void)
 	gpb_status_bit_update_print_buffer_full(gpb_pktIO.statusBuffer, false);
 	gpb_status_bit_update_printer_busy(gpb_pktIO.statusBuffer, false);
 	gpb_status_bit_update_checksum_error(gpb_pktIO.statusBuffer, false);
+	gpb_pktIO.flowHeld = false;
 
 	// Reset data buffer
-	gpb_cbuff_Reset(&gpb_pktIO.dataBuffer);
+	gpb_pktIO.dataBuffer.reset();
 
 #ifdef FEATURE_CHECKSUM_SUPPORTED
 	// Reset temp Buffer
-	gpb_cbuff_ResetTemp(&gpb_pktIO.dataBuffer);
+	gpb_pktIO.dataBuffer.resetTemp();
 #endif // FEATURE_CHECKSUM_SUPPORTED
 
 	return true;
 }
 
-bool gpb_serial_io_init(size_t buffSize, uint8_t *buffPtr)
+bool gpb_serial_io_init(void)
 {
 	// reset status data
 	gpb_pktIO.statusBuffer = 0x0000;
 	gpb_pktIO.statusBuffer = GBP_DEVICE_ID << 8;
 	gpb_pktIO.busyPacketCountdown = 0;
 
-	// print data buffer
-	gpb_cbuff_Init(&gpb_pktIO.dataBuffer, buffSize, buffPtr);
-
 	// Packet Parsing Subsystem
 	gpb_serial_io_reset();
 
@@ -304,96 +373,22 @@ bool gpb_serial_io_init(size_t buffSize, uint8_t *buffPtr)
 
 /******************************************************************************/
 
-// Assumption: Only one gameboy printer connection required
-// Return: pin state of GBP_SIN
-#ifdef GBP_FEATURE_USING_RISING_CLOCK_ONLY_ISR
-bool gpb_serial_io_OnRising_ISR(const bool GBP_SOUT)
-#else
-bool gpb_serial_io_OnChange_ISR(const bool GBP_SCLK, const bool GBP_SOUT)
-#endif
+// A whole 8 or 16 bit word has been exchanged, hand it to the packet parser
+// and set up the next word.  Shared by the bit and byte level link backends.
+static void gpb_sio_wordComplete(void)
 {
-	// Based on SIO Timing Chart. Page 30 of GameBoy PROGRAMMING MANUAL Version 1.0:
-	// * CPOL=1 : Clock Polarity 1. Idle on high.
-	// * CPHA=1 : Clock Phase 1. Change on falling. Check bit on rising edge.
-
-	// # Pin input state
-	// * GBP_SCLK : Serial Clock (1 = Rising Edge) (0 = Falling Edge)
-	// * GBP_SOUT : Master Output Slave Input (This device is slave)
-
-	// Scan for preamble
-	if (!gpb_sio.syncronised)
-	{
-#ifndef GBP_FEATURE_USING_RISING_CLOCK_ONLY_ISR
-		// Expecting rising edge
-		if (!GBP_SCLK)
-			return false;
-#endif
-
-		// Clocking bits on rising edge
-		gpb_sio.preamble |= GBP_SOUT ? 1 : 0;
-
-		// Sync Not Found? Keep scanning
-		if ((gpb_sio.preamble & 0xFFFF) != GBP_SYNC_WORD)
-		{
-			gpb_sio.preamble <<= 1;
-			return false;
-		}
-
-		// Preamble Found... Currently at rising edge
-		// Start reading the packet header
-		gpb_pktIO.packetState = GBP_PKT10_PARSE_HEADER_COMMAND_AND_COMPRESSION;
-		gpb_sio.preamble = 0;
-		gpb_sio.syncronised = true;
-		gpb_sio_next(GBP_SIO_MODE_16BITS_BIG_ENDIAN, 0);
-		return false;
-	}
-
-	/* Psudo SPI Engine */
-	// Basically I have one bit acting as a mask moving across a word sized buffer
-	if (gpb_sio.bitMaskMap > 0)
-	{
-		// Serial Transaction Is Active
-#ifdef GBP_FEATURE_USING_RISING_CLOCK_ONLY_ISR
-		    // Rising Edge Clock (Rx Bit)
-		gpb_sio.rx_buff |= GBP_SOUT ? (gpb_sio.bitMaskMap & 0xFFFF) : 0; ///< Clocking bits on rising edge
-		gpb_sio.bitMaskMap >>= 1; ///< One tx/rx bit cycle complete, next bit now
-		// Falling Edge Clock (Tx Bit) (Prep now for next rising edge)
-		gpb_sio.SINOutputPinState = (gpb_sio.bitMaskMap & gpb_sio.tx_buff) > 0;
-		if (gpb_sio.bitMaskMap > 0)
-			return gpb_sio.SINOutputPinState;
-#else
-		if (GBP_SCLK)
-		{
-			// Rising Edge Clock (Rx Bit)
-			gpb_sio.rx_buff |= GBP_SOUT ? (gpb_sio.bitMaskMap & 0xFFFF) : 0; ///< Clocking bits on rising edge
-			gpb_sio.bitMaskMap >>= 1; ///< One tx/rx bit cycle complete, next bit now
-
-			if (gpb_sio.bitMaskMap > 0)
-				return gpb_sio.SINOutputPinState;
-		}
-		else
-		{
-			// Falling Edge Clock (Tx Bit)
-			gpb_sio.SINOutputPinState = (gpb_sio.bitMaskMap & gpb_sio.tx_buff) > 0;
-			return gpb_sio.SINOutputPinState;
-		}
-#endif
-	}
-
-	/****************************************************************************/
-
 	/* There is uncaptured sync bytes so add it in */
 	if (gpb_pktIO.packetState == GBP_PKT10_PARSE_HEADER_COMMAND_AND_COMPRESSION)
 	{
-		gpb_cbuff_EnqueueTemp(&gpb_pktIO.dataBuffer, GBP_SYNC_WORD_0);
-		gpb_cbuff_EnqueueTemp(&gpb_pktIO.dataBuffer, GBP_SYNC_WORD_1);
+		gpb_pktIO.dataBuffer.enqueueTemp(GBP_SYNC_WORD_0);
+		gpb_pktIO.dataBuffer.enqueueTemp(GBP_SYNC_WORD_1);
 	}
 
 	/* Byte captured so send it downstream to packet processor */
 	switch (gpb_sio.mode)
 	{
 	case GBP_SIO_MODE_8BITS                :
-		gpb_cbuff_EnqueueTemp(&gpb_pktIO.dataBuffer, (uint8_t)((gpb_sio.rx_buff >> 0) & 0xFF));
+		gpb_pktIO.dataBuffer.enqueueTemp((uint8_t)((gpb_sio.rx_buff >> 0) & 0xFF));
 		break;
 	case GBP_SIO_MODE_16BITS_BIG_ENDIAN    :
 	case GBP_SIO_MODE_16BITS_LITTLE_ENDIAN :
@@ -403,14 +398,14 @@ bool gpb_serial_io_OnChange_ISR(const bool GBP_SCLK, const bool GBP_SOUT)
 			// Dev Notes: This is for dumping status byte. This is only done during
 			//            the dummy buffer byte phase so might as well use these
 			//            bytes for documenting response of the status byte
-			gpb_cbuff_EnqueueTemp(&gpb_pktIO.dataBuffer, (uint8_t)((gpb_sio.tx_buff >> 8) & 0xFF));
-			gpb_cbuff_EnqueueTemp(&gpb_pktIO.dataBuffer, (uint8_t)((gpb_sio.tx_buff >> 0) & 0xFF));
+			gpb_pktIO.dataBuffer.enqueueTemp((uint8_t)((gpb_sio.tx_buff >> 8) & 0xFF));
+			gpb_pktIO.dataBuffer.enqueueTemp((uint8_t)((gpb_sio.tx_buff >> 0) & 0xFF));
 		}
 		else
 		{
 			// Gameboy --> Virtual Printer
-			gpb_cbuff_EnqueueTemp(&gpb_pktIO.dataBuffer, (uint8_t)((gpb_sio.rx_buff >> 8) & 0xFF));
-			gpb_cbuff_EnqueueTemp(&gpb_pktIO.dataBuffer, (uint8_t)((gpb_sio.rx_buff >> 0) & 0xFF));
+			gpb_pktIO.dataBuffer.enqueueTemp((uint8_t)((gpb_sio.rx_buff >> 8) & 0xFF));
+			gpb_pktIO.dataBuffer.enqueueTemp((uint8_t)((gpb_sio.rx_buff >> 0) & 0xFF));
 		}
 		break;
 	default:
@@ -418,7 +413,7 @@ bool gpb_serial_io_OnChange_ISR(const bool GBP_SCLK, const bool GBP_SOUT)
 	}
 
 	// Track upper usage of buffer
-	uint16_t waterline = gpb_cbuff_Count(&gpb_pktIO.dataBuffer);
+	uint16_t waterline = gpb_pktIO.dataBuffer.count();
 	if (waterline > gpb_pktIO.dataBufferWaterline)
 	{
 		gpb_pktIO.dataBufferWaterline = waterline;
@@ -481,7 +476,7 @@ bool gpb_serial_io_OnChange_ISR(const bool GBP_SCLK, const bool GBP_SOUT)
 			{
 			case GBP_COMMAND_DATA:
 				// Dev Note: Previous naive approach was to capture byte here
-				// e.g. gpb_cbuff_EnqueueTemp(&gpb_pktIO.dataBuffer, (uint8_t)(gpb_sio.rx_buff & 0xFF));
+				// e.g. gpb_pktIO.dataBuffer.enqueueTemp((uint8_t)(gpb_sio.rx_buff & 0xFF));
 				break;
 			case GBP_COMMAND_PRINT:
 				// Dev Note: But now we are doing packet processing later on...
@@ -609,6 +604,8 @@ bool gpb_serial_io_OnChange_ISR(const bool GBP_SCLK, const bool GBP_SOUT)
 				break;
 			}
 
+			gpb_flow_update();
+
 			// Start sending device id and status byte
 			gpb_pktIO.packetState = GBP_PKT10_PARSE_DUMMY;
 			gpb_sio_next(GBP_SIO_MODE_16BITS_BIG_ENDIAN, gpb_pktIO.statusBuffer);
@@ -682,12 +679,12 @@ bool gpb_serial_io_OnChange_ISR(const bool GBP_SCLK, const bool GBP_SOUT)
 			if (gpb_status_bit_getbit_checksum_error(gpb_pktIO.statusBuffer))
 			{
 				// On checksum error, throw away old data. GBP will resend
-				gpb_cbuff_ResetTemp(&gpb_pktIO.dataBuffer);
+				gpb_pktIO.dataBuffer.resetTemp();
 			}
 			else
 			{
 				// Checksum ok, keep the new data
-				gpb_cbuff_AcceptTemp(&gpb_pktIO.dataBuffer);
+				gpb_pktIO.dataBuffer.acceptTemp();
 			}
 #endif // FEATURE_CHECKSUM_SUPPORTED
 
@@ -705,6 +702,87 @@ bool gpb_serial_io_OnChange_ISR(const bool GBP_SCLK, const bool GBP_SOUT)
 			gpb_sio.SINOutputPinState = false;
 		}
 	}
+}
+
+// Assumption: Only one gameboy printer connection required
+// Return: pin state of GBP_SIN
+#ifdef GBP_FEATURE_USING_RISING_CLOCK_ONLY_ISR
+bool gpb_serial_io_OnRising_ISR(const bool GBP_SOUT)
+#else
+bool gpb_serial_io_OnChange_ISR(const bool GBP_SCLK, const bool GBP_SOUT)
+#endif
+{
+	// Based on SIO Timing Chart. Page 30 of GameBoy PROGRAMMING MANUAL Version 1.0:
+	// * CPOL=1 : Clock Polarity 1. Idle on high.
+	// * CPHA=1 : Clock Phase 1. Change on falling. Check bit on rising edge.
+
+	// # Pin input state
+	// * GBP_SCLK : Serial Clock (1 = Rising Edge) (0 = Falling Edge)
+	// * GBP_SOUT : Master Output Slave Input (This device is slave)
+
+	// Scan for preamble
+	if (!gpb_sio.syncronised)
+	{
+#ifndef GBP_FEATURE_USING_RISING_CLOCK_ONLY_ISR
+		// Expecting rising edge
+		if (!GBP_SCLK)
+			return false;
+#endif
+
+		// Clocking bits on rising edge
+		gpb_sio.preamble |= GBP_SOUT ? 1 : 0;
+
+		// Sync Not Found? Keep scanning
+		if ((gpb_sio.preamble & 0xFFFF) != GBP_SYNC_WORD)
+		{
+			gpb_sio.preamble <<= 1;
+			return false;
+		}
+
+		// Preamble Found... Currently at rising edge
+		// Start reading the packet header
+		gpb_pktIO.packetState = GBP_PKT10_PARSE_HEADER_COMMAND_AND_COMPRESSION;
+		gpb_sio.preamble = 0;
+		gpb_sio.syncronised = true;
+		gpb_sio_next(GBP_SIO_MODE_16BITS_BIG_ENDIAN, 0);
+		return false;
+	}
+
+	/* Psudo SPI Engine */
+	// Basically I have one bit acting as a mask moving across a word sized buffer
+	if (gpb_sio.bitMaskMap > 0)
+	{
+		// Serial Transaction Is Active
+#ifdef GBP_FEATURE_USING_RISING_CLOCK_ONLY_ISR
+		    // Rising Edge Clock (Rx Bit)
+		gpb_sio.rx_buff |= GBP_SOUT ? (gpb_sio.bitMaskMap & 0xFFFF) : 0; ///< Clocking bits on rising edge
+		gpb_sio.bitMaskMap >>= 1; ///< One tx/rx bit cycle complete, next bit now
+		// Falling Edge Clock (Tx Bit) (Prep now for next rising edge)
+		gpb_sio.SINOutputPinState = (gpb_sio.bitMaskMap & gpb_sio.tx_buff) > 0;
+		if (gpb_sio.bitMaskMap > 0)
+			return gpb_sio.SINOutputPinState;
+#else
+		if (GBP_SCLK)
+		{
+			// Rising Edge Clock (Rx Bit)
+			gpb_sio.rx_buff |= GBP_SOUT ? (gpb_sio.bitMaskMap & 0xFFFF) : 0; ///< Clocking bits on rising edge
+			gpb_sio.bitMaskMap >>= 1; ///< One tx/rx bit cycle complete, next bit now
+
+			if (gpb_sio.bitMaskMap > 0)
+				return gpb_sio.SINOutputPinState;
+		}
+		else
+		{
+			// Falling Edge Clock (Tx Bit)
+			gpb_sio.SINOutputPinState = (gpb_sio.bitMaskMap & gpb_sio.tx_buff) > 0;
+			return gpb_sio.SINOutputPinState;
+		}
+#endif
+	}
+
+	/****************************************************************************/
+
+	gpb_sio_wordComplete();
 
 #ifdef GBP_FEATURE_USING_RISING_CLOCK_ONLY_ISR
 	/*
@@ -722,5 +800,55 @@ bool gpb_serial_io_OnChange_ISR(const bool GBP_SCLK, const bool GBP_SOUT)
 	return gpb_sio.SINOutputPinState;
 }
 
+/******************************************************************************/
+
+// Next byte the printer shifts out, MSB first to match the bit engine above
+static inline uint8_t gpb_sio_nextTxByte(void)
+{
+	if (gpb_sio.bitMaskMap > 0xFF)
+		return (uint8_t)(gpb_sio.tx_buff >> 8);
+	if (gpb_sio.bitMaskMap > 0)
+		return (uint8_t)(gpb_sio.tx_buff & 0xFF);
+	return 0x00;
+}
+
+// For link hardware that shifts whole bytes (RP2040 PIO).  The hardware keeps
+// the byte framing, so the preamble is matched a byte at a time.
+// Return: byte to load for the next transfer
+uint8_t gpb_serial_io_OnByte_ISR(const uint8_t GBP_SOUT_BYTE)
+{
+	// Scan for preamble
+	if (!gpb_sio.syncronised)
+	{
+		gpb_sio.preamble = (uint16_t)(gpb_sio.preamble << 8) | GBP_SOUT_BYTE;
+
+		// Sync Not Found? Keep scanning
+		if (gpb_sio.preamble != GBP_SYNC_WORD)
+			return 0x00;
+
+		// Preamble Found... Start reading the packet header
+		gpb_pktIO.packetState = GBP_PKT10_PARSE_HEADER_COMMAND_AND_COMPRESSION;
+		gpb_sio.preamble = 0;
+		gpb_sio.syncronised = true;
+		gpb_sio_next(GBP_SIO_MODE_16BITS_BIG_ENDIAN, 0);
+		return gpb_sio_nextTxByte();
+	}
+
+	// First half of a 16 bit word
+	if (gpb_sio.bitMaskMap > 0xFF)
+	{
+		gpb_sio.rx_buff |= (uint16_t)GBP_SOUT_BYTE << 8;
+		gpb_sio.bitMaskMap >>= 8;
+		return gpb_sio_nextTxByte();
+	}
+
+	gpb_sio.rx_buff |= GBP_SOUT_BYTE;
+	gpb_sio.bitMaskMap = 0;
+
+	gpb_sio_wordComplete();
+
+	return gpb_sio_nextTxByte();
+}
+
 
 /******************************************************************************/
\ No newline at end of file
@@ -29,16 +29,33 @@
 
 #define GBP_FEATURE_USING_RISING_CLOCK_ONLY_ISR // Away from technical accuracy towards double speed mode compatibility
 
+// Output mode, here so that the buffer below can be sized for it.
+#define GBP_OUTPUT_RAW_PACKETS true // by default, packets are parsed. if enabled, output will change to raw data packets for parsing and decompressing later
+#define GBP_USE_PARSE_DECOMPRESSOR false // embedded decompressor can be enabled for use with parse mode but it requires fast hardware (SAMD21, SAMD51, ESP8266, ESP32)
+
+// Raw packet stream buffer.  Powers of two wrap a little faster.
+// Dev Note: Gamboy camera sends data payload of 640 bytes usually.  Parsing
+// keeps up with the printer on its own so needs less, and on AVR the extra
+// RAM is not there to spare.
+#ifndef GBP_BUFFER_SIZE
+#if !GBP_OUTPUT_RAW_PACKETS && defined(__AVR__)
+#define GBP_BUFFER_SIZE 400
+#else
+#define GBP_BUFFER_SIZE 1024
+#endif
+#endif
+
 /******************************************************************************/
 
 /* Init/Reset/ISR Functions */
-bool gpb_serial_io_init(size_t buffSize, uint8_t *buffPtr);
+bool gpb_serial_io_init(void);
 bool gpb_serial_io_reset(void);
 #ifdef GBP_FEATURE_USING_RISING_CLOCK_ONLY_ISR
 bool gpb_serial_io_OnRising_ISR(const bool GBP_SOUT);
 #else
 bool gpb_serial_io_OnChange_ISR(const bool GBP_SCLK, const bool GBP_SOUT);
 #endif
+uint8_t gpb_serial_io_OnByte_ISR(const uint8_t GBP_SOUT_BYTE);
 
 /* Timeout */
 bool gbp_serial_io_timeout_handler(uint32_t elapsed_ms);
@@ -47,6 +64,8 @@ bool gbp_serial_io_timeout_handler(uint32_t elapsed_ms);
 size_t  gbp_serial_io_dataBuff_getByteCount(void);
 uint8_t gbp_serial_io_dataBuff_getByte(void);
 uint8_t gbp_serial_io_dataBuff_getByte_Peek(uint32_t offset);
+size_t  gbp_serial_io_dataBuff_getSpan(const uint8_t **bytes); ///< Contiguous bytes, release with consume
+void    gbp_serial_io_dataBuff_consume(size_t byteCount);
 uint16_t gbp_serial_io_dataBuff_waterline(bool resetWaterline);
 uint16_t gbp_serial_io_dataBuff_max(void);
 
@@ -0,0 +1,110 @@
+//
+// Arduino.h
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef Arduino_h
+#define Arduino_h
+
+// Just enough of the Arduino core for the spies to build on a PC against
+// HostSim.  Only what the sketches use is here; anything else should fail to
+// compile rather than silently do nothing.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "HostSim.h"
+
+typedef uint8_t byte;
+typedef uint16_t word;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A6 20
+#define A7 21
+
+// The ports are slices of the trace, writes to them are accepted and ignored.
+#define PIND ((uint8_t)hostSim.readPins())
+#define PINB ((uint8_t)((hostSim.readPins() >> 8) & 0x3F))
+#define PINC ((uint8_t)((hostSim.readPins() >> 14) & 0x3F))
+extern uint8_t PORTB, PORTC, PORTD, DDRB, DDRC, DDRD;
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define F(s) (s)
+
+template<typename T, typename U>
+static inline T min(T a, U b) { return a < b ? a : (T)b; }
+template<typename T, typename U>
+static inline T max(T a, U b) { return a > b ? a : (T)b; }
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define digitalPinToInterrupt(pin) (pin)
+
+static inline int digitalRead(uint8_t pin) { return (hostSim.readPins() >> pin) & 1; }
+static inline void digitalWrite(uint8_t, uint8_t) {}
+static inline void pinMode(uint8_t, uint8_t) {}
+static inline int analogRead(uint8_t) { return 0; }
+
+static inline unsigned long micros() { return (unsigned long)(hostSim.readPins(), hostSim.nanos() / 1000); }
+static inline unsigned long millis() { return (unsigned long)(hostSim.readPins(), hostSim.nanos() / 1000000); }
+static inline void delay(unsigned long ms) { hostSim.advance((uint64_t)ms * 1000000); }
+static inline void delayMicroseconds(unsigned int us) { hostSim.advance((uint64_t)us * 1000); }
+
+static inline void interrupts() { hostSim.setInterrupts(true); }
+static inline void noInterrupts() { hostSim.setInterrupts(false); }
+static inline void attachInterrupt(uint8_t pin, HostSim::Isr isr, int mode) { hostSim.attachInterrupt(pin, isr, mode); }
+static inline void detachInterrupt(uint8_t pin) { hostSim.detachInterrupt(pin); }
+
+extern HostSerial Serial;
+
+#endif
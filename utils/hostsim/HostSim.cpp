@@ -0,0 +1,238 @@
+//
+// HostSim.cpp
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Arduino.h"
+
+#include <inttypes.h>
+
+uint64_t hostsim_clock_ns = 0;
+
+HostSim hostSim;
+HostSerial Serial;
+
+uint8_t PORTB, PORTC, PORTD, DDRB, DDRC, DDRD;
+
+HostSim::HostSim()
+	: next(0), current(0), readCost(250), interruptsEnabled(true), inIsr(false)
+{
+	memset(handlers, 0, sizeof(handlers));
+}
+
+bool HostSim::load(const char* path)
+{
+	FILE* f = fopen(path, "r");
+	if (f == NULL)
+	{
+		perror(path);
+		return false;
+	}
+
+	char line[128];
+	unsigned lineNumber = 0;
+	samples.clear();
+	while (fgets(line, sizeof(line), f) != NULL)
+	{
+		++lineNumber;
+		if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+			continue;
+
+		Sample s;
+		if (sscanf(line, "%" SCNu64 " %" SCNx32, &s.ns, &s.pins) != 2 || (!samples.empty() && s.ns < samples.back().ns))
+		{
+			fprintf(stderr, "%s:%u: expected \"<ns> <hex pins>\" in time order\n", path, lineNumber);
+			fclose(f);
+			return false;
+		}
+		samples.push_back(s);
+	}
+	fclose(f);
+
+	if (samples.empty())
+	{
+		fprintf(stderr, "%s: empty trace\n", path);
+		return false;
+	}
+
+	// The first line is the state the bus starts in, the last one marks the
+	// end of the trace.
+	hostsim_clock_ns = samples[0].ns;
+	current = samples[0].pins;
+	next = 1;
+	return true;
+}
+
+uint64_t HostSim::nanos() const
+{
+	return hostsim_clock_ns;
+}
+
+// Time stops at every edge on the way, so a handler that reads the clock or
+// the pins sees them as they were at its edge rather than at the end of a
+// long wait.
+void HostSim::advance(uint64_t ns)
+{
+	uint64_t target = hostsim_clock_ns + ns;
+	while (next < samples.size() && samples[next].ns <= target)
+	{
+		uint32_t before = current;
+		if (hostsim_clock_ns < samples[next].ns)
+			hostsim_clock_ns = samples[next].ns;
+		current = samples[next++].pins;
+		if (interruptsEnabled && !inIsr && before != current)
+			dispatch(before, current);
+	}
+	if (hostsim_clock_ns < target)
+		hostsim_clock_ns = target;
+	if (next == samples.size() && hostsim_clock_ns > samples.back().ns)
+		throw TraceEnd();
+}
+
+void HostSim::attachInterrupt(uint8_t pin, Isr isr, int mode)
+{
+	if (pin < sizeof(handlers) / sizeof(handlers[0]))
+	{
+		handlers[pin].isr = isr;
+		handlers[pin].mode = mode;
+	}
+}
+
+void HostSim::detachInterrupt(uint8_t pin)
+{
+	if (pin < sizeof(handlers) / sizeof(handlers[0]))
+		handlers[pin].isr = NULL;
+}
+
+// Runs the handlers for every pin that changed in the right direction.  The
+// handlers read the trace like the main loop does, so time keeps moving
+// while they run, but they are never nested.
+void HostSim::dispatch(uint32_t before, uint32_t after)
+{
+	uint32_t changed = before ^ after;
+
+	inIsr = true;
+	for (uint8_t pin = 0; pin < sizeof(handlers) / sizeof(handlers[0]); ++pin)
+	{
+		if (handlers[pin].isr == NULL || !(changed & (1UL << pin)))
+			continue;
+
+		bool high = (after >> pin) & 1;
+		if (handlers[pin].mode == CHANGE || (handlers[pin].mode == RISING && high) || (handlers[pin].mode == FALLING && !high))
+			handlers[pin].isr();
+	}
+	inIsr = false;
+}
+
+int HostSerial::available()
+{
+	if (in == NULL)
+		return 0;
+
+	int c = getc(in);
+	if (c == EOF)
+		return 0;
+	ungetc(c, in);
+	return 1;
+}
+
+int HostSerial::read()
+{
+	return in != NULL ? getc(in) : -1;
+}
+
+#define HOST_SERIAL_TX_BUFFER 64
+#define HOST_SERIAL_WRITE_NS 4000
+
+size_t HostSerial::write(uint8_t b)
+{
+	if (b == '\n')
+		++frames;
+	++bytes;
+	putc(b, out);
+
+	if (byteTime != 0)
+	{
+		uint64_t now = hostSim.nanos();
+		if (drainedAt < now)
+			drainedAt = now;
+		drainedAt += byteTime;
+		if (drainedAt - now > HOST_SERIAL_TX_BUFFER * byteTime)
+			hostSim.advance(drainedAt - now - HOST_SERIAL_TX_BUFFER * byteTime);
+	}
+	hostSim.advance(HOST_SERIAL_WRITE_NS);
+	return 1;
+}
+
+// Room left in the modelled transmit buffer.
+int HostSerial::availableForWrite()
+{
+	uint64_t now = hostSim.nanos();
+	if (byteTime == 0 || drainedAt <= now)
+		return HOST_SERIAL_TX_BUFFER;
+	uint64_t queued = (drainedAt - now + byteTime - 1) / byteTime;
+	return queued >= HOST_SERIAL_TX_BUFFER ? 0 : HOST_SERIAL_TX_BUFFER - (int)queued;
+}
+
+size_t HostSerial::write(const char* s)
+{
+	return write((const uint8_t*)s, strlen(s));
+}
+
+size_t HostSerial::write(const uint8_t* buf, size_t len)
+{
+	for (size_t i = 0; i < len; ++i)
+		write(buf[i]);
+	return len;
+}
+
+size_t HostSerial::print(long n, int base)
+{
+	if (n < 0 && base == 10)
+		return write('-') + print((unsigned long)-n, base);
+	return print((unsigned long)n, base);
+}
+
+size_t HostSerial::print(unsigned long n, int base)
+{
+	char buf[8 * sizeof(long) + 1];
+	char* p = buf + sizeof(buf) - 1;
+
+	if (base < 2)
+		base = 10;
+	*p = 0;
+	do {
+		unsigned digit = n % base;
+		*--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+		n /= base;
+	} while (n != 0);
+	return write(p);
+}
+
+size_t HostSerial::print(double n, int digits)
+{
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%.*f", digits, n);
+	return write(buf);
+}
@@ -0,0 +1,149 @@
+//
+// HostSim.h
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef HostSim_h
+#define HostSim_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+// Simulated time in nanoseconds.  Only ever touched out of line, the
+// MICROSECOND_NOPS asm changes it behind the compiler's back.
+extern "C" uint64_t hostsim_clock_ns;
+
+// Simulated Arduino Uno for running the spies on a PC.  The pins are driven
+// by a trace, a text file of "<nanoseconds> <pins in hex>" lines where bit n
+// is digital pin n (D0-D13) and bits 14-19 are A0-A5, so PIND, PINB and PINC
+// are just slices of it.  Lines starting with '#' are comments.
+//
+// There is no real clock.  Simulated time moves forward by a fixed cost on
+// every port read and micros() call, by a microsecond for every
+// MICROSECOND_NOPS block (config_host.h turns the block into an add to
+// hostsim_clock_ns) and by whatever delay() asks for.  The spies' busy
+// waits therefore see the trace at the same points the AVR would, and a run
+// is fully deterministic.  Once time passes the end of the trace the next
+// read throws HostSim::TraceEnd, which is how the runner stops a spy's
+// endless loop.
+class HostSim {
+public:
+	struct TraceEnd {};
+
+	typedef void (*Isr)(void);
+
+	HostSim();
+
+	bool load(const char* path);
+
+	// Nanoseconds charged for a port read, 4 cycles at 16 MHz by default.
+	void setReadCost(uint32_t ns) { readCost = ns; }
+
+	uint32_t readPins()
+	{
+		advance(readCost);
+		return current;
+	}
+
+	void advance(uint64_t ns);
+	uint64_t nanos() const;
+	uint64_t traceLength() const { return samples.empty() ? 0 : samples.back().ns; }
+
+	void attachInterrupt(uint8_t pin, Isr isr, int mode);
+	void detachInterrupt(uint8_t pin);
+	void setInterrupts(bool enabled) { interruptsEnabled = enabled; }
+
+private:
+	struct Sample {
+		uint64_t ns;
+		uint32_t pins;
+	};
+
+	struct Handler {
+		Isr isr;
+		int mode;
+	};
+
+	void dispatch(uint32_t before, uint32_t after);
+
+	std::vector<Sample> samples;
+	size_t next;
+	uint32_t current;
+	uint32_t readCost;
+	bool interruptsEnabled;
+	bool inIsr;
+	Handler handlers[20];
+};
+
+extern HostSim hostSim;
+
+// Serial stand-in.  Output goes to a file (stdout by default) and every
+// SPLIT ('\n') is counted as a frame, input comes from an optional file so
+// host commands can be scripted.  Writes take simulated time like the AVR's
+// HardwareSerial: a few microseconds per byte while the 64 byte transmit
+// buffer has room, and a wait for the UART once it is full.  Spies that skip
+// bus traffic while they print depend on this.
+class HostSerial {
+public:
+	HostSerial() : out(stdout), in(NULL), frames(0), bytes(0), byteTime(0), drainedAt(0) {}
+
+	void begin(unsigned long baud) { byteTime = 10000000000ULL / baud; }
+	void end() {}
+	operator bool() const { return true; }
+
+	int available();
+	int availableForWrite();
+	int read();
+	size_t write(uint8_t b);
+	size_t write(const char* s);
+	size_t write(const uint8_t* buf, size_t len);
+	void flush() { fflush(out); }
+
+	size_t print(const char* s) { return write(s); }
+	size_t print(char c) { return write((uint8_t)c); }
+	size_t print(unsigned char b, int base = 10) { return print((unsigned long)b, base); }
+	size_t print(int n, int base = 10) { return print((long)n, base); }
+	size_t print(unsigned int n, int base = 10) { return print((unsigned long)n, base); }
+	size_t print(long n, int base = 10);
+	size_t print(unsigned long n, int base = 10);
+	size_t print(double n, int digits = 2);
+
+	size_t println() { return write('\n'); }
+	template<typename T>
+	size_t println(T value) { size_t n = print(value); return n + println(); }
+	template<typename T>
+	size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+
+	FILE* out;
+	FILE* in;
+	uint32_t frames;
+	uint64_t bytes;
+
+private:
+	uint64_t byteTime;	// Nanoseconds on the wire per byte, 0 before begin()
+	uint64_t drainedAt;	// When the transmit buffer will be empty
+};
+
+#endif
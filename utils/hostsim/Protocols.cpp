@@ -0,0 +1,372 @@
+//
+// Protocols.cpp
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Protocols.h"
+
+#define PIN(n)			(1UL << (n))
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// NES and SNES
+
+#define SR_LATCH		3
+#define SR_CLOCK		6
+#define SR_DATA			4
+#define SR_DATA0		2
+#define SR_DATA1		5
+#define SR_DATA_PINS	(PIN(SR_DATA) | PIN(SR_DATA0) | PIN(SR_DATA1))
+
+// The shift register's data lines for bit n, pressed buttons pull low.
+static uint32_t nesLines(uint32_t state, uint8_t n)
+{
+	uint32_t lines = SR_DATA_PINS;
+	if (state & (1UL << n))
+		lines &= ~PIN(SR_DATA);
+	if (state & (1UL << (8 + n)))
+		lines &= ~PIN(SR_DATA0);
+	if (state & (1UL << (16 + n)))
+		lines &= ~PIN(SR_DATA1);
+	return lines;
+}
+
+// The first bit is on the lines once the latch drops, every rising clock
+// shifts in the next one.  Consoles read on the falling clock, as does the
+// spy.
+static void shiftRegisterPoll(Waveform& w, uint32_t state, uint8_t bits, bool nes)
+{
+	w.set(SR_LATCH, true);
+	w.setPins(SR_DATA_PINS, nes ? nesLines(state, 0) : (state & 1) ? 0 : SR_DATA_PINS);
+	w.hold(12000);
+	w.set(SR_LATCH, false);
+	w.hold(6000);
+
+	for (uint8_t i = 0; i < bits; ++i)
+	{
+		w.set(SR_CLOCK, false);
+		w.hold(6000);
+		w.set(SR_CLOCK, true);
+		if (i + 1 < bits)
+			w.setPins(SR_DATA_PINS, nes ? nesLines(state, i + 1) : (state & (1UL << (i + 1))) ? 0 : SR_DATA_PINS);
+		else
+			w.setPins(SR_DATA_PINS, SR_DATA_PINS);
+		w.hold(6000);
+	}
+}
+
+void nesPoll(Waveform& w, uint32_t state)
+{
+	shiftRegisterPoll(w, state, 8, true);
+}
+
+void snesPoll(Waveform& w, uint32_t state, uint8_t bits)
+{
+	shiftRegisterPoll(w, state, bits, false);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Joybus
+
+static void joybusBit(Waveform& w, uint8_t pin, bool one)
+{
+	w.set(pin, false);
+	w.hold(one ? 1000 : 3000);
+	w.set(pin, true);
+	w.hold(one ? 3000 : 1000);
+}
+
+static void joybusMessage(Waveform& w, uint8_t pin, const uint8_t bytes[], uint8_t length)
+{
+	for (uint8_t i = 0; i < length; ++i)
+		for (int8_t bit = 7; bit >= 0; --bit)
+			joybusBit(w, pin, (bytes[i] >> bit) & 1);
+	joybusBit(w, pin, true);
+}
+
+void joybusTransfer(Waveform& w, uint8_t pin, const uint8_t command[], uint8_t commandLength,
+	const uint8_t reply[], uint8_t replyLength)
+{
+	joybusMessage(w, pin, command, commandLength);
+	if (replyLength == 0)
+		return;
+	w.hold(2000);
+	joybusMessage(w, pin, reply, replyLength);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PlayStation
+
+#define PSX_ATT			2
+#define PSX_CLOCK		3
+#define PSX_ACK			4
+#define PSX_CMD			5
+#define PSX_DATA		6
+
+void psxTransfer(Waveform& w, const uint8_t command[], const uint8_t reply[], uint8_t length)
+{
+	w.set(PSX_ATT, false);
+	w.hold(10000);
+
+	for (uint8_t i = 0; i < length; ++i)
+	{
+		for (uint8_t bit = 0; bit < 8; ++bit)
+		{
+			uint32_t lines = ((command[i] >> bit) & 1 ? PIN(PSX_CMD) : 0) | ((reply[i] >> bit) & 1 ? PIN(PSX_DATA) : 0);
+			w.set(PSX_CLOCK, false);
+			w.setPins(PIN(PSX_CMD) | PIN(PSX_DATA), lines);
+			w.hold(2000);
+			w.set(PSX_CLOCK, true);
+			w.hold(2000);
+		}
+		w.setPins(PIN(PSX_CMD) | PIN(PSX_DATA), PIN(PSX_CMD) | PIN(PSX_DATA));
+
+		if (i + 1 < length)
+		{
+			w.hold(4000);
+			w.set(PSX_ACK, false);
+			w.hold(2000);
+			w.set(PSX_ACK, true);
+			w.hold(4000);
+		}
+	}
+
+	w.hold(2000);
+	w.set(PSX_ATT, true);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Genesis
+
+#define GENESIS_SELECT	8
+#define GENESIS_LINES	0xFC
+
+// Line n + 2 carries button index buttons[n], or is forced low for -1 and
+// high for -2.
+static uint32_t genesisLines(uint16_t state, const int8_t buttons[6])
+{
+	uint32_t lines = 0;
+	for (uint8_t n = 0; n < 6; ++n)
+		if (buttons[n] == -2 || (buttons[n] >= 0 && !(state & (1 << buttons[n]))))
+			lines |= PIN(n + 2);
+	return lines;
+}
+
+void genesisPoll(Waveform& w, uint16_t state)
+{
+	enum { U, D, L, R, B, C, A, S, Z, Y, X, M };
+	static const int8_t low[6] = { U, D, -1, -1, A, S };
+	static const int8_t high[6] = { U, D, L, R, B, C };
+	static const int8_t six[6] = { -1, -1, -1, -1, A, S };
+	static const int8_t seven[6] = { Z, Y, X, M, B, C };
+	static const int8_t eight[6] = { -2, -2, -2, -2, A, S };
+	static const int8_t* const phases[8] = { low, high, low, high, six, seven, eight, high };
+
+	for (uint8_t i = 0; i < 8; ++i)
+	{
+		w.setPins(PIN(GENESIS_SELECT) | GENESIS_LINES, ((i & 1) ? PIN(GENESIS_SELECT) : 0) | genesisLines(state, phases[i]));
+		w.hold(8000);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Saturn
+
+#define SATURN_S0		6
+#define SATURN_S1		7
+
+void saturnPoll(Waveform& w, uint16_t state)
+{
+	static const uint32_t selects[4] = { PIN(SATURN_S1), PIN(SATURN_S0), 0, PIN(SATURN_S0) | PIN(SATURN_S1) };
+
+	for (uint8_t i = 0; i < 4; ++i)
+	{
+		uint32_t lines = (~(state >> (i * 4)) & 0x0F) << 2;
+		w.setPins(0xFC, selects[i] | lines);
+		w.hold(10000);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Maple
+
+#define MAPLE_A			2
+#define MAPLE_B			3
+
+void maplePacket(Waveform& w, uint8_t command, uint8_t recipient, uint8_t sender,
+	const uint32_t payload[], uint8_t words, uint32_t nsPerBit)
+{
+	// maple_out.pio runs four ticks to two thirds of a bit.
+	double tick = nsPerBit * 2.0 / 3.0 / 4.0;
+	const uint32_t a = PIN(MAPLE_A);
+	const uint32_t b = PIN(MAPLE_B);
+
+	uint8_t bytes[4 + 4 * 255 + 1];
+	uint16_t count = 0;
+	uint8_t frame[4] = { words, sender, recipient, command };
+	for (uint8_t i = 0; i < 4; ++i)
+		bytes[count++] = frame[i];
+	for (uint8_t i = 0; i < words; ++i)
+		for (uint8_t j = 0; j < 4; ++j)
+			bytes[count++] = (uint8_t)(payload[i] >> (j * 8));
+	uint8_t crc = 0;
+	for (uint16_t i = 0; i < count; ++i)
+		crc ^= bytes[i];
+	bytes[count++] = crc;
+
+	// Start: A low, four pulses on B, A back high.
+	w.setPins(a | b, a | b);
+	w.hold(5 * tick);
+	w.setPins(a | b, b);
+	w.hold(4 * tick);
+	for (uint8_t i = 0; i < 4; ++i)
+	{
+		w.setPins(a | b, 0);
+		w.hold(4 * tick);
+		w.setPins(a | b, b);
+		w.hold(4 * tick);
+	}
+	w.setPins(a | b, a | b);
+	w.hold(tick);
+
+	// Bits alternate between clocking on A with data on B and the reverse.
+	// The clock rises, the data line (the last clock, so low) takes the bit
+	// and the clock falls.
+	bool clockA = true;
+	for (uint16_t i = 0; i < count; ++i)
+	{
+		for (int8_t bit = 7; bit >= 0; --bit)
+		{
+			uint32_t clock = clockA ? a : b;
+			uint32_t data = clockA ? b : a;
+			uint32_t value = (bytes[i] >> bit) & 1 ? data : 0;
+			w.setPins(clock, clock);
+			w.hold(2 * tick);
+			w.setPins(data, value);
+			w.hold(2 * tick);
+			w.setPins(clock, 0);
+			w.hold(2 * tick);
+			clockA = !clockA;
+		}
+	}
+
+	static const uint8_t end[6] = { 0x1, 0x3, 0x1, 0x0, 0x1, 0x0 };
+	for (uint8_t i = 0; i < 6; ++i)
+	{
+		w.setPins(a | b, (end[i] & 1 ? a : 0) | (end[i] & 2 ? b : 0));
+		w.hold(i == 0 ? 2 * tick : 4 * tick);
+	}
+	w.setPins(a | b, a);
+	w.hold(4 * tick);
+	w.setPins(a | b, a | b);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ADB
+
+#define ADB_PIN			2
+
+static void adbBit(Waveform& w, bool one)
+{
+	w.set(ADB_PIN, false);
+	w.hold(one ? 35000 : 65000);
+	w.set(ADB_PIN, true);
+	w.hold(one ? 65000 : 35000);
+}
+
+static void adbStop(Waveform& w)
+{
+	w.set(ADB_PIN, false);
+	w.hold(65000);
+	w.set(ADB_PIN, true);
+}
+
+static void adbByte(Waveform& w, uint8_t value)
+{
+	for (int8_t bit = 7; bit >= 0; --bit)
+		adbBit(w, (value >> bit) & 1);
+}
+
+uint8_t adbTalk(uint8_t address, uint8_t reg)
+{
+	return (uint8_t)((address << 4) | 0x0C | (reg & 3));
+}
+
+void adbTransfer(Waveform& w, uint8_t command, const uint8_t data[], uint8_t length)
+{
+	w.set(ADB_PIN, false);
+	w.hold(800000);
+	w.set(ADB_PIN, true);
+	w.hold(65000);
+	adbByte(w, command);
+	adbStop(w);
+	w.hold(200000);
+
+	if (length == 0)
+		return;
+	adbBit(w, true);
+	for (uint8_t i = 0; i < length; ++i)
+		adbByte(w, data[i]);
+	adbStop(w);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Game Boy link
+
+#define GB_SC			2
+#define GB_SI			3
+#define GB_SO			4
+
+void gbLinkByte(Waveform& w, uint8_t out, uint8_t in)
+{
+	// 8192 Hz, half a period each way.
+	for (int8_t bit = 7; bit >= 0; --bit)
+	{
+		w.set(GB_SC, false);
+		w.setPins(PIN(GB_SO) | PIN(GB_SI), ((out >> bit) & 1 ? PIN(GB_SO) : 0) | ((in >> bit) & 1 ? PIN(GB_SI) : 0));
+		w.hold(61035);
+		w.set(GB_SC, true);
+		w.hold(61035);
+	}
+	w.hold(500000);
+}
+
+// A printer packet is magic, command, compression, length, data and checksum
+// from the Game Boy, then two zero bytes during which the printer answers
+// with its 0x81 alive byte and its status.
+void gbPrinterPacket(Waveform& w, uint8_t command, const uint8_t data[], uint16_t length, uint8_t status)
+{
+	uint16_t checksum = command + (length & 0xFF) + (length >> 8);
+	for (uint16_t i = 0; i < length; ++i)
+		checksum += data[i];
+
+	const uint8_t header[6] = { 0x88, 0x33, command, 0x00, (uint8_t)length, (uint8_t)(length >> 8) };
+	for (uint8_t i = 0; i < 6; ++i)
+		gbLinkByte(w, header[i], 0x00);
+	for (uint16_t i = 0; i < length; ++i)
+		gbLinkByte(w, data[i], 0x00);
+	gbLinkByte(w, (uint8_t)checksum, 0x00);
+	gbLinkByte(w, (uint8_t)(checksum >> 8), 0x00);
+	gbLinkByte(w, 0x00, 0x81);
+	gbLinkByte(w, 0x00, status);
+}
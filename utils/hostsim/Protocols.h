@@ -0,0 +1,93 @@
+//
+// Protocols.h
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef Protocols_h
+#define Protocols_h
+
+#include "Waveform.h"
+
+// Console side waveforms for the buses the spies decode, one poll per call.
+// Pins are Uno digital pins as wired in config_arduino.h, so the traces can
+// be fed straight to hostsim.  Timings are nominal values for the real
+// consoles and are all stretched by the waveform's clock scale.
+
+// NES and SNES shift registers: latch (D3), clock (D6), data (D4, NES also
+// D2 and D5), all active low.  Bit n of line l is bit l * 8 + n of state for
+// the NES; the SNES clocks out bits bits of state.
+#define NES_IDLE_PINS		0x74
+void nesPoll(Waveform& w, uint32_t state);
+void snesPoll(Waveform& w, uint32_t state, uint8_t bits);
+
+// Joybus (N64 on D2, GameCube on D5): 4 us cells, a 1 is 1 us low, a 0 is
+// 3 us low, every message ends in a stop bit.  Bytes go out MSB first.
+#define N64_IDLE_PINS		0x04
+#define GC_IDLE_PINS		0x20
+void joybusTransfer(Waveform& w, uint8_t pin, const uint8_t command[], uint8_t commandLength,
+	const uint8_t reply[], uint8_t replyLength);
+
+// PlayStation SIO: ATT (D2) frames the poll, CLOCK (D3) runs at 250 kHz,
+// data changes on the falling edge and is sampled on the rising edge, LSB
+// first.  ACK (D4) pulses after every byte but the last.  command goes out
+// on CMD (D5) and reply comes back on DATA (D6), length bytes each.
+#define PSX_IDLE_PINS		0x7C
+void psxTransfer(Waveform& w, const uint8_t command[], const uint8_t reply[], uint8_t length);
+
+// Genesis six button pad: select (TH) on D8, the pad answers on D2-D7.
+// state is pressed buttons, bit 0 up to bit 11 in the order U D L R B C A
+// Start Z Y X Mode.
+#define GENESIS_IDLE_PINS	0x1FC
+void genesisPoll(Waveform& w, uint16_t state);
+
+// Saturn digital pad: S0 (D6) and S1 (D7) select one of four nibbles, the
+// pad answers on D2-D5.  state holds the four nibbles in the order the spy
+// reads them (S1 only, S0 only, neither, both), a set bit pulls its line
+// low.
+#define SATURN_IDLE_PINS	0xFC
+void saturnPoll(Waveform& w, uint16_t state);
+
+// Dreamcast Maple bus on D2 (A) and D3 (B) as driven by maple_out.pio: a
+// start sequence, the frame word, payload words and the CRC, each bit taking
+// nsPerBit with clock and data swapping between A and B.
+#define MAPLE_IDLE_PINS		0x0C
+void maplePacket(Waveform& w, uint8_t command, uint8_t recipient, uint8_t sender,
+	const uint32_t payload[], uint8_t words, uint32_t nsPerBit = 480);
+
+// Apple Desktop Bus (Pippin) on D2: attention, sync, command byte and stop
+// bit from the host, then after the stop to start time the device's start
+// bit, length data bytes and stop bit.  A length of 0 sends the command
+// alone, as for a device that does not answer.
+#define ADB_IDLE_PINS		0x04
+void adbTransfer(Waveform& w, uint8_t command, const uint8_t data[], uint8_t length);
+uint8_t adbTalk(uint8_t address, uint8_t reg);
+
+// Game Boy link cable as wired to the printer emulator: SC on D2, the
+// printer's SI on D3 and the Game Boy's SO on D4.  8192 Hz, MSB first, the
+// Game Boy drives the clock and both sides shift at the same time.
+#define GBLINK_IDLE_PINS	0x1C
+void gbLinkByte(Waveform& w, uint8_t out, uint8_t in);
+void gbPrinterPacket(Waveform& w, uint8_t command, const uint8_t data[], uint16_t length, uint8_t status);
+
+#endif
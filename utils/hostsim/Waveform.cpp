@@ -0,0 +1,80 @@
+//
+// Waveform.cpp
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Waveform.h"
+
+#include <inttypes.h>
+
+Waveform::Waveform(uint32_t idlePins, double clockScale, uint32_t jitter, uint32_t seed)
+	: state(idlePins), now(0), scale(clockScale), jitter(jitter), seed(seed != 0 ? seed : 1)
+{
+	Edge first = { 0, idlePins };
+	edges.push_back(first);
+}
+
+uint32_t Waveform::random()
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+void Waveform::set(uint8_t pin, bool high)
+{
+	setPins(1UL << pin, high ? 1UL << pin : 0);
+}
+
+void Waveform::setPins(uint32_t mask, uint32_t values)
+{
+	uint32_t next = (state & ~mask) | (values & mask);
+	if (next == state)
+		return;
+	state = next;
+
+	int64_t at = (int64_t)now;
+	if (jitter != 0)
+		at += (int64_t)(random() % (2 * jitter + 1)) - jitter;
+	if (at <= (int64_t)edges.back().ns)
+		at = edges.back().ns + 1;
+
+	Edge e = { (uint64_t)at, state };
+	edges.push_back(e);
+}
+
+void Waveform::hold(double ns)
+{
+	now += (uint64_t)(ns * scale + 0.5);
+}
+
+void Waveform::write(FILE* f) const
+{
+	for (size_t i = 0; i < edges.size(); ++i)
+		fprintf(f, "%" PRIu64 " %05" PRIx32 "\n", edges[i].ns, edges[i].pins);
+
+	uint64_t end = now > edges.back().ns ? now : edges.back().ns + 1;
+	fprintf(f, "%" PRIu64 " %05" PRIx32 "\n", end, state);
+}
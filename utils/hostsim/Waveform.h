@@ -0,0 +1,74 @@
+//
+// Waveform.h
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef Waveform_h
+#define Waveform_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+// Builds a pin trace for HostSim one edge at a time.  Protocol code sets
+// pins and holds them for nominal durations; the waveform scales every hold
+// by the clock factor and moves every edge by up to +/- jitter nanoseconds,
+// never letting two edges swap.  The jitter comes from a seeded xorshift so
+// the same arguments always give the same trace.
+class Waveform {
+public:
+	Waveform(uint32_t idlePins, double clockScale = 1.0, uint32_t jitter = 0, uint32_t seed = 1);
+
+	void set(uint8_t pin, bool high);
+	void setPins(uint32_t mask, uint32_t values);
+	uint32_t pins() const { return state; }
+
+	// Waits ns (times the clock scale) with the pins as they are.
+	void hold(double ns);
+
+	// Waits ns exactly, for gaps between polls that should not scale.
+	void idle(uint64_t ns) { now += ns; }
+
+	uint64_t time() const { return now; }
+
+	// One line per edge, plus a final line marking the end of the trace.
+	void write(FILE* f) const;
+
+private:
+	struct Edge {
+		uint64_t ns;
+		uint32_t pins;
+	};
+
+	uint32_t random();
+
+	std::vector<Edge> edges;
+	uint32_t state;
+	uint64_t now;
+	double scale;
+	uint32_t jitter;
+	uint32_t seed;
+};
+
+#endif
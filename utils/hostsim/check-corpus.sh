@@ -0,0 +1,42 @@
+#!/bin/sh
+# Runs every case of the committed golden corpus (see synth.cpp) that a host
+# spy decodes through hostsim, comparing its output byte for byte with the
+# stored .expected file, feeding it <case>.input as host commands where
+# there is one.  Then checks that synth still writes the same
+# corpus, so a change to the waveforms cannot slip through either.
+#
+#     ./check-corpus.sh [dir]
+
+dir=${1:-corpus}
+if [ ! -f "$dir/corpus.txt" ]; then
+	echo "$dir/corpus.txt missing" >&2
+	exit 1
+fi
+
+status=0
+while read name spy; do
+	if [ "$spy" = "-" ]; then
+		echo "skip $name (no host spy)"
+		continue
+	fi
+	input=
+	if [ -f "$dir/$name.input" ]; then
+		input="-i $dir/$name.input"
+	fi
+	if ./hostsim -q $input "$spy" "$dir/$name.trace" | cmp -s - "$dir/$name.expected"; then
+		echo "ok   $name"
+	else
+		echo "FAIL $name"
+		status=1
+	fi
+done < "$dir/corpus.txt"
+
+fresh=$(mktemp -d) || exit 1
+if ./synth -c "$fresh" > /dev/null && diff -r "$dir" "$fresh" > /dev/null; then
+	echo "ok   synth reproduces $dir"
+else
+	echo "FAIL synth no longer reproduces $dir"
+	status=1
+fi
+rm -rf "$fresh"
+exit $status
@@ -0,0 +1,249 @@
+//
+// main.cpp
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Runs one spy against a pin trace and captures what it would have sent to
+// the host.
+//
+//     hostsim [-c ns] [-i commands] [-o output] [-q] <spy> <trace>
+//
+//     -c ns        simulated cost of a port read (default 250, 4 cycles)
+//     -i commands  file fed to the spy as serial input, e.g. "R60\n"
+//     -o output    where the spy's serial output goes (default stdout)
+//     -q           no statistics on stderr
+//
+// The output is byte for byte what the spy writes, so two runs can be
+// compared with cmp.  The statistics line gives the simulated time, the
+// frames (newlines) written and the host CPU time per frame, which is what
+// to watch when benchmarking a decoder change.  A second line gives the
+// spy's own counters (see SpyStats.h) as the S command would report them.
+
+#include "Arduino.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include "NES.h"
+#include "SNES.h"
+#include "N64.h"
+#include "N64Slow.h"
+#include "GC.h"
+#include "GBA.h"
+#include "BoosterGrip.h"
+#include "Genesis.h"
+#include "GenesisMouse.h"
+#include "SMS.h"
+#include "SMSPaddle.h"
+#include "SMSSportsPad.h"
+#include "Saturn.h"
+#include "Saturn3D.h"
+#include "FMTowns.h"
+#include "Intellivision.h"
+#include "Jaguar.h"
+#include "NeoGeo.h"
+#include "PCFX.h"
+#include "PlayStation.h"
+#include "PowerGlove.h"
+#include "TG16.h"
+#include "ThreeDO.h"
+#include "GameBoyPrinterEmulator.h"
+
+#include "SpyRegistry.h"
+
+// Spies that only need the pins.  The ones built on the ADC, timers or
+// third party libraries are left out until the simulator models those.
+typedef SpyRegistry<
+	SpyMode<0x00, NESSpy>,
+	SpyMode<0x01, SNESSpy>,
+	SpyMode<0x02, N64Spy>,
+	SpyMode<0x03, N64Slow>,
+	SpyMode<0x04, GCSpy>,
+	SpyMode<0x05, GBASpy>,
+	SpyMode<0x06, BoosterGripSpy>,
+	SpyMode<0x07, GenesisSpy>,
+	SpyMode<0x08, GenesisMouseSpy>,
+	SpyMode<0x09, SMSSpy>,
+	SpyMode<0x0A, SMSPaddleSpy>,
+	SpyMode<0x0B, SMSSportsPadSpy>,
+	SpyMode<0x0C, SaturnSpy>,
+	SpyMode<0x0D, Saturn3DSpy>,
+	SpyMode<0x0E, FMTownsSpy>,
+	SpyMode<0x0F, IntellivisionSpy>,
+	SpyMode<0x10, JaguarSpy>,
+	SpyMode<0x11, NeoGeoSpy>,
+	SpyMode<0x12, PCFXSpy>,
+	SpyMode<0x13, PlayStationSpy>,
+	SpyMode<0x14, PowerGloveSpy>,
+	SpyMode<0x15, TG16Spy>,
+	SpyMode<0x16, ThreeDOSpy>,
+	SpyMode<0x17, GameBoyPrinterEmulator>> Spies;
+
+static const struct {
+	const char* name;
+	uint8_t id;
+} spyNames[] = {
+	{ "nes", 0x00 },
+	{ "snes", 0x01 },
+	{ "n64", 0x02 },
+	{ "n64slow", 0x03 },
+	{ "gc", 0x04 },
+	{ "gba", 0x05 },
+	{ "boostergrip", 0x06 },
+	{ "genesis", 0x07 },
+	{ "genesismouse", 0x08 },
+	{ "sms", 0x09 },
+	{ "smspaddle", 0x0A },
+	{ "smssportspad", 0x0B },
+	{ "saturn", 0x0C },
+	{ "saturn3d", 0x0D },
+	{ "fmtowns", 0x0E },
+	{ "intellivision", 0x0F },
+	{ "jaguar", 0x10 },
+	{ "neogeo", 0x11 },
+	{ "pcfx", 0x12 },
+	{ "playstation", 0x13 },
+	{ "powerglove", 0x14 },
+	{ "tg16", 0x15 },
+	{ "3do", 0x16 },
+	{ "gbp", 0x17 },
+};
+
+static Spies::Arena spyArena;
+
+static void usage(const char* prog)
+{
+	fprintf(stderr, "Usage: %s [-c ns] [-i commands] [-o output] [-q] <spy> <trace>\n", prog);
+	fprintf(stderr, "Spies:");
+	for (size_t i = 0; i < sizeof(spyNames) / sizeof(spyNames[0]); ++i)
+		fprintf(stderr, " %s", spyNames[i].name);
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv)
+{
+	bool quiet = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "c:i:o:q")) != -1)
+	{
+		switch (opt)
+		{
+		case 'c':
+			hostSim.setReadCost(atoi(optarg));
+			break;
+		case 'i':
+			Serial.in = fopen(optarg, "rb");
+			if (Serial.in == NULL)
+			{
+				perror(optarg);
+				return 1;
+			}
+			break;
+		case 'o':
+			Serial.out = fopen(optarg, "wb");
+			if (Serial.out == NULL)
+			{
+				perror(optarg);
+				return 1;
+			}
+			break;
+		case 'q':
+			quiet = true;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (argc - optind != 2)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	const char* name = argv[optind];
+	int id = -1;
+	for (size_t i = 0; i < sizeof(spyNames) / sizeof(spyNames[0]); ++i)
+		if (strcmp(spyNames[i].name, name) == 0)
+			id = spyNames[i].id;
+	if (id < 0)
+	{
+		fprintf(stderr, "%s: unknown spy\n", name);
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (!hostSim.load(argv[optind + 1]))
+		return 1;
+
+	Serial.begin(115200);
+	uint64_t start = hostSim.nanos();
+	clock_t cpu = clock();
+	try
+	{
+		bool customSetup = false;
+		ControllerSpy* spy = Spies::create(spyArena, id, customSetup);
+		if (!customSetup)
+			spy->setup();
+
+		// Charge a read per pass as well, so a spy that returns without
+		// touching the pins still moves towards the end of the trace.
+		for (;;)
+		{
+			Spies::loop(spy);
+			hostSim.readPins();
+		}
+	}
+	catch (HostSim::TraceEnd&)
+	{
+	}
+	cpu = clock() - cpu;
+	Serial.flush();
+
+	if (!quiet)
+	{
+		double seconds = (double)cpu / CLOCKS_PER_SEC;
+		fprintf(stderr, "%s: %u frames, %llu bytes in %.3f s simulated, %.3f s cpu",
+			name, (unsigned)Serial.frames, (unsigned long long)Serial.bytes, (hostSim.nanos() - start) / 1e9, seconds);
+		if (Serial.frames > 0)
+			fprintf(stderr, ", %.1f us/frame", seconds * 1e6 / Serial.frames);
+		fprintf(stderr, "\n");
+		fprintf(stderr, "%s: %u polls, %u sync failures, %u us max masked, %u bytes max queued, %u serial stalls\n",
+			name, (unsigned)spyStats.polls, (unsigned)spyStats.syncFailures, (unsigned)spyStats.maxMasked,
+			(unsigned)spyStats.serialQueued, (unsigned)spyStats.serialStalls);
+#if defined(PROFILE_IRQ)
+		for (const IrqSite* s = spyStats.profiledSites(); s != NULL; s = s->next)
+		{
+			const char* file = strrchr(s->file, '/');
+			fprintf(stderr, "%s: %s:%u %u windows, %u us max, bins", name, file != NULL ? file + 1 : s->file,
+				(unsigned)s->line, (unsigned)s->count, (unsigned)s->maxTicks);
+			for (int i = 0; i < IRQ_PROFILE_BINS; ++i)
+				fprintf(stderr, " %u", (unsigned)s->bins[i]);
+			fprintf(stderr, "\n");
+		}
+#endif
+	}
+	return 0;
+}
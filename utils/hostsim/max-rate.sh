@@ -0,0 +1,58 @@
+#!/bin/sh
+# Finds the highest poll rate at which a spy still reports every poll
+# correctly.  The rate doubles from 60 Hz until the output stops matching
+# what synth expects, then is bisected to within 2%.
+#
+#     ./max-rate.sh [-j ns] [-k scale] <protocol>
+#
+# The options are passed on to synth.  The answer is for the simulated Uno,
+# a real board is usually a little slower.
+
+opts=
+while [ $# -gt 1 ]; do
+	opts="$opts $1 $2"
+	shift 2
+done
+protocol=$1
+spy=$(./synth -l | awk -v p="$protocol" '$1 == p { print $2 }')
+if [ -z "$spy" ] || [ "$spy" = "-" ]; then
+	echo "$protocol: no host spy decodes this protocol" >&2
+	exit 1
+fi
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+keepsUp() {
+	./synth $opts -n 100 -r "$1" -o "$tmp/trace" -e "$tmp/expected" "$protocol" &&
+		./hostsim -q "$spy" "$tmp/trace" | cmp -s - "$tmp/expected"
+}
+
+if ! keepsUp 60; then
+	echo "$protocol: fails at 60 Hz" >&2
+	exit 1
+fi
+
+low=60
+high=
+while [ -z "$high" ]; do
+	if [ "$low" -ge 1000000 ]; then
+		echo "$protocol: keeps up at $low Hz, the bus itself is the limit"
+		exit 0
+	fi
+	if keepsUp $((low * 2)); then
+		low=$((low * 2))
+	else
+		high=$((low * 2))
+	fi
+done
+
+while [ $((high - low)) -gt $((low / 50)) ]; do
+	mid=$(((low + high) / 2))
+	if keepsUp $mid; then
+		low=$mid
+	else
+		high=$mid
+	fi
+done
+echo "$protocol: $low Hz"
@@ -0,0 +1,718 @@
+//
+// synth.cpp
+//
+// Author:
+//       Christopher "Zoggins" Mallery <zoggins@retro-spy.com>
+//
+// Copyright (c) 2020 RetroSpy Technologies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Synthesizes console side pin traces for hostsim, together with what the
+// spy decoding them should send to the host.
+//
+//     synth [-r hz] [-n polls] [-j ns] [-k scale] [-s seed] [-o trace] [-e expected] <protocol> [state...]
+//     synth -c dir
+//     synth -l
+//
+//     -r hz        polls per second (default 60)
+//     -n polls     number of polls when no states are given (default 16)
+//     -j ns        move every edge by up to this much either way
+//     -k scale     stretch every bus timing, 0.5 runs the bus twice as fast
+//     -s seed      seed for the random states and the jitter
+//     -o trace     where the trace goes (default stdout)
+//     -e expected  write the spy's expected serial output here
+//     -c dir       write the golden corpus into dir
+//     -l           list the protocols and the spy that decodes each
+//
+// States are hex, one per poll, in the layout given in Protocols.h (for
+// psxanalog the buttons followed by the four axis bytes, for maple the
+// controller's two condition words).  Without states each poll gets a random
+// one.  Protocols whose spy cannot run on the host (maple, adb, gblink) only
+// get the trace.
+
+#include "Protocols.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+// Serial framing, as in common.h.
+#define ZERO	'\0'
+#define ONE		'1'
+#define SPLIT	'\n'
+
+// Appends count bits of value starting at bit first, LSB first.
+static void appendBits(std::string& out, uint64_t value, uint8_t first, uint8_t count)
+{
+	for (uint8_t i = first; i < first + count; ++i)
+		out += (value >> i) & 1 ? ONE : ZERO;
+}
+
+// Appends count bits of value starting at its top bit, as they came off the
+// wire.
+static void appendBitsMsbFirst(std::string& out, uint64_t value, uint8_t count)
+{
+	for (int8_t i = count - 1; i >= 0; --i)
+		out += (value >> i) & 1 ? ONE : ZERO;
+}
+
+static void appendBytes(std::string& out, const uint8_t bytes[], uint8_t count)
+{
+	for (uint8_t i = 0; i < count; ++i)
+		appendBits(out, bytes[i], 0, 8);
+}
+
+static void msbFirstBytes(uint8_t bytes[], uint64_t value, uint8_t count)
+{
+	for (uint8_t i = 0; i < count; ++i)
+		bytes[i] = (uint8_t)(value >> ((count - 1 - i) * 8));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void nes(Waveform& w, uint64_t state)
+{
+	nesPoll(w, (uint32_t)state);
+}
+
+static void nesExpect(std::string& out, uint64_t state)
+{
+	appendBits(out, state, 0, 24);
+	out += SPLIT;
+}
+
+// Bit 15 or 13 set asks for a second 16 bits, as sent by the mouse and the
+// NTT pad.
+static uint8_t snesBits(uint64_t state)
+{
+	return (state & 0xA000) != 0 ? 32 : 16;
+}
+
+static void snes(Waveform& w, uint64_t state)
+{
+	snesPoll(w, (uint32_t)state, snesBits(state));
+}
+
+// The spy throws away reports with bits 15 and 0 both set.
+static void snesExpect(std::string& out, uint64_t state)
+{
+	if ((state & 0x8001) == 0x8001)
+		return;
+	appendBits(out, state, 0, snesBits(state));
+	out += SPLIT;
+}
+
+static void n64(Waveform& w, uint64_t state)
+{
+	static const uint8_t poll[1] = { 0x01 };
+	uint8_t reply[4];
+	msbFirstBytes(reply, state, 4);
+	joybusTransfer(w, 2, poll, 1, reply, 4);
+}
+
+static void n64Expect(std::string& out, uint64_t state)
+{
+	appendBitsMsbFirst(out, state, 32);
+	out += SPLIT;
+}
+
+// Identify and poll, the way games probe the port.  The spy rests for 2 ms
+// after anything that is not a poll.
+static void n64Info(Waveform& w, uint64_t state)
+{
+	static const uint8_t info[1] = { 0x00 };
+	static const uint8_t id[3] = { 0x05, 0x00, 0x01 };
+	joybusTransfer(w, 2, info, 1, id, 3);
+	w.idle(3000000);
+	n64(w, state);
+}
+
+static void gc(Waveform& w, uint64_t state)
+{
+	static const uint8_t poll[3] = { 0x40, 0x03, 0x00 };
+	uint8_t reply[8];
+	msbFirstBytes(reply, state, 8);
+	joybusTransfer(w, 5, poll, 3, reply, 8);
+}
+
+static void gcExpect(std::string& out, uint64_t state)
+{
+	appendBitsMsbFirst(out, state, 64);
+	out += SPLIT;
+}
+
+static void gcKeyboard(Waveform& w, uint64_t state)
+{
+	static const uint8_t poll[3] = { 0x54, 0x00, 0x00 };
+	uint8_t reply[8];
+	msbFirstBytes(reply, state, 8);
+	joybusTransfer(w, 5, poll, 3, reply, 8);
+}
+
+// Three key codes out of bytes 4-6, with 10 moved to 11 to keep it off the
+// frame separator.
+static void gcKeyboardExpect(std::string& out, uint64_t state)
+{
+	uint8_t reply[8];
+	msbFirstBytes(reply, state, 8);
+	for (uint8_t i = 4; i < 7; ++i)
+		out += (char)(reply[i] == 10 ? 11 : reply[i]);
+	out += SPLIT;
+}
+
+static void psxPoll(Waveform& w, uint8_t type, uint16_t buttons, const uint8_t extra[], uint8_t extraLength)
+{
+	uint8_t command[5 + 16] = { 0x01, 0x42, 0x00, 0x00, 0x00 };
+	uint8_t reply[5 + 16] = { 0xFF, type, 0x5A, (uint8_t)~buttons, (uint8_t)(~buttons >> 8) };
+	memcpy(reply + 5, extra, extraLength);
+	psxTransfer(w, command, reply, 5 + extraLength);
+}
+
+// Type, buttons, the analog bytes and the rumble bytes the console sent.
+static void psxExpect(std::string& out, uint8_t type, uint16_t buttons, const uint8_t extra[], uint8_t extraLength)
+{
+	uint8_t frame[21] = { type, (uint8_t)buttons, (uint8_t)(buttons >> 8) };
+	memcpy(frame + 3, extra, extraLength);
+	appendBytes(out, frame, 21);
+	out += SPLIT;
+}
+
+static void psx(Waveform& w, uint64_t state)
+{
+	psxPoll(w, 0x41, (uint16_t)state, NULL, 0);
+}
+
+static void psxExpectDigital(std::string& out, uint64_t state)
+{
+	psxExpect(out, 0x41, (uint16_t)state, NULL, 0);
+}
+
+static void psxAnalog(Waveform& w, uint64_t state)
+{
+	uint8_t axes[4];
+	for (uint8_t i = 0; i < 4; ++i)
+		axes[i] = (uint8_t)(state >> (16 + i * 8));
+	psxPoll(w, 0x73, (uint16_t)state, axes, 4);
+}
+
+static void psxExpectAnalog(std::string& out, uint64_t state)
+{
+	uint8_t axes[4];
+	for (uint8_t i = 0; i < 4; ++i)
+		axes[i] = (uint8_t)(state >> (16 + i * 8));
+	psxExpect(out, 0x73, (uint16_t)state, axes, 4);
+}
+
+static void genesis(Waveform& w, uint64_t state)
+{
+	genesisPoll(w, (uint16_t)state);
+}
+
+// Controller present, then the buttons in poll order.
+static void genesisExpect(std::string& out, uint64_t state)
+{
+	out += ONE;
+	appendBits(out, state, 0, 12);
+	out += SPLIT;
+}
+
+// A pad can not hold both up and down (or left and right) and the six button
+// handshake needs one of Z, Y, X and Mode released.
+static uint64_t genesisValid(uint64_t state)
+{
+	state &= 0xFFF;
+	if ((state & 0x003) == 0x003)
+		state &= ~0x002;
+	if ((state & 0x00C) == 0x00C)
+		state &= ~0x008;
+	if ((state & 0xF00) == 0xF00)
+		state &= ~0x800;
+	return state;
+}
+
+static void saturn(Waveform& w, uint64_t state)
+{
+	saturnPoll(w, (uint16_t)state);
+}
+
+// A released button reads high and is sent as ONE, each nibble from its top
+// line down, and of the last nibble only L.
+static void saturnExpect(std::string& out, uint64_t state)
+{
+	for (uint8_t i = 0; i < 8; ++i)
+		out += i == 6 ? ONE : ZERO;
+	for (uint8_t nibble = 0; nibble < 3; ++nibble)
+		for (int8_t line = 3; line >= 0; --line)
+			out += (state >> (nibble * 4 + line)) & 1 ? ZERO : ONE;
+	out += (state >> 15) & 1 ? ZERO : ONE;
+	out += ONE;
+	out += ONE;
+	out += ONE;
+	for (uint8_t i = 0; i < 32; ++i)
+		out += ZERO;
+	out += SPLIT;
+}
+
+// Get condition to the controller in port A and its answer.
+static void maple(Waveform& w, uint64_t state)
+{
+	static const uint32_t controller[1] = { 0x00000001 };
+	maplePacket(w, 0x09, 0x20, 0x00, controller, 1);
+	w.hold(20000);
+	const uint32_t condition[3] = { 0x00000001, (uint32_t)state, (uint32_t)(state >> 32) };
+	maplePacket(w, 0x08, 0x00, 0x20, condition, 3);
+}
+
+// Talk register 0 to the Pippin controller at its default address.
+static void adb(Waveform& w, uint64_t state)
+{
+	uint8_t reply[4];
+	msbFirstBytes(reply, state, 4);
+	adbTransfer(w, adbTalk(0xF, 0), reply, 4);
+}
+
+// An inquiry, answered with the state as the printer's status byte.
+static void gbLink(Waveform& w, uint64_t state)
+{
+	gbPrinterPacket(w, 0x0F, NULL, 0, (uint8_t)state);
+}
+
+// The printer emulator in packet capture mode.  Bit 8 set sends a print
+// data packet of eight bytes that stops after one to seven of them,
+// otherwise an inquiry, which the emulator answers itself with an idle
+// status.  Either way the link then idles until the printer times out and
+// reports.  gbprinterbin switches the emulator to binary records with 'b'
+// first.
+#define GBPRINTER_CUT_LENGTH	8
+#define GBPRINTER_TIMEOUT_NS	600000000ULL
+#define GBPRINTER_WATERLINE		6	// Packets are held until their header is in
+#define GBPRINTER_BUFFER		1024
+
+static const char gbPrinterBanner[] =
+	"// GAMEBOY PRINTER Packet Capture V3.2.1 (Copyright (C) 2022 Brian Khuu)\n"
+	"// Note: Each byte is from each GBP packet is from the gameboy\n"
+	"//       except for the last two bytes which is from the printer\n"
+	"// JS Raw Packet Decoder: https://mofosyne.github.io/arduino-gameboy-printer-emulator/GameBoyPrinterDecoderJS/gameboy_printer_js_raw_decoder.html\n"
+	"// --- GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007 ---\n"
+	"// This program comes with ABSOLUTELY NO WARRANTY;\n"
+	"// This is free software, and you are welcome to redistribute it\n"
+	"// under certain conditions. Refer to LICENSE file for detail.\n"
+	"// ---\n";
+
+static const uint8_t gbPrinterInquiry[10] = { 0x88, 0x33, 0x0F, 0x00, 0x00, 0x00, 0x0F, 0x00, 0x81, 0x00 };
+
+// Complete packets and bytes the emulator has seen, for its trailers.
+static uint32_t gbPrinterPackets;
+static uint32_t gbPrinterBytes;
+
+static uint8_t gbPrinterCut(uint64_t state, uint8_t bytes[])
+{
+	const uint8_t header[6] = { 0x88, 0x33, 0x04, 0x00, GBPRINTER_CUT_LENGTH, 0x00 };
+	memcpy(bytes, header, sizeof(header));
+	uint8_t length = sizeof(header) + 1 + state % (GBPRINTER_CUT_LENGTH - 1);
+	for (uint8_t i = sizeof(header); i < length; ++i)
+		bytes[i] = (uint8_t)(state + i - sizeof(header));
+	return length;
+}
+
+static void gbPrinter(Waveform& w, uint64_t state)
+{
+	if (!(state & 0x100))
+		gbPrinterPacket(w, 0x0F, NULL, 0, 0x00);
+	else
+	{
+		uint8_t bytes[6 + GBPRINTER_CUT_LENGTH];
+		uint8_t length = gbPrinterCut(state, bytes);
+		for (uint8_t i = 0; i < length; ++i)
+			gbLinkByte(w, bytes[i], 0x00);
+	}
+	w.idle(GBPRINTER_TIMEOUT_NS);
+}
+
+static void appendHex(std::string& out, const uint8_t bytes[], uint8_t count)
+{
+	static const char digits[] = "0123456789ABCDEF";
+	for (uint8_t i = 0; i < count; ++i)
+	{
+		if (i != 0)
+			out += ' ';
+		out += digits[bytes[i] >> 4];
+		out += digits[bytes[i] & 0xF];
+	}
+}
+
+static void gbPrinterBegin(std::string& out)
+{
+	out += gbPrinterBanner;
+	gbPrinterPackets = 0;
+	gbPrinterBytes = 0;
+}
+
+static void gbPrinterExpect(std::string& out, uint64_t state)
+{
+	// A whole packet ends its line, a cut off one leaves the separator after
+	// its last byte.  The timeout report then starts a line of its own.
+	if (!(state & 0x100))
+	{
+		appendHex(out, gbPrinterInquiry, sizeof(gbPrinterInquiry));
+		out += '\n';
+	}
+	else
+	{
+		uint8_t bytes[6 + GBPRINTER_CUT_LENGTH];
+		appendHex(out, bytes, gbPrinterCut(state, bytes));
+		out += ' ';
+	}
+	char completed[64];
+	snprintf(completed, sizeof(completed), "\n// Completed (Memory Waterline: %uB out of %uB)\n",
+		GBPRINTER_WATERLINE, GBPRINTER_BUFFER);
+	out += completed;
+}
+
+// Binary records as in gbp_emulator_v2.cpp: sync, type, u16 length, payload
+// and a CRC-16/CCITT over all but the sync, inverted for a cut off packet.
+static void gbPrinterRecord(std::string& out, uint8_t type, const uint8_t payload[], uint16_t length, bool cut)
+{
+	uint8_t header[4] = { 0xA5, type, (uint8_t)length, (uint8_t)(length >> 8) };
+	std::string record((const char*)header, sizeof(header));
+	record.append((const char*)payload, length);
+
+	uint16_t crc = 0xFFFF;
+	for (size_t i = 1; i < record.size(); ++i)
+	{
+		crc ^= (uint16_t)(uint8_t)record[i] << 8;
+		for (uint8_t bit = 0; bit < 8; ++bit)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+	}
+	if (cut)
+		crc = ~crc;
+	out += record;
+	out += (char)(crc & 0xFF);
+	out += (char)(crc >> 8);
+}
+
+static void gbPrinterBeginBinary(std::string& out)
+{
+	gbPrinterBegin(out);
+	const uint8_t version = 1;
+	gbPrinterRecord(out, 'H', &version, 1, false);
+}
+
+static void gbPrinterExpectBinary(std::string& out, uint64_t state)
+{
+	if (!(state & 0x100))
+	{
+		gbPrinterRecord(out, 'P', gbPrinterInquiry, sizeof(gbPrinterInquiry), false);
+		++gbPrinterPackets;
+		gbPrinterBytes += sizeof(gbPrinterInquiry);
+	}
+	else
+	{
+		uint8_t bytes[10 + GBPRINTER_CUT_LENGTH] = { 0 };
+		gbPrinterBytes += gbPrinterCut(state, bytes);
+		gbPrinterRecord(out, 'P', bytes, sizeof(bytes), true);
+	}
+
+	const uint8_t trailer[12] = {
+		(uint8_t)gbPrinterPackets, (uint8_t)(gbPrinterPackets >> 8),
+		(uint8_t)(gbPrinterPackets >> 16), (uint8_t)(gbPrinterPackets >> 24),
+		(uint8_t)gbPrinterBytes, (uint8_t)(gbPrinterBytes >> 8),
+		(uint8_t)(gbPrinterBytes >> 16), (uint8_t)(gbPrinterBytes >> 24),
+		GBPRINTER_WATERLINE, 0, GBPRINTER_BUFFER & 0xFF, GBPRINTER_BUFFER >> 8
+	};
+	gbPrinterRecord(out, 'T', trailer, sizeof(trailer), false);
+}
+
+static uint64_t nesValid(uint64_t state) { return state & 0xFF; }
+static uint64_t snesValid(uint64_t state) { return state & 0x0FFF; }
+static uint64_t n64Valid(uint64_t state) { return state & 0xFFFFFFFF; }
+static uint64_t psxValid(uint64_t state) { return state & 0xFFFF; }
+static uint64_t psxAnalogValid(uint64_t state) { return state & 0xFFFFFFFFFFFFULL; }
+static uint64_t saturnValid(uint64_t state) { return state & 0xFFFF; }
+static uint64_t anyState(uint64_t state) { return state; }
+static uint64_t byteState(uint64_t state) { return state & 0xFF; }
+
+static const struct Protocol {
+	const char* name;
+	const char* spy;
+	uint32_t idle;
+	uint64_t (*valid)(uint64_t state);
+	void (*poll)(Waveform& w, uint64_t state);
+	void (*expect)(std::string& out, uint64_t state);
+	void (*begin)(std::string& out);	// What the spy sends before the first poll
+	const char* input;					// Host commands the spy is given, if any
+	uint64_t lead;						// Idle bus before the first poll, 0 for 20 ms
+} protocols[] = {
+	{ "nes",        "nes",         NES_IDLE_PINS,     nesValid,       nes,        nesExpect },
+	{ "snes",       "snes",        NES_IDLE_PINS,     snesValid,      snes,       snesExpect },
+	{ "n64",        "n64",         N64_IDLE_PINS,     n64Valid,       n64,        n64Expect },
+	{ "n64info",    "n64",         N64_IDLE_PINS,     n64Valid,       n64Info,    n64Expect },
+	{ "gc",         "gc",          GC_IDLE_PINS,      anyState,       gc,         gcExpect },
+	{ "gckeyboard", "gc",          GC_IDLE_PINS,      anyState,       gcKeyboard, gcKeyboardExpect },
+	{ "psx",        "playstation", PSX_IDLE_PINS,     psxValid,       psx,        psxExpectDigital },
+	{ "psxanalog",  "playstation", PSX_IDLE_PINS,     psxAnalogValid, psxAnalog,  psxExpectAnalog },
+	{ "genesis",    "genesis",     GENESIS_IDLE_PINS, genesisValid,   genesis,    genesisExpect },
+	{ "saturn",     "saturn",      SATURN_IDLE_PINS,  saturnValid,    saturn,     saturnExpect },
+	{ "maple",      NULL,          MAPLE_IDLE_PINS,   anyState,       maple,      NULL },
+	{ "adb",        NULL,          ADB_IDLE_PINS,     n64Valid,       adb,        NULL },
+	{ "gblink",     NULL,          GBLINK_IDLE_PINS,  byteState,      gbLink,     NULL },
+	{ "gbprinter",    "gbp",       GBLINK_IDLE_PINS,  anyState,       gbPrinter,  gbPrinterExpect,
+		gbPrinterBegin, NULL, 100000000 },
+	{ "gbprinterbin", "gbp",       GBLINK_IDLE_PINS,  anyState,       gbPrinter,  gbPrinterExpectBinary,
+		gbPrinterBeginBinary, "b", 100000000 },
+};
+
+static const Protocol* findProtocol(const char* name)
+{
+	for (size_t i = 0; i < sizeof(protocols) / sizeof(protocols[0]); ++i)
+		if (strcmp(protocols[i].name, name) == 0)
+			return &protocols[i];
+	return NULL;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Options {
+	double rate;
+	unsigned polls;
+	uint32_t jitter;
+	double scale;
+	uint32_t seed;
+};
+
+static uint64_t nextRandom(uint64_t& seed)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 7;
+	seed ^= seed << 17;
+	return seed;
+}
+
+// Polls start every 1 / rate seconds after 20 ms of idle bus (the protocol's
+// lead if it needs longer for the spy to start up), or straight after the
+// last one when the bus can not keep up.  The trace runs on for
+// 20 ms so the spy can finish the last report.
+static bool synthesize(const Protocol& p, const Options& o, const std::vector<uint64_t>& given,
+	FILE* trace, FILE* expected)
+{
+	Waveform w(p.idle, o.scale, o.jitter, o.seed);
+	std::string out;
+	uint64_t seed = o.seed * 0x9E3779B97F4A7C15ULL + 1;
+	unsigned polls = given.empty() ? o.polls : given.size();
+	double period = 1e9 / o.rate;
+	uint64_t lead = p.lead != 0 ? p.lead : 20000000;
+
+	if (p.begin != NULL)
+		p.begin(out);
+	for (unsigned i = 0; i < polls; ++i)
+	{
+		uint64_t start = lead + (uint64_t)(i * period);
+		if (w.time() < start)
+			w.idle(start - w.time());
+
+		uint64_t state = given.empty() ? p.valid(nextRandom(seed)) : given[i];
+		p.poll(w, state);
+		if (p.expect != NULL)
+			p.expect(out, state);
+	}
+	w.idle(20000000);
+
+	w.write(trace);
+	if (expected != NULL)
+		fwrite(out.data(), 1, out.size(), expected);
+	return ferror(trace) == 0 && (expected == NULL || ferror(expected) == 0);
+}
+
+// The golden corpus: every protocol at its usual rate, plus the cases that
+// stress the decoders, jittered edges and buses running fast or slow.  It is
+// committed under corpus/, rewrite it with -c only when a change to synth or
+// a spy is meant to change it.
+//
+// n64info is left out: after a controller info the N64 spies send the
+// shortcut poll one bit earlier than this model expects, and which of the
+// two matches the hardware still needs a capture from a real console.
+static const struct {
+	const char* name;
+	const char* protocol;
+	Options options;
+} corpus[] = {
+	{ "nes",             "nes",        {   60, 32,    0, 1.0,  1 } },
+	{ "nes-jitter",      "nes",        {   60, 32, 1500, 1.0,  2 } },
+	{ "snes",            "snes",       {   60, 32,    0, 1.0,  3 } },
+	{ "snes-fast",       "snes",       {   60, 32,    0, 0.5,  4 } },
+	{ "n64",             "n64",        {   60, 32,    0, 1.0,  5 } },
+	{ "n64-jitter",      "n64",        {   60, 32,  200, 1.0,  6 } },
+	{ "n64-slow",        "n64",        {   60, 32,    0, 1.1,  7 } },
+	{ "gc",              "gc",         {   60, 32,    0, 1.0,  9 } },
+	{ "gc-jitter",       "gc",         {   60, 32,  200, 1.0, 10 } },
+	{ "gckeyboard",      "gckeyboard", {   60, 16,    0, 1.0, 12 } },
+	{ "psx",             "psx",        {   60, 32,    0, 1.0, 13 } },
+	{ "psx-fast",        "psx",        {   60, 32,    0, 0.5, 14 } },
+	{ "psxanalog",       "psxanalog",  {   60, 32,    0, 1.0, 15 } },
+	{ "psxanalog-jitter","psxanalog",  {   60, 32,  300, 1.0, 16 } },
+	{ "genesis",         "genesis",    {   60, 32,    0, 1.0, 17 } },
+	{ "saturn",          "saturn",     {   60, 32,    0, 1.0, 18 } },
+	{ "maple",           "maple",      {   60,  8,    0, 1.0, 19 } },
+	{ "adb",             "adb",        {   90,  8,    0, 1.0, 20 } },
+	{ "gblink",          "gblink",     {   20,  4,    0, 1.0, 21 } },
+	{ "gbprinter-cut",   "gbprinter",  {    1,  8,    0, 1.0, 22 } },
+	{ "gbprinter-cutbin","gbprinterbin",{  1,  8,    0, 1.0, 22 } },
+};
+
+static FILE* openOutput(const std::string& path)
+{
+	FILE* f = fopen(path.c_str(), "wb");
+	if (f == NULL)
+		perror(path.c_str());
+	return f;
+}
+
+// Writes <case>.trace and, for the protocols a host spy decodes,
+// <case>.expected and, if the spy is given host commands, <case>.input.
+// Lists "<case> <spy>" in corpus.txt ("-" for the trace only cases).
+static int writeCorpus(const char* dir)
+{
+	mkdir(dir, 0777);
+	std::string base(dir);
+	FILE* index = openOutput(base + "/corpus.txt");
+	if (index == NULL)
+		return 1;
+
+	for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); ++i)
+	{
+		const Protocol* p = findProtocol(corpus[i].protocol);
+		std::string name = base + "/" + corpus[i].name;
+		FILE* trace = openOutput(name + ".trace");
+		FILE* expected = p->expect != NULL ? openOutput(name + ".expected") : NULL;
+		if (trace == NULL || (p->expect != NULL && expected == NULL))
+			return 1;
+
+		bool ok = synthesize(*p, corpus[i].options, std::vector<uint64_t>(), trace, expected);
+		ok = fclose(trace) == 0 && ok;
+		if (expected != NULL)
+			ok = fclose(expected) == 0 && ok;
+		if (ok && p->input != NULL)
+		{
+			FILE* input = openOutput(name + ".input");
+			ok = input != NULL && fputs(p->input, input) >= 0;
+			ok = input != NULL && fclose(input) == 0 && ok;
+		}
+		if (!ok)
+		{
+			fprintf(stderr, "%s: write failed\n", name.c_str());
+			return 1;
+		}
+		fprintf(index, "%s %s\n", corpus[i].name, p->spy != NULL ? p->spy : "-");
+	}
+	return fclose(index) == 0 ? 0 : 1;
+}
+
+static void usage(const char* prog)
+{
+	fprintf(stderr, "Usage: %s [-r hz] [-n polls] [-j ns] [-k scale] [-s seed] [-o trace] [-e expected] <protocol> [state...]\n", prog);
+	fprintf(stderr, "       %s -c dir\n", prog);
+	fprintf(stderr, "       %s -l\n", prog);
+	fprintf(stderr, "Protocols:");
+	for (size_t i = 0; i < sizeof(protocols) / sizeof(protocols[0]); ++i)
+		fprintf(stderr, " %s", protocols[i].name);
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv)
+{
+	Options o = { 60, 16, 0, 1.0, 1 };
+	const char* tracePath = NULL;
+	const char* expectedPath = NULL;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:n:j:k:s:o:e:c:l")) != -1)
+	{
+		switch (opt)
+		{
+		case 'r':
+			o.rate = atof(optarg);
+			break;
+		case 'n':
+			o.polls = atoi(optarg);
+			break;
+		case 'j':
+			o.jitter = atoi(optarg);
+			break;
+		case 'k':
+			o.scale = atof(optarg);
+			break;
+		case 's':
+			o.seed = strtoul(optarg, NULL, 0);
+			break;
+		case 'o':
+			tracePath = optarg;
+			break;
+		case 'e':
+			expectedPath = optarg;
+			break;
+		case 'c':
+			return writeCorpus(optarg);
+		case 'l':
+			for (size_t i = 0; i < sizeof(protocols) / sizeof(protocols[0]); ++i)
+				printf("%s %s\n", protocols[i].name, protocols[i].spy != NULL ? protocols[i].spy : "-");
+			return 0;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (argc - optind < 1 || o.rate <= 0 || o.scale <= 0)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	const Protocol* p = findProtocol(argv[optind]);
+	if (p == NULL)
+	{
+		fprintf(stderr, "%s: unknown protocol\n", argv[optind]);
+		usage(argv[0]);
+		return 1;
+	}
+	if (expectedPath != NULL && p->expect == NULL)
+	{
+		fprintf(stderr, "%s: no spy decodes this on the host, only the trace is written\n", p->name);
+		expectedPath = NULL;
+	}
+
+	std::vector<uint64_t> states;
+	for (int i = optind + 1; i < argc; ++i)
+		states.push_back(strtoull(argv[i], NULL, 16));
+
+	FILE* trace = tracePath != NULL ? openOutput(tracePath) : stdout;
+	FILE* expected = expectedPath != NULL ? openOutput(expectedPath) : NULL;
+	if (trace == NULL || (expectedPath != NULL && expected == NULL))
+		return 1;
+
+	bool ok = synthesize(*p, o, states, trace, expected);
+	ok = fclose(trace) == 0 && ok;
+	if (expected != NULL)
+		ok = fclose(expected) == 0 && ok;
+	return ok ? 0 : 1;
+}
@@ -1,81 +1,228 @@
 /*********************************************************
- * 
- *   Receiving end of the GameBoy Link cable tester.
- * 
- *   PINOUT:  
- *            D8 to sending end D8
- *            D9 to sending end D9
+ *
+ *   Receiving end of the Vision flex cable throughput bench.
+ *
+ *   PINOUT:
+ *            Same GPIO numbers as vision_flex_test_server,
+ *            pin for pin.
  *            5V to sending end Vin
  *            GND to sending end GND
- *            
+ *
+ *   Samples the sequence number on every strobe and checks
+ *   that each frame counts up by one from 0 to 65535.  The
+ *   capture time of every value is compared with the time
+ *   the server scheduled its strobe, counted from the sync
+ *   rising edge.  The server's clock is scaled by how long
+ *   its previous frame took on ours, so crystal drift does
+ *   not show up as latency.
+ *
+ *   GP11 to GND at power up starts at 500 Hz, like the
+ *   server's slow mode.  Send R<hz> over serial to match
+ *   any other rate.
+ *   After each frame one CSV line is printed:
+ *
+ *     frame,rate_hz,received,missed,duplicated,reordered,
+ *       lat_min_us,lat_p50_us,lat_p99_us,lat_max_us
+ *
+ *   Latencies past the histogram are reported as its last
+ *   bin, lat_max_us is always exact.
+ *
  *********************************************************/
-static int count = 0;
+#include <hardware/timer.h>
 
-#define PINB_READ( pin ) (gpio_get(pin + 6))
-#define WAIT_LEADING_EDGEB( pin ) while( PINB_READ(pin) ){} while( !PINB_READ(pin) ){}
+#define SYNC_PIN     9
+#define STROBE_PIN   10
+#define SLOW_PIN     11
+
+#define SYNC_MASK    (1UL << SYNC_PIN)
+#define STROBE_MASK  (1UL << STROBE_PIN)
+
+#define LEAD_US      1000
+#define FRAME_LENGTH 65536UL
+#define LATENCY_BINS 64
+
+static uint32_t rateHz = 20000;
+static uint32_t frame = 0;
+
+// Server period in microseconds, 16.16 fixed point, corrected for drift.
+static uint64_t periodQ16;
+
+static uint32_t received, missed, duplicated, reordered;
+static int32_t latencyMin, latencyMax;
+static uint32_t latency[LATENCY_BINS];
+
+static inline uint16_t counterFrom(uint32_t pins)
+{
+  return (pins & 0x0001FF) | ((pins & 0x07F000) >> 3);
+}
+
+static void resetPeriod()
+{
+  periodQ16 = (65536ULL * 1000000UL) / rateHz;
+}
+
+static void pollCommands()
+{
+  while (Serial.available() > 0)
+  {
+    if (Serial.read() != 'R')
+      continue;
+
+    long hz = Serial.parseInt();
+    if (hz > 0)
+      rateHz = (uint32_t)hz;
+    resetPeriod();
+    Serial.print("# rate_hz,");
+    Serial.println(rateHz);
+  }
+}
+
+static inline void recordLatency(int32_t us)
+{
+  if (us < latencyMin)
+    latencyMin = us;
+  if (us > latencyMax)
+    latencyMax = us;
+
+  if (us < 0)
+    us = 0;
+  else if (us >= LATENCY_BINS)
+    us = LATENCY_BINS - 1;
+  ++latency[us];
+}
+
+static int32_t percentile(uint32_t percent)
+{
+  uint32_t wanted = (uint32_t)(((uint64_t)received * percent + 99) / 100);
+  uint32_t seen = 0;
+  for (int32_t i = 0; i < LATENCY_BINS; ++i)
+  {
+    seen += latency[i];
+    if (seen >= wanted)
+      return i;
+  }
+  return LATENCY_BINS - 1;
+}
 
 void setup()
 {
   for (int i = 0; i < 19; ++i)
   {
-	if (i != 11)
+	if (i != SLOW_PIN)
 	{
 		pinMode(i, INPUT);
 		digitalWrite(i, LOW);
 	}
   }
-  
-  pinMode(11, INPUT_PULLUP);
+
+  pinMode(SLOW_PIN, INPUT_PULLUP);
   pinMode(19, INPUT_PULLUP);
   pinMode(20, INPUT_PULLUP);
   pinMode(26, INPUT_PULLUP);
-  pinMode(27, INPUT_PULLUP);  
+  pinMode(27, INPUT_PULLUP);
 
   pinMode(28, OUTPUT);
   digitalWrite(28, LOW);
-  
+
   pinMode(21, OUTPUT);
   pinMode(22, OUTPUT);
   digitalWrite(21, HIGH);
   digitalWrite(22, HIGH);
 
   Serial.begin(115200);
+
+  if (digitalRead(SLOW_PIN) == LOW)
+    rateHz = 500;
+  resetPeriod();
+  Serial.println("frame,rate_hz,received,missed,duplicated,reordered,lat_min_us,lat_p50_us,lat_p99_us,lat_max_us");
 }
 
 void loop()
 {
-  while(true)
+  pollCommands();
+
+  received = missed = duplicated = reordered = 0;
+  latencyMin = INT32_MAX;
+  latencyMax = INT32_MIN;
+  memset(latency, 0, sizeof(latency));
+
+  uint64_t leadQ16 = (uint64_t)LEAD_US << 16;
+  uint16_t last = 0;
+  uint32_t pins;
+
+  while (gpio_get_all() & SYNC_MASK) {}
+  while (!(gpio_get_all() & SYNC_MASK)) {}
+  noInterrupts();
+  uint32_t start = time_us_32();
+
+  while (true)
   {
-    bool failure = false;
-    WAIT_LEADING_EDGEB(3);
-    noInterrupts();
-    for(int i = 0; i < 65536; ++i)
-    { 
-
-      WAIT_LEADING_EDGEB(4);
-  
-      int val = (gpio_get_all() & 0x0001FF) | ((gpio_get_all() & 0x07F000) >> 3);
-      
-      if (val != i)
-      {
-        interrupts();
-        Serial.print("FAILED ");
-        Serial.print(i);
-        Serial.print("!=");
-        Serial.print(val);
-        Serial.println(".");
-        digitalWrite(21, HIGH);
-        digitalWrite(22, LOW);
-        failure = true;
-      }
+    while ((pins = gpio_get_all()) & STROBE_MASK) {}
+    while (!((pins = gpio_get_all()) & STROBE_MASK))
+    {
+      if (!(pins & SYNC_MASK))
+        goto frameDone;
     }
-  
-    interrupts();
-    if (!failure)
+
+    uint32_t now = time_us_32();
+    uint16_t value = counterFrom(pins);
+
+    if (received == 0)
+      missed += value;
+    else
     {
-      Serial.print(1);
-      digitalWrite(21, LOW);
-      digitalWrite(22, HIGH);
+      uint16_t step = value - last;
+      if (step == 0)
+        ++duplicated;
+      else if (step < 0x8000)
+        missed += step - 1;
+      else
+        ++reordered;
     }
+    ++received;
+    last = value;
+
+    uint32_t dueUs = (uint32_t)((leadQ16 + value * periodQ16 + periodQ16 / 2) >> 16);
+    recordLatency((int32_t)(now - start - dueUs));
   }
+
+frameDone:
+  uint32_t span = time_us_32() - start;
+  interrupts();
+
+  if (received != 0)
+    missed += FRAME_LENGTH - 1 - last;
+
+  Serial.print(frame++);
+  Serial.print(",");
+  Serial.print(rateHz);
+  Serial.print(",");
+  Serial.print(received);
+  Serial.print(",");
+  Serial.print(missed);
+  Serial.print(",");
+  Serial.print(duplicated);
+  Serial.print(",");
+  Serial.print(reordered);
+  Serial.print(",");
+  if (received != 0)
+  {
+    Serial.print(latencyMin);
+    Serial.print(",");
+    Serial.print(percentile(50));
+    Serial.print(",");
+    Serial.print(percentile(99));
+    Serial.print(",");
+    Serial.println(latencyMax);
+  }
+  else
+    Serial.println(",,,");
+
+  // A clean frame times the server's clock for the next one.
+  if (received == FRAME_LENGTH && missed == 0 && span > LEAD_US)
+    periodQ16 = ((uint64_t)(span - LEAD_US) << 16) / FRAME_LENGTH;
+
+  bool failure = missed != 0 || duplicated != 0 || reordered != 0;
+  digitalWrite(21, failure ? HIGH : LOW);
+  digitalWrite(22, failure ? LOW : HIGH);
 }
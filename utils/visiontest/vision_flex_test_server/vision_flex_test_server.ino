@@ -1,95 +1,156 @@
 /*********************************************************
 
-     Sending end of the GameBoy Link cable tester.
+     Sending end of the Vision flex cable throughput bench.
 
-     PINOUT:
-              D11 to receiving end D11 is Latch
-              D12 to receiving end D12 is Clock
+     Drives a 16 bit sequence number across the flex cable at a
+     fixed rate, for vision_flex_test_endpoint to check.
+
+     PINOUT (both ends RP2040):
+              GP0-GP8   sequence bits 0-8
+              GP12-GP18 sequence bits 9-15
+              GP9       Sync, high for the whole frame
+              GP10      Strobe, rises half a period after each value
+              GP11      to GND at power up for 500 Hz slow mode
               Vin to receiving end 5V
               GND to receiving end GND
 
+     Every frame sends 0 to 65535.  Value i goes out at
+     LEAD_US + i * period after the sync rising edge and is
+     strobed half a period later, the sync falls after the
+     last period.  The schedule is kept against the timer
+     rather than delays, so the endpoint can measure its
+     latency from the sync edge.
+
+     Send R<hz> over serial to change the rate.  After each
+     frame one CSV line is printed:
+
+              frame,rate_hz,samples,late
+
+     late is how many strobes missed their slot because the
+     rate is faster than this end can drive.
+
  *********************************************************/
+#include <hardware/timer.h>
+
+#define SYNC_PIN     9
+#define STROBE_PIN   10
+#define SLOW_PIN     11
+
+#define DATA_MASK    0x0007F1FF
+#define SYNC_MASK    (1UL << SYNC_PIN)
+#define STROBE_MASK  (1UL << STROBE_PIN)
+
+#define LEAD_US      1000
+#define FRAME_LENGTH 65536UL
+#define MAX_RATE     250000UL
+
+static uint32_t rateHz = 20000;
+static uint32_t frame = 0;
+
+// Bits 0-8 sit on GP0-GP8, bits 9-15 skip GP9-GP11 and land on GP12-GP18.
+static inline uint32_t pinsFor(uint32_t value)
+{
+  return (value & 0x01FF) | ((value & 0xFE00) << 3);
+}
+
+// Spins until dueNs after start, false if that time had already passed.
+static inline bool waitUntil(uint32_t start, uint64_t dueNs)
+{
+  uint32_t due = start + (uint32_t)(dueNs / 1000);
+  if ((int32_t)(time_us_32() - due) > 0)
+    return false;
+  while ((int32_t)(time_us_32() - due) < 0) {}
+  return true;
+}
+
+static void pollCommands()
+{
+  while (Serial.available() > 0)
+  {
+    if (Serial.read() != 'R')
+      continue;
+
+    long hz = Serial.parseInt();
+    if (hz > 0)
+      rateHz = (uint32_t)hz > MAX_RATE ? MAX_RATE : (uint32_t)hz;
+    Serial.print("# rate_hz,");
+    Serial.println(rateHz);
+  }
+}
+
 void setup()
 {
   for (int i = 0; i < 19; ++i)
   {
-	if (i != 11)
+	if (i != SLOW_PIN)
 	{
 		pinMode(i, OUTPUT);
 		digitalWrite(i, LOW);
 	}
   }
 
-  pinMode(11, INPUT_PULLUP);
+  pinMode(SLOW_PIN, INPUT_PULLUP);
   pinMode(19, INPUT_PULLUP);
   pinMode(20, INPUT_PULLUP);
   pinMode(26, INPUT_PULLUP);
-  pinMode(27, INPUT_PULLUP);  
+  pinMode(27, INPUT_PULLUP);
 
   pinMode(28, OUTPUT);
   digitalWrite(28, LOW);
-  
+
   pinMode(21, OUTPUT);
   pinMode(22, OUTPUT);
   digitalWrite(21, HIGH);
   digitalWrite(22, LOW);
-  
+
   Serial.begin(115200);
-}
 
-bool slowMode = false;
+  if (digitalRead(SLOW_PIN) == LOW)
+    rateHz = 500;
+
+  Serial.println("frame,rate_hz,samples,late");
+}
 
 void loop()
 {
-  int r = 0;
-  while (true)
+  pollCommands();
+
+  uint32_t periodNs = 1000000000UL / rateHz;
+  uint32_t late = 0;
+
+  noInterrupts();
+  gpio_put_masked(DATA_MASK | STROBE_MASK, 0);
+  uint32_t start = time_us_32();
+  gpio_put(SYNC_PIN, 1);
+
+  uint64_t dueNs = (uint64_t)LEAD_US * 1000;
+  for (uint32_t i = 0; i < FRAME_LENGTH; ++i)
   {
-  	if (digitalRead(11) == LOW)
-  		slowMode = true;
-
-    digitalWrite(9, HIGH);
-    delay(1);
-    
-    for (int i = 0; i < 65536; ++i)
-    {
-      Serial.print("Sending ");
-      Serial.print(i);
-      Serial.println(".");
-
-      digitalWrite(18, (i & 0b1000000000000000) != 0 ? HIGH : LOW);
-      digitalWrite(17, (i & 0b0100000000000000) != 0 ? HIGH : LOW);
-      digitalWrite(16, (i & 0b0010000000000000) != 0 ? HIGH : LOW);
-      digitalWrite(15, (i & 0b0001000000000000) != 0 ? HIGH : LOW);
-      digitalWrite(14, (i & 0b0000100000000000) != 0 ? HIGH : LOW);
-      digitalWrite(13, (i & 0b0000010000000000) != 0 ? HIGH : LOW);
-      digitalWrite(12, (i & 0b0000001000000000) != 0 ? HIGH : LOW);
-      digitalWrite(8,  (i & 0b0000000100000000) != 0 ? HIGH : LOW);
-      digitalWrite(7,  (i & 0b0000000010000000) != 0 ? HIGH : LOW);
-      digitalWrite(6,  (i & 0b0000000001000000) != 0 ? HIGH : LOW);
-      digitalWrite(5,  (i & 0b0000000000100000) != 0 ? HIGH : LOW);
-      digitalWrite(4,  (i & 0b0000000000010000) != 0 ? HIGH : LOW);
-      digitalWrite(3,  (i & 0b0000000000001000) != 0 ? HIGH : LOW);
-      digitalWrite(2,  (i & 0b0000000000000100) != 0 ? HIGH : LOW);
-      digitalWrite(1,  (i & 0b0000000000000010) != 0 ? HIGH : LOW);
-      digitalWrite(0,  (i & 0b0000000000000001) != 0 ? HIGH : LOW);
-
-      digitalWrite(10, HIGH);
-      if (!slowMode)
-        delayMicroseconds(25);
-      else
-        delay(1);
-      
-      digitalWrite(10, LOW);
-      if (!slowMode)
-        delayMicroseconds(25);
-      else
-        delay(1);
-    }
-    digitalWrite(9, LOW);
-    delay(1);
-
-    digitalWrite(22, HIGH);
-    digitalWrite(21, LOW);
+    // The first value sits out the lead in, the rest replace the
+    // previous one as its strobe falls.
+    if (i != 0)
+      gpio_put_masked(DATA_MASK | STROBE_MASK, pinsFor(i));
+
+    if (!waitUntil(start, dueNs + periodNs / 2))
+      ++late;
+    gpio_put(STROBE_PIN, 1);
+
+    dueNs += periodNs;
+    waitUntil(start, dueNs);
   }
 
+  gpio_put_masked(SYNC_MASK | STROBE_MASK, 0);
+  interrupts();
+
+  Serial.print(frame++);
+  Serial.print(",");
+  Serial.print(rateHz);
+  Serial.print(",");
+  Serial.print(FRAME_LENGTH);
+  Serial.print(",");
+  Serial.println(late);
+
+  digitalWrite(22, HIGH);
+  digitalWrite(21, LOW);
+  delay(1);
 }